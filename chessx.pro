@@ -24,6 +24,8 @@ greaterThan(QT_MAJOR_VERSION, 4) {
   # CONFIG += lc0
   DEFINES += USE_C11
   CONFIG += scid
+  # Probing local Syzygy tablebases uses GPLv3 code, builds including it are GPLv3 or later, see README.md
+  # CONFIG += syzygy
 }
 
 greaterThan(QT_MAJOR_VERSION, 5) {
@@ -41,6 +43,13 @@ sound {
   QT += multimedia
 }
 
+syzygy {
+  DEFINES += USE_SYZYGY
+  HEADERS += src/database/syzygyencoding.h \
+    src/database/syzygytablebase.h
+  SOURCES += src/database/syzygytablebase.cpp
+}
+
 DEFINES += QUAZIP_STATIC
 DEFINES += QT_NO_CAST_TO_ASCII
 DEFINES *= QT_USE_QSTRINGBUILDER
@@ -177,6 +186,8 @@ HEADERS += src/database/board.h \
   src/database/bitfind.h \
   src/database/circularbuffer.h \
   src/database/clipboarddatabase.h \
+  src/database/compressedfile.h \
+  src/database/crosstable.h \
   src/database/ctg.h \
   src/database/ctgbookwriter.h \
   src/database/ctgdatabase.h \
@@ -186,6 +197,7 @@ HEADERS += src/database/board.h \
   src/database/datesearch.h \
   src/database/downloadmanager.h \
   src/database/duplicatesearch.h \
+  src/database/ecoclassifier.h \
   src/database/ecoinfo.h \
   src/database/ecopositions.h \
   src/database/editaction.h \
@@ -204,6 +216,7 @@ HEADERS += src/database/board.h \
   src/database/filtersearch.h \
   src/database/gamecursor.h \
   src/database/gameid.h \
+  src/database/gamestatistics.h \
   src/database/gameundocommand.h \
   src/database/gamex.h \
   src/database/historylist.h \
@@ -238,9 +251,11 @@ HEADERS += src/database/board.h \
   src/database/spellchecker.h \
   src/database/square.h \
   src/database/streamdatabase.h \
+  src/database/stringdictionary.h \
   src/database/tablebase.h \
   src/database/tags.h \
   src/database/tagsearch.h \
+  src/database/tagvaluelistmodel.h \
   src/database/telnetclient.h \
   src/database/threadedguess.h \
   src/database/uciengine.h \
@@ -291,6 +306,7 @@ HEADERS += src/database/board.h \
   src/gui/colorlist.h \
   src/gui/databaselist.h \
   src/gui/databaselistmodel.h \
+  src/gui/diagramrenderer.h \
   src/gui/digitalclock.h \
   src/gui/dockwidgetex.h \
   src/gui/ecolistwidget.h \
@@ -361,6 +377,8 @@ SOURCES += \
   src/database/bitboard.cpp \
   src/database/board.cpp \
   src/database/clipboarddatabase.cpp \
+  src/database/compressedfile.cpp \
+  src/database/crosstable.cpp \
   src/database/ctgbookwriter.cpp \
   src/database/ctgdatabase.cpp \
   src/database/database.cpp \
@@ -369,6 +387,7 @@ SOURCES += \
   src/database/datesearch.cpp \
   src/database/downloadmanager.cpp \
   src/database/duplicatesearch.cpp \
+  src/database/ecoclassifier.cpp \
   src/database/ecoinfo.cpp \
   src/database/ecopositions.cpp \
   src/database/editaction.cpp \
@@ -384,6 +403,7 @@ SOURCES += \
   src/database/filtermodel.cpp \
   src/database/filtersearch.cpp \
   src/database/gamecursor.cpp \
+  src/database/gamestatistics.cpp \
   src/database/gamex.cpp \
   src/database/historylist.cpp \
   src/database/index.cpp \
@@ -415,9 +435,11 @@ SOURCES += \
   src/database/settings.cpp \
   src/database/spellchecker.cpp \
   src/database/streamdatabase.cpp \
+  src/database/stringdictionary.cpp \
   src/database/tablebase.cpp \
   src/database/tags.cpp \
   src/database/tagsearch.cpp \
+  src/database/tagvaluelistmodel.cpp \
   src/database/telnetclient.cpp \
   src/database/threadedguess.cpp \
   src/database/uciengine.cpp \
@@ -459,6 +481,7 @@ SOURCES += \
   src/gui/colorlist.cpp \
   src/gui/databaselist.cpp \
   src/gui/databaselistmodel.cpp \
+  src/gui/diagramrenderer.cpp \
   src/gui/digitalclock.cpp \
   src/gui/dockwidgetex.cpp \
   src/gui/ecolistwidget.cpp \
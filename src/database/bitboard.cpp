@@ -1770,11 +1770,13 @@ Move::List BitBoard::generateMoves() const
 
 int BitBoard::score() const
 {
+    // Count the pieces of each type and color instead of looking at all squares
+    const quint64 pieces[] = { m_kings, m_queens, m_rooks, m_bishops, m_knights, m_pawns };
     int sum = 0;
-    Square s;
-    for (s=a1;s<=h8;s++)
+    for (int i = 0; i < 6; ++i)
     {
-        sum += centiPawnValue(pieceAt(s));
+        sum += centiPawnValue(Piece(WhiteKing + i)) * int(countSetBits(pieces[i] & m_occupied_co[White]));
+        sum += centiPawnValue(Piece(BlackKing + i)) * int(countSetBits(pieces[i] & m_occupied_co[Black]));
     }
     return sum;
 }
@@ -1843,7 +1845,11 @@ Move BitBoard::createCastlingQ() const
 Move BitBoard::parseMove(const QString& algebraic) const
 {
     const QByteArray& bs(algebraic.toLatin1());
-    const char *san = bs.constData();
+    return parseMoveLatin1(bs.constData());
+}
+
+Move BitBoard::parseMoveLatin1(const char* san) const
+{
     const char* s = san;
     char c = *(s++);
     quint64 match;
@@ -1854,7 +1860,7 @@ Move BitBoard::parseMove(const QString& algebraic) const
     Move move;
     unsigned int type;
 
-    if (algebraic=="none")
+    if (strcmp(san, "none") == 0)
         return move;
 
     // Castling
@@ -85,6 +85,8 @@ public:
 
     /** parse SAN or LAN representation of move, and return proper Move() object */
     Move parseMove(const QString& algebraic) const;
+    /** parse SAN or LAN representation of move given as a NUL terminated Latin-1 string */
+    Move parseMoveLatin1(const char* san) const;
     /** Return a proper Move() object given only a from-to move specification */
     Move prepareMove(const chessx::Square& from, const chessx::Square& to) const;
 
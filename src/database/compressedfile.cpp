@@ -0,0 +1,651 @@
+#include "compressedfile.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include "quazip.h"
+#include "quazipfileinfo.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+/** Size of the deflate window */
+const int WindowSize = 32768;
+/** Size of the compressed input buffer */
+const int InputSize = 16384;
+/** Minimal distance of access points in the uncompressed data */
+const qint64 AccessPointSpan = 1024 * 1024;
+
+/** Split @p name into archive and member name, @return false if it is no archive member */
+static bool splitMemberName(const QString& name, QString& archive, QString& member)
+{
+    int n = name.indexOf(".zip#", 0, Qt::CaseInsensitive);
+    if (n < 0)
+    {
+        return false;
+    }
+    archive = name.left(n + 4);
+    member = name.mid(n + 5);
+    return !member.isEmpty() && QFileInfo(archive).isFile();
+}
+
+CompressedFile::CompressedFile(const QString& name, QObject* parent) :
+    QIODevice(parent),
+    m_name(name),
+    m_dataStart(0),
+    m_dataSize(0),
+    m_stored(false),
+    m_gzip(false),
+    m_size(0),
+    m_lastMemberSize(0),
+    m_streamInit(false),
+    m_raw(false),
+    m_eof(false),
+    m_inPos(0),
+    m_have(0),
+    m_next(0),
+    m_outPos(0),
+    m_writing(false),
+    m_blockOpen(false)
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+}
+
+CompressedFile::~CompressedFile()
+{
+    close();
+}
+
+QString CompressedFile::memberName(const QString& archive, const QString& member)
+{
+    return archive + '#' + member;
+}
+
+bool CompressedFile::isArchiveMember(const QString& name)
+{
+    QString archive, member;
+    return splitMemberName(name, archive, member);
+}
+
+bool CompressedFile::isCompressed(const QString& name)
+{
+    return isArchiveMember(name) || (QFileInfo(name).suffix().compare("gz", Qt::CaseInsensitive) == 0);
+}
+
+QString CompressedFile::containerName(const QString& name)
+{
+    QString archive, member;
+    return splitMemberName(name, archive, member) ? archive : name;
+}
+
+bool CompressedFile::open(OpenMode mode)
+{
+    if (isOpen())
+    {
+        return false;
+    }
+    if (mode & QIODevice::WriteOnly)
+    {
+        return openForWriting(m_name) && QIODevice::open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+    }
+    QString archive, member;
+    bool ok = splitMemberName(m_name, archive, member) ?
+              openArchiveMember(archive, member) : openGzip(m_name);
+    if (!ok || !restart())
+    {
+        m_archive.close();
+        return false;
+    }
+    // The window is the buffer, so the device is opened unbuffered
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+bool CompressedFile::openArchiveMember(const QString& archive, const QString& member)
+{
+    QuaZip zip(archive);
+    if (!zip.open(QuaZip::mdUnzip) || !zip.setCurrentFile(member))
+    {
+        return false;
+    }
+    QuaZipFileInfo info;
+    if (!zip.getCurrentFileInfo(&info) || (info.flags & 1))
+    {
+        // Encrypted members cannot be streamed
+        return false;
+    }
+    int method = 0;
+    int level = 0;
+    if (unzOpenCurrentFile2(zip.getUnzFile(), &method, &level, 1) != UNZ_OK)
+    {
+        return false;
+    }
+    m_dataStart = unzGetCurrentFileZStreamPos(zip.getUnzFile());
+    unzCloseCurrentFile(zip.getUnzFile());
+    zip.close();
+
+    m_dataSize = info.compressedSize;
+    m_size = info.uncompressedSize;
+    m_stored = (method == 0);
+    m_gzip = false;
+    if (!m_dataStart || (method != 0 && method != Z_DEFLATED))
+    {
+        return false;
+    }
+    m_archive.setFileName(archive);
+    return m_archive.open(QIODevice::ReadOnly);
+}
+
+bool CompressedFile::openGzip(const QString& name)
+{
+    m_archive.setFileName(name);
+    if (!m_archive.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    m_dataStart = 0;
+    m_dataSize = m_archive.size();
+    m_stored = false;
+    m_gzip = true;
+
+    // The trailer holds the size of the last member modulo 4GB. The size of the
+    // file is the offset of that member plus this, it is corrected when the end is reached.
+    uchar trailer[4];
+    if (m_dataSize < 18 || !m_archive.seek(m_dataSize - 4) || m_archive.read((char*)trailer, 4) != 4)
+    {
+        return false;
+    }
+    m_lastMemberSize = qFromLittleEndian<quint32>(trailer);
+    m_size = m_lastMemberSize;
+    return true;
+}
+
+bool CompressedFile::openForWriting(const QString& name)
+{
+    m_archive.setFileName(name);
+    if (!m_archive.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    memset(&m_stream, 0, sizeof(m_stream));
+    if (deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        m_archive.close();
+        return false;
+    }
+    m_streamInit = true;
+    m_writing = true;
+    m_blockOpen = false;
+    m_gzip = true;
+    m_in.resize(InputSize);
+    m_outPos = 0;
+    m_size = 0;
+    m_blocks.clear();
+    return true;
+}
+
+void CompressedFile::close()
+{
+    // Streams on the device flush their data on aboutToClose()
+    QIODevice::close();
+    if (m_writing)
+    {
+        if (m_blocks.isEmpty())
+        {
+            // Even an empty file gets a valid gzip member
+            m_blocks.append({ 0, 0 });
+            m_blockOpen = true;
+        }
+        endBlock();
+        deflateEnd(&m_stream);
+        m_streamInit = false;
+        m_writing = false;
+    }
+    else if (m_streamInit)
+    {
+        inflateEnd(&m_stream);
+        m_streamInit = false;
+    }
+    m_archive.close();
+    m_points.clear();
+}
+
+QVector<CompressedBlock> CompressedFile::blocks() const
+{
+    return m_blocks;
+}
+
+void CompressedFile::setBlocks(const QVector<CompressedBlock>& blocks)
+{
+    if (m_gzip && !m_writing)
+    {
+        m_blocks = blocks;
+        if (!m_blocks.isEmpty() && !m_eof)
+        {
+            m_size = std::max(m_size, m_blocks.last().out + m_lastMemberSize);
+        }
+    }
+}
+
+qint64 CompressedFile::compressedSize() const
+{
+    return m_dataSize;
+}
+
+qint64 CompressedFile::compressedPos() const
+{
+    if (m_stored)
+    {
+        return m_outPos;
+    }
+    return m_writing ? m_archive.pos() : m_inPos - m_stream.avail_in;
+}
+
+void CompressedFile::endBlock()
+{
+    if (!m_writing || !m_blockOpen)
+    {
+        return;
+    }
+    m_stream.next_in = nullptr;
+    m_stream.avail_in = 0;
+    deflateInput(Z_FINISH);
+    // The next data starts a new gzip member
+    deflateReset(&m_stream);
+    m_blockOpen = false;
+}
+
+bool CompressedFile::deflateInput(int flush)
+{
+    int ret;
+    do
+    {
+        m_stream.next_out = (Bytef*)m_in.data();
+        m_stream.avail_out = uInt(m_in.size());
+        ret = deflate(&m_stream, flush);
+        qint64 n = m_in.size() - m_stream.avail_out;
+        if (ret == Z_STREAM_ERROR || (n && m_archive.write(m_in.constData(), n) != n))
+        {
+            return false;
+        }
+    }
+    while (m_stream.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+    return true;
+}
+
+bool CompressedFile::isSequential() const
+{
+    return false;
+}
+
+qint64 CompressedFile::size() const
+{
+    return m_size;
+}
+
+bool CompressedFile::atEnd() const
+{
+    if (!isOpen())
+    {
+        return true;
+    }
+    if (m_next == m_have && !m_eof)
+    {
+        // Only decoding tells whether more data follows, what is decoded stays available
+        const_cast<CompressedFile*>(this)->fill();
+    }
+    return m_next == m_have && m_eof;
+}
+
+qint64 CompressedFile::bytesAvailable() const
+{
+    return atEnd() ? 0 : std::max<qint64>(m_have - m_next, m_size - m_outPos);
+}
+
+bool CompressedFile::seek(qint64 pos)
+{
+    if (!isOpen() || m_writing || pos < 0 || !position(pos))
+    {
+        return false;
+    }
+    return QIODevice::seek(pos);
+}
+
+qint64 CompressedFile::readData(char* data, qint64 maxSize)
+{
+    if (m_writing)
+    {
+        return -1;
+    }
+    qint64 done = 0;
+    while (done < maxSize)
+    {
+        if (m_next == m_have && !fill())
+        {
+            break;
+        }
+        int n = int(std::min<qint64>(m_have - m_next, maxSize - done));
+        memcpy(data + done, m_window.constData() + m_next, n);
+        m_next += n;
+        m_outPos += n;
+        done += n;
+    }
+    return done;
+}
+
+qint64 CompressedFile::readLineData(char* data, qint64 maxSize)
+{
+    if (m_writing)
+    {
+        return -1;
+    }
+    qint64 done = 0;
+    while (done < maxSize)
+    {
+        if (m_next == m_have && !fill())
+        {
+            break;
+        }
+        int n = int(std::min<qint64>(m_have - m_next, maxSize - done));
+        const char* start = m_window.constData() + m_next;
+        const char* eol = static_cast<const char*>(memchr(start, '\n', n));
+        if (eol)
+        {
+            n = int(eol - start) + 1;
+        }
+        memcpy(data + done, start, n);
+        m_next += n;
+        m_outPos += n;
+        done += n;
+        if (eol)
+        {
+            break;
+        }
+    }
+    return done ? done : -1;
+}
+
+qint64 CompressedFile::writeData(const char* data, qint64 maxSize)
+{
+    if (!m_writing)
+    {
+        return -1;
+    }
+    if (!m_blockOpen)
+    {
+        m_blocks.append({ m_archive.pos(), m_outPos });
+        m_blockOpen = true;
+    }
+    qint64 done = 0;
+    while (done < maxSize)
+    {
+        qint64 n = std::min<qint64>(maxSize - done, 1 << 30);
+        m_stream.next_in = (Bytef*)const_cast<char*>(data + done);
+        m_stream.avail_in = uInt(n);
+        if (!deflateInput(Z_NO_FLUSH))
+        {
+            return done ? done : -1;
+        }
+        done += n;
+        m_outPos += n;
+    }
+    m_size = m_outPos;
+    return done;
+}
+
+bool CompressedFile::restart()
+{
+    m_window.fill(0, WindowSize);
+    m_in.resize(InputSize);
+    m_inPos = 0;
+    m_have = 0;
+    m_next = 0;
+    m_outPos = 0;
+    m_eof = false;
+    if (m_stored)
+    {
+        return true;
+    }
+
+    if (m_streamInit)
+    {
+        inflateEnd(&m_stream);
+    }
+    memset(&m_stream, 0, sizeof(m_stream));
+    // Zip members are raw deflate streams, gzip files have a header
+    m_raw = !m_gzip;
+    m_streamInit = (inflateInit2(&m_stream, m_raw ? -MAX_WBITS : MAX_WBITS + 16) == Z_OK);
+    return m_streamInit;
+}
+
+bool CompressedFile::restore(const AccessPoint& point)
+{
+    if (!restart() || inflateReset2(&m_stream, -MAX_WBITS) != Z_OK)
+    {
+        return false;
+    }
+    m_raw = true;
+    m_inPos = point.in;
+    if (point.bits)
+    {
+        char c;
+        if (!m_archive.seek(m_dataStart + point.in - 1) || !m_archive.getChar(&c))
+        {
+            return false;
+        }
+        inflatePrime(&m_stream, point.bits, uchar(c) >> (8 - point.bits));
+    }
+    inflateSetDictionary(&m_stream, (const Bytef*)point.window.constData(), WindowSize);
+    memcpy(m_window.data(), point.window.constData(), WindowSize);
+    m_outPos = point.out;
+    return true;
+}
+
+bool CompressedFile::restore(const CompressedBlock& block)
+{
+    if (!restart())
+    {
+        return false;
+    }
+    // A block is a complete gzip member, it does not depend on earlier data
+    m_inPos = block.in;
+    m_outPos = block.out;
+    return true;
+}
+
+bool CompressedFile::position(qint64 pos)
+{
+    if (m_stored)
+    {
+        m_have = 0;
+        m_next = 0;
+        m_outPos = pos;
+        m_inPos = pos;
+        m_eof = (pos >= m_dataSize);
+        return pos <= m_dataSize;
+    }
+
+    // Continue from the nearest block or access point before pos, if it is ahead
+    auto point = std::upper_bound(m_points.cbegin(), m_points.cend(), pos,
+                                  [](qint64 p, const AccessPoint& ap) { return p < ap.out; });
+    auto block = std::upper_bound(m_blocks.cbegin(), m_blocks.cend(), pos,
+                                  [](qint64 p, const CompressedBlock& b) { return p < b.out; });
+    qint64 pointOut = (point != m_points.cbegin()) ? (point - 1)->out : -1;
+    qint64 blockOut = (block != m_blocks.cbegin()) ? (block - 1)->out : -1;
+    qint64 start = std::max(pointOut, blockOut);
+    if (start >= 0 && (pos < m_outPos || start > m_outPos))
+    {
+        if (!((blockOut >= pointOut) ? restore(*(block - 1)) : restore(*(point - 1))))
+        {
+            return false;
+        }
+    }
+    else if (pos < m_outPos && !restart())
+    {
+        return false;
+    }
+
+    // Decode forward, adding access points on the way
+    while (m_outPos < pos)
+    {
+        if (m_next == m_have && !fill())
+        {
+            return false;
+        }
+        int n = int(std::min<qint64>(m_have - m_next, pos - m_outPos));
+        m_next += n;
+        m_outPos += n;
+    }
+    return true;
+}
+
+bool CompressedFile::readInput()
+{
+    qint64 n = std::min<qint64>(InputSize, m_dataSize - m_inPos);
+    if (n <= 0)
+    {
+        return false;
+    }
+    if (m_archive.pos() != m_dataStart + m_inPos && !m_archive.seek(m_dataStart + m_inPos))
+    {
+        return false;
+    }
+    n = m_archive.read(m_in.data(), n);
+    if (n <= 0)
+    {
+        return false;
+    }
+    m_inPos += n;
+    m_stream.next_in = (Bytef*)m_in.data();
+    m_stream.avail_in = uInt(n);
+    return true;
+}
+
+bool CompressedFile::fill()
+{
+    while (!m_eof)
+    {
+        if (m_have == WindowSize)
+        {
+            // Everything is delivered, start over at the beginning of the window
+            m_have = 0;
+            m_next = 0;
+        }
+
+        if (m_stored)
+        {
+            qint64 n = std::min<qint64>(WindowSize - m_have, m_dataSize - m_inPos);
+            if (n > 0 && (m_archive.pos() == m_dataStart + m_inPos || m_archive.seek(m_dataStart + m_inPos)))
+            {
+                n = m_archive.read(m_window.data() + m_have, n);
+            }
+            if (n <= 0)
+            {
+                m_eof = true;
+                break;
+            }
+            m_inPos += n;
+            m_have += int(n);
+            return true;
+        }
+
+        if (!m_stream.avail_in && !readInput())
+        {
+            // Truncated data
+            m_eof = true;
+            break;
+        }
+        m_stream.next_out = (Bytef*)m_window.data() + m_have;
+        m_stream.avail_out = uInt(WindowSize - m_have);
+        int ret = inflate(&m_stream, Z_BLOCK);
+        int produced = WindowSize - m_have - int(m_stream.avail_out);
+        m_have += produced;
+
+        if (ret == Z_STREAM_END)
+        {
+            if (m_gzip && m_raw)
+            {
+                // Skip the trailer of the member, zlib only does so in gzip mode
+                int skip = 8;
+                while (skip && (m_stream.avail_in || readInput()))
+                {
+                    int n = std::min<int>(skip, int(m_stream.avail_in));
+                    m_stream.next_in += n;
+                    m_stream.avail_in -= n;
+                    skip -= n;
+                }
+            }
+            // A gzip file may consist of several members
+            if (m_gzip && (m_stream.avail_in || readInput()))
+            {
+                inflateReset2(&m_stream, MAX_WBITS + 16);
+                m_raw = false;
+                addBlock();
+            }
+            else
+            {
+                m_eof = true;
+            }
+        }
+        else if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            qDebug() << "Decompression error in" << m_name << ret;
+            m_eof = true;
+        }
+        else if ((m_stream.data_type & 128) && !(m_stream.data_type & 64))
+        {
+            addAccessPoint();
+        }
+
+        if (produced)
+        {
+            return true;
+        }
+    }
+    // Now the exact size is known
+    m_size = m_outPos + (m_have - m_next);
+    return false;
+}
+
+void CompressedFile::addAccessPoint()
+{
+    qint64 out = m_outPos + (m_have - m_next);
+    // Points are only added at the decoded frontier, in increasing order
+    qint64 last = m_points.isEmpty() ? 0 : m_points.last().out;
+    if (!m_blocks.isEmpty())
+    {
+        last = std::max(last, m_blocks.last().out);
+    }
+    if (out - last < AccessPointSpan)
+    {
+        return;
+    }
+    AccessPoint point;
+    point.out = out;
+    point.in = m_inPos - m_stream.avail_in;
+    point.bits = m_stream.data_type & 7;
+    point.window.resize(WindowSize);
+    memcpy(point.window.data(), m_window.constData() + m_have, WindowSize - m_have);
+    memcpy(point.window.data() + WindowSize - m_have, m_window.constData(), m_have);
+    m_points.append(point);
+}
+
+void CompressedFile::addBlock()
+{
+    CompressedBlock block;
+    block.in = m_inPos - m_stream.avail_in;
+    block.out = m_outPos + (m_have - m_next);
+    if (m_blocks.isEmpty() || block.out > m_blocks.last().out)
+    {
+        m_blocks.append(block);
+        if (!m_eof)
+        {
+            m_size = std::max(m_size, block.out + m_lastMemberSize);
+        }
+    }
+}
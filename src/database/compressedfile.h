@@ -0,0 +1,164 @@
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+#include <zlib.h>
+
+/** Start of an independently compressed block, a gzip member, of a compressed file */
+struct CompressedBlock
+{
+    /** Offset of the block in the compressed file */
+    qint64 in;
+    /** Offset of the block's data in the uncompressed data */
+    qint64 out;
+};
+
+inline QDataStream& operator<<(QDataStream& out, const CompressedBlock& block)
+{
+    return out << block.in << block.out;
+}
+
+inline QDataStream& operator>>(QDataStream& in, CompressedBlock& block)
+{
+    return in >> block.in >> block.out;
+}
+
+/** @ingroup Database
+ * A seekable device decompressing a PGN file while it is read.
+ *
+ * The source is either a gzip file or a member of a zip archive, which is
+ * named by appending '#' and the member name to the archive name. Nothing is
+ * extracted to disk. While decoding, the compressed stream position and the
+ * last 32K of output are remembered roughly every megabyte at deflate block
+ * boundaries, so that a seek only decodes from the nearest such access point.
+ * Access points are built on demand, after reopening the first seek to a far
+ * position decodes up to there once.
+ *
+ * A gzip file may consist of several members. Their offsets are kept as
+ * blocks, which can be stored with the index and restored by setBlocks().
+ * A seek to a position of a known block decodes from the start of the block
+ * only. Opened for writing, a gzip file is written whose blocks are ended by
+ * endBlock(), so that each block can hold a fixed number of games.
+ */
+class CompressedFile : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit CompressedFile(const QString& name, QObject* parent = nullptr);
+    ~CompressedFile();
+
+    /** Open for reading, or for writing a new gzip file with QIODevice::WriteOnly */
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override;
+    /** @return the uncompressed size, exact once the end was decoded or the blocks are known, otherwise a lower bound */
+    qint64 size() const override;
+    bool seek(qint64 pos) override;
+    bool atEnd() const override;
+    qint64 bytesAvailable() const override;
+
+    /** @return the blocks of a gzip file, as far as they are known */
+    QVector<CompressedBlock> blocks() const;
+    /** Use @p blocks found in an earlier pass over the same file */
+    void setBlocks(const QVector<CompressedBlock>& blocks);
+    /** @return the size of the compressed data */
+    qint64 compressedSize() const;
+    /** @return the offset in the compressed data up to which the input is decoded */
+    qint64 compressedPos() const;
+
+    /** When writing, end the current block, the data written so far is decodable on its own */
+    void endBlock();
+
+    /** @return the name of the database stored in @p member of @p archive */
+    static QString memberName(const QString& archive, const QString& member);
+    /** @return true if @p name refers to a member of a zip archive */
+    static bool isArchiveMember(const QString& name);
+    /** @return true if @p name is read through a CompressedFile */
+    static bool isCompressed(const QString& name);
+    /** @return the file on disk holding @p name, @p name itself if it is not an archive member */
+    static QString containerName(const QString& name);
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 readLineData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    struct AccessPoint
+    {
+        /** Offset in the uncompressed data */
+        qint64 out;
+        /** Offset of the first complete byte in the compressed data */
+        qint64 in;
+        /** Number of bits of the byte before @p in which belong to the next block */
+        int bits;
+        /** The 32K of uncompressed data before @p out */
+        QByteArray window;
+    };
+
+    bool openArchiveMember(const QString& archive, const QString& member);
+    bool openGzip(const QString& name);
+    bool openForWriting(const QString& name);
+    /** Write the compressed output of m_stream, until zlib has no more for @p flush */
+    bool deflateInput(int flush);
+    /** Restart decoding at the beginning of the stream */
+    bool restart();
+    /** Restart decoding at @p point */
+    bool restore(const AccessPoint& point);
+    /** Restart decoding at the start of @p block */
+    bool restore(const CompressedBlock& block);
+    /** Move the decoder to uncompressed offset @p pos */
+    bool position(qint64 pos);
+    /** Decode more data into the window, @return false at the end of the data */
+    bool fill();
+    /** Read more compressed data, @return false if there is none left */
+    bool readInput();
+    void addAccessPoint();
+    /** Record the start of a gzip member at the current position */
+    void addBlock();
+
+private:
+    QString m_name;
+    QFile m_archive;
+    /** Start and length of the compressed data in m_archive */
+    qint64 m_dataStart;
+    qint64 m_dataSize;
+    /** The data is stored without compression */
+    bool m_stored;
+    bool m_gzip;
+    qint64 m_size;
+    /** Uncompressed size of the last gzip member, from its trailer */
+    qint64 m_lastMemberSize;
+
+    z_stream m_stream;
+    bool m_streamInit;
+    /** Decoding a raw deflate stream, after restoring an access point of a gzip file */
+    bool m_raw;
+    bool m_eof;
+    QByteArray m_in;
+    /** Offset of the next compressed byte to read from m_archive */
+    qint64 m_inPos;
+
+    /** Circular buffer of the last uncompressed output */
+    QByteArray m_window;
+    /** Write position in m_window, and the next byte to deliver */
+    int m_have;
+    int m_next;
+    /** Uncompressed offset of the byte at m_next */
+    qint64 m_outPos;
+
+    QVector<AccessPoint> m_points;
+    QVector<CompressedBlock> m_blocks;
+
+    bool m_writing;
+    /** Data was written since the last endBlock() */
+    bool m_blockOpen;
+};
+
+#endif // COMPRESSEDFILE_H
@@ -0,0 +1,317 @@
+#include "crosstable.h"
+#include "gamestatistics.h"
+#include "index.h"
+
+#include <QFutureSynchronizer>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+/** @return the rating difference expected for the score @p score, limited to 800 points */
+static int ratingDifference(double score)
+{
+    if (score <= 0.0)
+    {
+        return -800;
+    }
+    if (score >= 1.0)
+    {
+        return 800;
+    }
+    return qBound(-800, qRound(400.0 * std::log10(score / (1.0 - score))), 800);
+}
+
+Crosstable::Crosstable()
+{
+}
+
+Crosstable::Crosstable(const IndexX* index, const GameStatistics& statistics, const QVector<GameId>& games)
+{
+    QHash<ValueIndex, int> rows;
+    QVector<int> ratingSum;
+    QVector<int> ratingCount;
+    auto row = [&](ValueIndex value)
+    {
+        QHash<ValueIndex, int>::const_iterator it = rows.constFind(value);
+        if (it == rows.constEnd())
+        {
+            Player player;
+            player.value = value;
+            player.games = player.halfPoints = 0;
+            player.buchholz = player.sonnebornBerger = 0;
+            player.rating = player.performance = 0;
+            it = rows.insert(value, m_players.count());
+            m_players.append(player);
+            ratingSum.append(0);
+            ratingCount.append(0);
+        }
+        return *it;
+    };
+
+    for (GameId game : games)
+    {
+        int white = row(statistics.value(GameStatistics::WhitePlayer, game));
+        int black = row(statistics.value(GameStatistics::BlackPlayer, game));
+        if (white == black)
+        {
+            continue;
+        }
+        int halfPoints = statistics.whiteHalfPoints(game);
+        Pairing pairing = { black, White, game, halfPoints };
+        m_players[white].pairings.append(pairing);
+        pairing = { white, Black, game, halfPoints < 0 ? -1 : 2 - halfPoints };
+        m_players[black].pairings.append(pairing);
+        for (int p : { white, black })
+        {
+            const Pairing& last = m_players[p].pairings.last();
+            if (last.halfPoints >= 0)
+            {
+                ++m_players[p].games;
+                m_players[p].halfPoints += last.halfPoints;
+            }
+            if (int rating = statistics.elo(game, last.color))
+            {
+                ratingSum[p] += rating;
+                ++ratingCount[p];
+            }
+        }
+    }
+
+    // The tie-breaks need the points of all players
+    for (int p = 0; p < m_players.count(); ++p)
+    {
+        Player& player = m_players[p];
+        if (ratingCount[p])
+        {
+            player.rating = ratingSum[p] / ratingCount[p];
+        }
+        int opponentRatings = 0;
+        int ratedGames = 0;
+        int ratedHalfPoints = 0;
+        for (const Pairing& pairing : player.pairings)
+        {
+            if (pairing.halfPoints < 0)
+            {
+                continue;
+            }
+            int opponentPoints = m_players[pairing.opponent].halfPoints;
+            player.buchholz += opponentPoints;
+            player.sonnebornBerger += pairing.halfPoints * opponentPoints;
+            if (int rating = statistics.elo(pairing.game, oppositeColor(pairing.color)))
+            {
+                opponentRatings += rating;
+                ++ratedGames;
+                ratedHalfPoints += pairing.halfPoints;
+            }
+        }
+        if (ratedGames)
+        {
+            player.performance = opponentRatings / ratedGames + ratingDifference(ratedHalfPoints / (2.0 * ratedGames));
+        }
+    }
+
+    QVector<QString> names(m_players.count());
+    for (int p = 0; p < m_players.count(); ++p)
+    {
+        names[p] = index->valueName(m_players[p].value);
+    }
+    QVector<int> order(m_players.count());
+    for (int p = 0; p < order.count(); ++p)
+    {
+        order[p] = p;
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b)
+    {
+        const Player& pa = m_players[a];
+        const Player& pb = m_players[b];
+        if (pa.halfPoints != pb.halfPoints)
+        {
+            return pa.halfPoints > pb.halfPoints;
+        }
+        if (pa.sonnebornBerger != pb.sonnebornBerger)
+        {
+            return pa.sonnebornBerger > pb.sonnebornBerger;
+        }
+        if (pa.buchholz != pb.buchholz)
+        {
+            return pa.buchholz > pb.buchholz;
+        }
+        return names[a] < names[b];
+    });
+
+    QVector<int> rank(m_players.count());
+    for (int r = 0; r < order.count(); ++r)
+    {
+        rank[order[r]] = r;
+    }
+    QVector<Player> players;
+    players.reserve(m_players.count());
+    for (int p : order)
+    {
+        players.append(m_players[p]);
+        for (Pairing& pairing : players.last().pairings)
+        {
+            pairing.opponent = rank[pairing.opponent];
+        }
+    }
+    m_players.swap(players);
+}
+
+QString Crosstable::results(int row, int column) const
+{
+    QString s;
+    for (const Pairing& pairing : m_players[row].pairings)
+    {
+        if (pairing.opponent == column)
+        {
+            switch (pairing.halfPoints)
+            {
+            case 2:
+                s += '1';
+                break;
+            case 1:
+                s += QChar(0x00BD);
+                break;
+            case 0:
+                s += '0';
+                break;
+            default:
+                s += '*';
+                break;
+            }
+        }
+    }
+    return s;
+}
+
+QString Crosstable::formatPoints(int halfPoints)
+{
+    if (halfPoints == 1)
+    {
+        return QString(QChar(0x00BD));
+    }
+    QString s = QString::number(halfPoints / 2);
+    if (halfPoints % 2)
+    {
+        s += QChar(0x00BD);
+    }
+    return s;
+}
+
+Crosstables::Crosstables() :
+    m_index(nullptr),
+    m_revision(0),
+    m_built(0)
+{
+}
+
+void Crosstables::update(const IndexX* index, const GameStatistics& statistics)
+{
+    m_built = 0;
+    if (index && index == m_index && statistics.revision() == m_revision)
+    {
+        return;
+    }
+    if (index != m_index)
+    {
+        m_tables.clear();
+    }
+    m_index = index;
+    if (!index)
+    {
+        return;
+    }
+    m_revision = statistics.revision();
+
+    QList<ValueIndex> events = statistics.values(GameStatistics::Event);
+    QVector<Task> tasks(events.count());
+    for (int i = 0; i < events.count(); ++i)
+    {
+        tasks[i].event = events[i];
+        tasks[i].built = false;
+    }
+
+    int maxThreads = std::max(1, QThread::idealThreadCount());
+    int n = tasks.count();
+    int chunk = n / maxThreads + 1;
+
+    QFutureSynchronizer<void> synchronizer;
+    for (int start = 0; start < n; start += chunk)
+    {
+        int end = std::min(start + chunk, n);
+#if QT_VERSION < 0x060000
+        QFuture<void> future = QtConcurrent::run(this, &Crosstables::updateEvents, &statistics, tasks.data() + start, tasks.data() + end);
+#else
+        QFuture<void> future = QtConcurrent::run(&Crosstables::updateEvents, this, &statistics, tasks.data() + start, tasks.data() + end);
+#endif
+        synchronizer.addFuture(future);
+    }
+    synchronizer.waitForFinished();
+
+    // Tables of events without games any more are dropped
+    QHash<ValueIndex, Entry> tables;
+    tables.reserve(tasks.count());
+    for (const Task& task : tasks)
+    {
+        if (task.built)
+        {
+            tables.insert(task.event, task.entry);
+            ++m_built;
+        }
+        else
+        {
+            tables.insert(task.event, m_tables.value(task.event));
+        }
+    }
+    m_tables.swap(tables);
+}
+
+void Crosstables::updateEvents(const GameStatistics* statistics, Task* begin, Task* end) const
+{
+    for (Task* task = begin; task != end; ++task)
+    {
+        const QVector<GameId>& games = statistics->games(GameStatistics::Event, task->event);
+        quint64 hash = signature(*statistics, games);
+        QHash<ValueIndex, Entry>::const_iterator it = m_tables.constFind(task->event);
+        if (it == m_tables.constEnd() || it->signature != hash)
+        {
+            task->entry.signature = hash;
+            task->entry.table = Crosstable(m_index, *statistics, games);
+            task->built = true;
+        }
+    }
+}
+
+quint64 Crosstables::signature(const GameStatistics& statistics, const QVector<GameId>& games)
+{
+    // FNV-1a over the fields the table is built from
+    quint64 hash = 14695981039346656037ULL;
+    auto add = [&hash](quint64 value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    };
+    for (GameId game : games)
+    {
+        add(game);
+        add(statistics.value(GameStatistics::WhitePlayer, game));
+        add(statistics.value(GameStatistics::BlackPlayer, game));
+        add(quint64(statistics.whiteHalfPoints(game) + 1));
+        add(quint64(statistics.elo(game, White)) << 16 | quint64(statistics.elo(game, Black)));
+    }
+    return hash;
+}
+
+const Crosstable& Crosstables::crosstable(ValueIndex event) const
+{
+    static const Crosstable empty;
+    QHash<ValueIndex, Entry>::const_iterator it = m_tables.constFind(event);
+    return it == m_tables.constEnd() ? empty : it->table;
+}
@@ -0,0 +1,120 @@
+#ifndef CROSSTABLE_H
+#define CROSSTABLE_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "gameid.h"
+#include "indexitem.h"
+#include "piece.h"
+
+class GameStatistics;
+class IndexX;
+
+/** @ingroup Database
+ * The standings of the players of one event, with the result of each of their games.
+ *
+ * Players are sorted by points, then by the Sonneborn-Berger and Buchholz
+ * tie-breaks, then by name. Points are counted in half points, tie-breaks
+ * built from them in half or quarter points, so that no rounding occurs.
+ */
+class Crosstable
+{
+public:
+    /** A game of a player */
+    struct Pairing
+    {
+        /** Row of the opponent */
+        int opponent;
+        Color color;
+        GameId game;
+        /** Points of the player in half points, -1 if the game was not decided */
+        int halfPoints;
+    };
+
+    /** A row of the table */
+    struct Player
+    {
+        ValueIndex value;
+        /** Number of decided games */
+        int games;
+        int halfPoints;
+        /** Sum of the points of the opponents in half points */
+        int buchholz;
+        /** Sum of the points of the beaten opponents and half the points of those drawn, in quarter points */
+        int sonnebornBerger;
+        /** Average rating of the player, 0 if there is none */
+        int rating;
+        /** Performance rating against the rated opponents, 0 if there are none */
+        int performance;
+        /** The games of the player in the order of the database */
+        QVector<Pairing> pairings;
+    };
+
+    Crosstable();
+    /** Compute the table of @p games, which are taken from @p statistics */
+    Crosstable(const IndexX* index, const GameStatistics& statistics, const QVector<GameId>& games);
+
+    /** @return the number of players */
+    int count() const { return m_players.count(); }
+    /** @return the player ranked at @p row */
+    const Player& player(int row) const { return m_players[row]; }
+    /** @return the results of the player at @p row against the one at @p column, e.g. "1½", empty if they did not meet */
+    QString results(int row, int column) const;
+
+    /** @return @p halfPoints formatted as points, e.g. "3½" */
+    static QString formatPoints(int halfPoints);
+
+private:
+    QVector<Player> m_players;
+};
+
+/** @ingroup Database
+ * The crosstables of all events of an index.
+ *
+ * The tables are built from the columns of GameStatistics by a pool of
+ * threads, each taking a share of the events. Every table is kept with a
+ * signature of the games of its event, so that after games were appended
+ * or replaced only the tables of the events whose games changed are built
+ * again.
+ */
+class Crosstables
+{
+public:
+    Crosstables();
+
+    /** Bring the tables up to date with @p statistics of @p index */
+    void update(const IndexX* index, const GameStatistics& statistics);
+    /** @return the table of @p event, an empty one if there is no such event */
+    const Crosstable& crosstable(ValueIndex event) const;
+    /** @return the number of tables built by the last update */
+    int built() const { return m_built; }
+
+private:
+    /** A table with the signature of the games it was built from */
+    struct Entry
+    {
+        quint64 signature;
+        Crosstable table;
+    };
+    /** An event to be checked by updateEvents() */
+    struct Task
+    {
+        ValueIndex event;
+        bool built;
+        Entry entry;
+    };
+
+    /** Check the events of [@p begin, @p end) and build the tables which are missing or outdated */
+    void updateEvents(const GameStatistics* statistics, Task* begin, Task* end) const;
+    /** @return a hash of the players, results and ratings of @p games */
+    static quint64 signature(const GameStatistics& statistics, const QVector<GameId>& games);
+
+    const IndexX* m_index;
+    quint32 m_revision;
+    QHash<ValueIndex, Entry> m_tables;
+    int m_built;
+};
+
+#endif // CROSSTABLE_H
@@ -13,7 +13,7 @@
 #define read_24(buf, pos)   \
     ((buf[pos]<<16) + (buf[(pos)+1]<<8) + (buf[(pos)+2]))
 #define read_32(buf, pos)   \
-    ((buf[pos]<<24) + (buf[pos+1]<<16) + (buf[(pos)+2]<<8) + (buf[(pos+3)+2]))
+    ((buf[pos]<<24) + (buf[(pos)+1]<<16) + (buf[(pos)+2]<<8) + (buf[(pos)+3]))
 
 typedef struct _page_bounds_t {
     int pad;
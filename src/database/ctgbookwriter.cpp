@@ -24,7 +24,11 @@ void CtgBookWriter::run()
     m_destination->book_make(*m_source, m_break);
     if (!m_break)
     {
-        emit bookBuildFinished(m_out);
+        emit bookBuildFinished(m_out, this);
+    }
+    else
+    {
+        emit bookBuildError(m_out, this);
     }
     deleteLater();
 }
@@ -41,11 +45,12 @@ void CtgBookWriter::writeBookForDatabase(Database *src, const QString &out, int
     m_destination = new CtgDatabase();
     if (m_destination->openForWriting(out, maxPly, minGame, uniform))
     {
+        connect(m_destination, SIGNAL(progress(int)), this, SIGNAL(progress(int)));
         start();
     }
     else
     {
-        emit bookBuildError(out);
+        emit bookBuildError(out, this);
         deleteLater();
     }
 }
@@ -18,8 +18,9 @@ public:
     void writeBookForDatabase(Database* src, const QString &out, int maxPly, int minGame, bool uniform);
 
 signals:
-    void bookBuildFinished(QString);
-    void bookBuildError(QString);
+    void bookBuildFinished(QString, CtgBookWriter*);
+    void bookBuildError(QString, CtgBookWriter*);
+    void progress(int);
 
 public slots:
     void cancel();
@@ -8,16 +8,19 @@
 ****************************************************************************/
 
 #include <QtCore>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
 #include "ctgdatabase.h"
 #include "ctg.h"
+#include "gamex.h"
+#include "refcount.h"
 #include "square.h"
+#include "tags.h"
 
 using namespace chessx;
 
-#ifndef ntohl
-#define ntohl(x) (x) // Hack for Linux which does not know ntohl
-#endif
-
 #if defined(_MSC_VER) && defined(_DEBUG)
 #define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
 #define new DEBUG_NEW
@@ -34,7 +37,13 @@ CtgDatabase::CtgDatabase() :
     ctg_file(nullptr),
     cto_file(nullptr),
     ctb_file(nullptr),
+    m_ctgMap(nullptr),
+    m_ctgSize(0),
+    m_ctoMap(nullptr),
+    m_ctoSize(0),
     m_count(0),
+    m_maxPly(0),
+    m_minGame(0),
     page_bounds{}
 {
 }
@@ -60,11 +69,21 @@ bool CtgDatabase::open(const QString &filename, bool)
     {
         m_utf8 = false;
 
-        // Read out upper and lower page limits.
-        ctb_file->read((char*)&page_bounds, 12);
-        page_bounds.low = ntohl((uint32_t)page_bounds.low);
-        page_bounds.high = ntohl((uint32_t)page_bounds.high);
+        // Read out upper and lower page limits, all numbers are big endian.
+        uchar bounds[12] = { };
+        ctb_file->read((char*)bounds, 12);
+        page_bounds.low = qFromBigEndian<qint32>(bounds + 4);
+        page_bounds.high = qFromBigEndian<qint32>(bounds + 8);
         // Actually, closing ctb here would be ok
+
+        // Probing touches several pages per position, mapping the files avoids
+        // a seek and read for each of them. Without mapping the files are read.
+        QFile* ctg = static_cast<QFile*>(ctg_file);
+        QFile* cto = static_cast<QFile*>(cto_file);
+        m_ctgSize = ctg->size();
+        m_ctgMap = ctg->map(0, m_ctgSize);
+        m_ctoSize = cto->size();
+        m_ctoMap = cto->map(0, m_ctoSize);
         return true;
     }
     return false;
@@ -143,6 +162,11 @@ void CtgDatabase::close()
     delete cto_file;
     delete ctb_file;
 
+    m_ctgMap = nullptr;
+    m_ctgSize = 0;
+    m_ctoMap = nullptr;
+    m_ctoSize = 0;
+
     ctg_file = nullptr;
     cto_file = nullptr;
     ctb_file = nullptr;
@@ -211,10 +235,10 @@ bool CtgDatabase::ctg_get_page_index(int hash, int* page_index) const
         key = (hash & mask) + mask;
         if (key >= (uint32_t)page_bounds.low)
         {
-            cto_file->seek(16 + key*4);
-            int n;
-            cto_file->read((char*)&n, 4);
-            *page_index = ntohl((uint32_t)n);
+            if (!cto_read(key, page_index))
+            {
+                return false;
+            }
             if (*page_index >= 0)
             {
                 return true;
@@ -226,62 +250,114 @@ bool CtgDatabase::ctg_get_page_index(int hash, int* page_index) const
 
 // ---------------------------------------------------------
 
+bool CtgDatabase::cto_read(uint32_t key, int* page_index) const
+{
+    qint64 offset = 16 + qint64(key)*4;
+    uchar n[4];
+    if (m_ctoMap)
+    {
+        if (offset + 4 > m_ctoSize) return false;
+        memcpy(n, m_ctoMap + offset, 4);
+    }
+    else
+    {
+        cto_file->seek(offset);
+        if (cto_file->read((char*)n, 4) != 4) return false;
+    }
+    *page_index = qFromBigEndian<qint32>(n);
+    return true;
+}
+
+// ---------------------------------------------------------
+
+const uint8_t* CtgDatabase::ctg_page(int page_index, uint8_t* buf) const
+{
+    // Pages are a uniform 4096 bytes.
+    qint64 offset = 4096*(qint64(page_index) + 1);
+    if (m_ctgMap)
+    {
+        return (offset + 4096 <= m_ctgSize) ? m_ctgMap + offset : nullptr;
+    }
+    ctg_file->seek(offset);
+    if (ctg_file->read((char*)buf, 4096) != 4096) return nullptr;
+    return buf;
+}
+
+// ---------------------------------------------------------
+
 bool CtgDatabase::ctg_lookup_entry(int page_index,
         ctg_signature_t* sig,
         ctg_entry_t* entry) const
 {
-    // Pages are a uniform 4096 bytes.
-    uint8_t buf[4096];
-    ctg_file->seek(4096*(page_index + 1));
-    if (!ctg_file->read((char*)buf, 4096)) return false;
+    bool found = false;
+    return ctg_lookup_entries(page_index, &sig, &entry, &found, 1) == 1;
+}
+
+// ---------------------------------------------------------
+
+int CtgDatabase::ctg_lookup_entries(int page_index,
+        ctg_signature_t* const* sigs,
+        ctg_entry_t* const* entries,
+        bool* found,
+        int count) const
+{
+    uint8_t page[4096];
+    const uint8_t* buf = ctg_page(page_index, page);
+    if (!buf) return 0;
     int num_positions = (buf[0]<<8) + buf[1];
 
-    // Just scan through the list until we find a matching signature.
+    // Scan through the list once, matching each stored signature against all wanted ones.
     int pos = 4;
-    for (int i=0; i<num_positions; ++i) {
+    int remaining = count;
+    for (int i=0; i<num_positions && remaining && pos < 4096; ++i) {
         int entry_size = buf[pos] % 32;
-        bool equal = true;
-        if (sig->buf_len != entry_size) equal = false;
-        for (int j=0; j<sig->buf_len && equal; ++j) {
-            if (buf[pos+j] != sig->buf[j]) equal = false;
+        int k = 0;
+        for (; k<count; ++k) {
+            if (found[k] || sigs[k]->buf_len != entry_size) continue;
+            if (!memcmp(buf + pos, sigs[k]->buf, entry_size)) break;
         }
-        if (!equal) {
+        if (k == count) {
             pos += entry_size + buf[pos+entry_size] + 33;
             continue;
         }
-        // Found it, fill in the entry and return. Annoyingly, most of the
+        found[k] = true;
+        --remaining;
+
+        // Found it, fill in the entry. Annoyingly, most of the
         // fields are 24 bits long.
-        pos += entry_size;
-        entry_size = buf[pos];
-        for (int j=1; j<entry_size; ++j) entry->moves[j-1] = buf[pos+j];
-        entry->num_moves = (entry_size - 1)/2;
-        pos += entry_size;
-        entry->total = read_24(buf, pos);
-        pos += 3;
-        entry->losses = read_24(buf, pos);
-        pos += 3;
-        entry->wins = read_24(buf, pos);
-        pos += 3;
-        entry->draws = read_24(buf, pos);
-        pos += 3;
-        entry->unknown1 = read_32(buf, pos);
-        pos += 4;
-        entry->avg_rating_games = read_24(buf, pos);
-        pos += 3;
-        entry->avg_rating_score = read_32(buf, pos);
-        pos += 4;
-        entry->perf_rating_games = read_24(buf, pos);
-        pos += 3;
-        entry->perf_rating_score = read_32(buf, pos);
-        pos += 4;
-        entry->recommendation = buf[pos];
-        pos += 1;
-        entry->unknown2 = buf[pos];
-        pos += 1;
-        entry->comment = buf[pos];
-        return true;
+        ctg_entry_t* entry = entries[k];
+        int p = pos + entry_size;
+        int moves_size = buf[p];
+        for (int j=1; j<moves_size; ++j) entry->moves[j-1] = buf[p+j];
+        entry->num_moves = (moves_size - 1)/2;
+        p += moves_size;
+        entry->total = read_24(buf, p);
+        p += 3;
+        entry->losses = read_24(buf, p);
+        p += 3;
+        entry->wins = read_24(buf, p);
+        p += 3;
+        entry->draws = read_24(buf, p);
+        p += 3;
+        entry->unknown1 = read_32(buf, p);
+        p += 4;
+        entry->avg_rating_games = read_24(buf, p);
+        p += 3;
+        entry->avg_rating_score = read_32(buf, p);
+        p += 4;
+        entry->perf_rating_games = read_24(buf, p);
+        p += 3;
+        entry->perf_rating_score = read_32(buf, p);
+        p += 4;
+        entry->recommendation = buf[p];
+        p += 1;
+        entry->unknown2 = buf[p];
+        p += 1;
+        entry->comment = buf[p];
+
+        pos += entry_size + moves_size + 33;
     }
-    return false;
+    return count - remaining;
 }
 
 // ---------------------------------------------------------
@@ -325,68 +401,73 @@ Move CtgDatabase::squares_to_move(const BoardX& position, Square from, Square to
 
 // ---------------------------------------------------------
 
+// ---------------------------------------------------------
+// CTG move encoding: piece type, index of the piece to be moved (counting
+// from A1 to H8 by files) and the delta x and delta y of the move.
+// ---------------------------------------------------------
+
+static const char* const ctg_piece_code =
+    "PNxQPQPxQBKxPBRNxxBKPBxxPxQBxBxxxRBQPxBPQQNxxPBQNQBxNxNQQQBQBxxx"
+    "xQQxKQxxxxPQNQxxRxRxBPxxxxxxPxxPxQPQxxBKxRBxxxRQxxBxQxxxxBRRPRQR"
+    "QRPxxNRRxxNPKxQQxxQxQxPKRRQPxQxBQxQPxRxxxRxQxRQxQPBxxRxQxBxPQQKx"
+    "xBBBRRQPPQBPBRxPxPNNxxxQRQNPxxPKNRxRxQPQRNxPPQQRQQxNRBxNQQQQxQQx";
+static const int ctg_piece_index[256] = {
+    5, 2, 9, 2, 2, 1, 4, 9, 2, 2, 1, 9, 1, 1, 2, 1,
+    9, 9, 1, 1, 8, 1, 9, 9, 7, 9, 2, 1, 9, 2, 9, 9,
+    9, 2, 2, 2, 8, 9, 1, 3, 1, 1, 2, 9, 9, 6, 1, 1,
+    2, 1, 2, 9, 1, 9, 1, 1, 2, 1, 1, 2, 1, 9, 9, 9,
+    9, 2, 1, 9, 1, 1, 9, 9, 9, 9, 8, 1, 2, 2, 9, 9,
+    1, 9, 1, 9, 2, 3, 9, 9, 9, 9, 9, 9, 7, 9, 9, 5,
+    9, 1, 2, 2, 9, 9, 1, 1, 9, 2, 1, 0, 9, 9, 1, 2,
+    9, 9, 2, 9, 1, 9, 9, 9, 9, 2, 1, 2, 3, 2, 1, 1,
+    1, 1, 6, 9, 9, 1, 1, 1, 9, 9, 1, 1, 1, 9, 2, 1,
+    9, 9, 2, 9, 1, 9, 2, 1, 1, 1, 1, 3, 9, 1, 9, 2,
+    2, 9, 1, 8, 9, 2, 9, 9, 9, 2, 9, 2, 9, 2, 2, 9,
+    2, 6, 1, 9, 9, 2, 9, 1, 9, 2, 9, 5, 2, 2, 1, 9,
+    9, 1, 2, 1, 2, 2, 2, 7, 7, 2, 2, 6, 2, 1, 9, 4,
+    9, 2, 2, 2, 9, 9, 9, 1, 2, 1, 1, 1, 9, 9, 5, 1,
+    2, 1, 9, 2, 9, 1, 4, 1, 1, 1, 9, 4, 1, 1, 2, 1,
+    2, 1, 9, 2, 2, 2, 0, 1, 2, 2, 2, 2, 9, 1, 2, 9
+};
+static const int ctg_forward[256] = {
+    1,-1, 9, 0, 1, 1, 1, 9, 0, 6,-1, 9, 1, 3, 0,-1,
+    9, 9, 7, 1, 1, 5, 9, 9, 1, 9, 6, 1, 9, 7, 9, 9,
+    9, 0, 2, 6, 1, 9, 7, 1, 5, 0,-2, 9, 9, 1, 1, 0,
+   -2, 0, 5, 9, 2, 9, 1, 4, 4, 0, 6, 5, 5, 9, 9, 9,
+    9, 5, 7, 9,-1, 3, 9, 9, 9, 9, 2, 5, 2, 1, 9, 9,
+    6, 9, 0, 9, 1, 1, 9, 9, 9, 9, 9, 9, 1, 9, 9, 2,
+    9, 6, 2, 7, 9, 9, 3, 1, 9, 7, 4, 0, 9, 9, 0, 7,
+    9, 9, 7, 9, 0, 9, 9, 9, 9, 6, 3, 6, 1, 1, 3, 0,
+    6, 1, 1, 9, 9, 2, 0, 5, 9, 9,-2, 1,-1, 9, 2, 0,
+    9, 9, 1, 9, 3, 9, 1, 0, 0, 4, 6, 2, 9, 2, 9, 4,
+    3, 9, 2, 1, 9, 5, 9, 9, 9, 0, 9, 6, 9, 0, 3, 9,
+    4, 2, 6, 9, 9, 0, 9, 5, 9, 3, 9, 1, 0, 2, 0, 9,
+    9, 2, 2, 2, 0, 4, 5, 1, 2, 7, 3, 1, 5, 0, 9, 1,
+    9, 1, 1, 1, 9, 9, 9, 1, 0, 2,-2, 2, 9, 9, 1, 1,
+   -1, 7, 9, 3, 9, 0, 2, 4, 2,-1, 9, 1, 1, 7, 1, 0,
+    0, 1, 9, 2, 2, 1, 0, 1, 0, 6, 0, 2, 9, 7, 3, 9
+};
+static const int ctg_left[256] = {
+   -1, 2, 9,-2, 0, 0, 1, 9,-4,-6, 0, 9, 1,-3,-3, 2,
+    9, 9,-7, 0,-1,-5, 9, 9, 0, 9, 0, 1, 9,-7, 9, 9,
+    9,-7, 2,-6, 1, 9, 7, 1,-5,-6,-1, 9, 9,-1,-1,-1,
+    1,-3,-5, 9,-1, 9,-2, 0, 4,-5,-6, 5, 5, 9, 9, 9,
+    9,-5, 7, 9,-1,-3, 9, 9, 9, 9, 0, 5,-1, 0, 9, 9,
+    0, 9,-6, 9, 1, 0, 9, 9, 9, 9, 9, 9,-1, 9, 9, 0,
+    9,-6, 0, 7, 9, 9, 3,-1, 9, 0,-4, 0, 9, 9,-5,-7,
+    9, 9, 7, 9,-2, 9, 9, 9, 9, 6, 0, 0,-1, 0, 3,-1,
+    6, 0, 1, 9, 9, 1,-7, 0, 9, 9,-1,-1, 1, 9, 2,-7,
+    9, 9,-1, 9, 0, 9,-1, 1,-3, 0, 0, 0, 9, 0, 9, 4,
+    0, 9,-2, 0, 9, 0, 9, 9, 9,-2, 9, 6, 9,-4,-3, 9,
+    0, 0, 6, 9, 9,-5, 9, 0, 9,-3, 9, 0,-5, 0,-1, 9,
+    9,-2,-2, 2,-1, 0, 0, 1, 0, 0, 3, 0, 5,-2, 9, 0,
+    9, 1,-2, 2, 9, 9, 9, 1,-6, 2, 1, 0, 9, 9, 1, 1,
+   -2, 0, 9, 0, 9,-4, 0,-4, 0,-2, 9,-1, 0,-7, 1,-4,
+   -7,-1, 9, 1, 0,-1, 0, 2,-1, 0,-3,-2, 9, 0, 3, 9
+};
+
 Move CtgDatabase::byte_to_move(const BoardX& pos, uint8_t byte) const
 {
-    const char* piece_code =
-        "PNxQPQPxQBKxPBRNxxBKPBxxPxQBxBxxxRBQPxBPQQNxxPBQNQBxNxNQQQBQBxxx"
-        "xQQxKQxxxxPQNQxxRxRxBPxxxxxxPxxPxQPQxxBKxRBxxxRQxxBxQxxxxBRRPRQR"
-        "QRPxxNRRxxNPKxQQxxQxQxPKRRQPxQxBQxQPxRxxxRxQxRQxQPBxxRxQxBxPQQKx"
-        "xBBBRRQPPQBPBRxPxPNNxxxQRQNPxxPKNRxRxQPQRNxPPQQRQQxNRBxNQQQQxQQx";
-    const int piece_index[256]= {
-        5, 2, 9, 2, 2, 1, 4, 9, 2, 2, 1, 9, 1, 1, 2, 1,
-        9, 9, 1, 1, 8, 1, 9, 9, 7, 9, 2, 1, 9, 2, 9, 9,
-        9, 2, 2, 2, 8, 9, 1, 3, 1, 1, 2, 9, 9, 6, 1, 1,
-        2, 1, 2, 9, 1, 9, 1, 1, 2, 1, 1, 2, 1, 9, 9, 9,
-        9, 2, 1, 9, 1, 1, 9, 9, 9, 9, 8, 1, 2, 2, 9, 9,
-        1, 9, 1, 9, 2, 3, 9, 9, 9, 9, 9, 9, 7, 9, 9, 5,
-        9, 1, 2, 2, 9, 9, 1, 1, 9, 2, 1, 0, 9, 9, 1, 2,
-        9, 9, 2, 9, 1, 9, 9, 9, 9, 2, 1, 2, 3, 2, 1, 1,
-        1, 1, 6, 9, 9, 1, 1, 1, 9, 9, 1, 1, 1, 9, 2, 1,
-        9, 9, 2, 9, 1, 9, 2, 1, 1, 1, 1, 3, 9, 1, 9, 2,
-        2, 9, 1, 8, 9, 2, 9, 9, 9, 2, 9, 2, 9, 2, 2, 9,
-        2, 6, 1, 9, 9, 2, 9, 1, 9, 2, 9, 5, 2, 2, 1, 9,
-        9, 1, 2, 1, 2, 2, 2, 7, 7, 2, 2, 6, 2, 1, 9, 4,
-        9, 2, 2, 2, 9, 9, 9, 1, 2, 1, 1, 1, 9, 9, 5, 1,
-        2, 1, 9, 2, 9, 1, 4, 1, 1, 1, 9, 4, 1, 1, 2, 1,
-        2, 1, 9, 2, 2, 2, 0, 1, 2, 2, 2, 2, 9, 1, 2, 9
-    };
-    const int forward[256]= {
-        1,-1, 9, 0, 1, 1, 1, 9, 0, 6,-1, 9, 1, 3, 0,-1,
-        9, 9, 7, 1, 1, 5, 9, 9, 1, 9, 6, 1, 9, 7, 9, 9,
-        9, 0, 2, 6, 1, 9, 7, 1, 5, 0,-2, 9, 9, 1, 1, 0,
-       -2, 0, 5, 9, 2, 9, 1, 4, 4, 0, 6, 5, 5, 9, 9, 9,
-        9, 5, 7, 9,-1, 3, 9, 9, 9, 9, 2, 5, 2, 1, 9, 9,
-        6, 9, 0, 9, 1, 1, 9, 9, 9, 9, 9, 9, 1, 9, 9, 2,
-        9, 6, 2, 7, 9, 9, 3, 1, 9, 7, 4, 0, 9, 9, 0, 7,
-        9, 9, 7, 9, 0, 9, 9, 9, 9, 6, 3, 6, 1, 1, 3, 0,
-        6, 1, 1, 9, 9, 2, 0, 5, 9, 9,-2, 1,-1, 9, 2, 0,
-        9, 9, 1, 9, 3, 9, 1, 0, 0, 4, 6, 2, 9, 2, 9, 4,
-        3, 9, 2, 1, 9, 5, 9, 9, 9, 0, 9, 6, 9, 0, 3, 9,
-        4, 2, 6, 9, 9, 0, 9, 5, 9, 3, 9, 1, 0, 2, 0, 9,
-        9, 2, 2, 2, 0, 4, 5, 1, 2, 7, 3, 1, 5, 0, 9, 1,
-        9, 1, 1, 1, 9, 9, 9, 1, 0, 2,-2, 2, 9, 9, 1, 1,
-       -1, 7, 9, 3, 9, 0, 2, 4, 2,-1, 9, 1, 1, 7, 1, 0,
-        0, 1, 9, 2, 2, 1, 0, 1, 0, 6, 0, 2, 9, 7, 3, 9
-    };
-    const int left[256] = {
-       -1, 2, 9,-2, 0, 0, 1, 9,-4,-6, 0, 9, 1,-3,-3, 2,
-        9, 9,-7, 0,-1,-5, 9, 9, 0, 9, 0, 1, 9,-7, 9, 9,
-        9,-7, 2,-6, 1, 9, 7, 1,-5,-6,-1, 9, 9,-1,-1,-1,
-        1,-3,-5, 9,-1, 9,-2, 0, 4,-5,-6, 5, 5, 9, 9, 9,
-        9,-5, 7, 9,-1,-3, 9, 9, 9, 9, 0, 5,-1, 0, 9, 9,
-        0, 9,-6, 9, 1, 0, 9, 9, 9, 9, 9, 9,-1, 9, 9, 0,
-        9,-6, 0, 7, 9, 9, 3,-1, 9, 0,-4, 0, 9, 9,-5,-7,
-        9, 9, 7, 9,-2, 9, 9, 9, 9, 6, 0, 0,-1, 0, 3,-1,
-        6, 0, 1, 9, 9, 1,-7, 0, 9, 9,-1,-1, 1, 9, 2,-7,
-        9, 9,-1, 9, 0, 9,-1, 1,-3, 0, 0, 0, 9, 0, 9, 4,
-        0, 9,-2, 0, 9, 0, 9, 9, 9,-2, 9, 6, 9,-4,-3, 9,
-        0, 0, 6, 9, 9,-5, 9, 0, 9,-3, 9, 0,-5, 0,-1, 9,
-        9,-2,-2, 2,-1, 0, 0, 1, 0, 0, 3, 0, 5,-2, 9, 0,
-        9, 1,-2, 2, 9, 9, 9, 1,-6, 2, 1, 0, 9, 9, 1, 1,
-       -2, 0, 9, 0, 9,-4, 0,-4, 0,-2, 9,-1, 0,-7, 1,-4,
-       -7,-1, 9, 1, 0,-1, 0, 2,-1, 0,-3,-2, 9, 0, 3, 9
-    };
-
     // Find the piece. Note: the board may be mirrored/flipped.
     bool flip_board = pos.blackToMove();
     Color white = pos.toMove();
@@ -414,7 +495,7 @@ Move CtgDatabase::byte_to_move(const BoardX& pos, uint8_t byte) const
 
     // Look up piece type. Note: positions are always white to move.
     Piece pc = Empty;
-    char glyph = piece_code[byte];
+    char glyph = ctg_piece_code[byte];
     switch (glyph) {
         case 'P': pc = WhitePawn; break;
         case 'N': pc = WhiteKnight; break;
@@ -426,7 +507,7 @@ Move CtgDatabase::byte_to_move(const BoardX& pos, uint8_t byte) const
     }
 
     // Find the piece.
-    int nth_piece = piece_index[byte], piece_count = 0;
+    int nth_piece = ctg_piece_index[byte], piece_count = 0;
     bool found = false;
     for (unsigned char file=0; file<8 && !found; ++file) {
         for (int rank=0; rank<8 && !found; ++rank) {
@@ -444,9 +525,9 @@ Move CtgDatabase::byte_to_move(const BoardX& pos, uint8_t byte) const
     }
 
     // Normalize rank and file values.
-    file_to = file_from - left[byte];
+    file_to = file_from - ctg_left[byte];
     file_to = (file_to + 8) % 8;
-    rank_to = rank_from + forward[byte];
+    rank_to = rank_from + ctg_forward[byte];
     rank_to = (rank_to + 8) % 8;
     if (flip_board) {
         rank_from = 7-rank_from;
@@ -577,13 +658,23 @@ uint64_t CtgDatabase::move_weight(const BoardX& pos,
         MoveData& md) const
 {
     // Here, the game is needed
-    bool reversed = pos.blackToMove();
     BoardX b(pos);
     b.doMove(move);
     ctg_entry_t entry;
     bool success = ctg_get_entry(b, &entry);
     if (!success) return 0;
 
+    return entry_to_move_data(pos, move, entry, md);
+}
+
+// ---------------------------------------------------------
+
+uint64_t CtgDatabase::entry_to_move_data(const BoardX& pos,
+        Move move,
+        const ctg_entry_t& entry,
+        MoveData& md) const
+{
+    bool reversed = pos.blackToMove();
     if (reversed)
     {
         md.results.update(WhiteWin, entry.losses);
@@ -596,7 +687,11 @@ uint64_t CtgDatabase::move_weight(const BoardX& pos,
         md.results.update(Draw, entry.draws);
         md.results.update(BlackWin, entry.losses);
     }
-    md.rating.update(entry.avg_rating_score, entry.avg_rating_games);
+    // The score is the sum of the ratings
+    if (entry.avg_rating_games)
+    {
+        md.rating.update(entry.avg_rating_score / entry.avg_rating_games, entry.avg_rating_games);
+    }
     md.move = move;
     md.san = pos.moveToSan(move);
     md.localsan = pos.moveToSan(move, true);
@@ -626,28 +721,80 @@ bool CtgDatabase::findMove(quint64 /*key*/, MoveData& /*m*/)
     return false;
 }
 
+/** A move of a book position and the lookup of the position after it */
+struct CtgChildLookup
+{
+    Move move;
+    ctg_signature_t sig;
+    int page_index;
+    ctg_entry_t entry;
+};
+
 unsigned int CtgDatabase::getMoveMapForBoard(const BoardX &pos, QMap<Move, MoveData>& moveList)
 {
     ctg_entry_t entry = { };
     if (!ctg_get_entry(pos, &entry)) return 0;
 
-    // Position is here, output the moves associated with it
-    int games = 0;
+    // Compute the signatures of all child positions first, and look
+    // up the children sharing a page with a single scan of that page
+    QVector<CtgChildLookup> children;
+    children.reserve(entry.num_moves);
     for (int i=0; i<entry.num_moves; ++i)
     {
-        uint8_t byte = entry.moves[i];
+        // Each move is followed by its annotation byte
+        uint8_t byte = entry.moves[2*i];
         Move m = byte_to_move(pos, byte);
         if (m.isLegal())
         {
-            MoveData md;
-            int newGames = move_weight(pos, m, md);
-            if (newGames)
+            CtgChildLookup child;
+            child.move = m;
+            BoardX b(pos);
+            b.doMove(m);
+            position_to_ctg_signature(b, &child.sig);
+            if (ctg_get_page_index(ctg_signature_to_hash(&child.sig), &child.page_index))
             {
-                games += newGames;
-                moveList.insert(md.move, md);
+                children.append(child);
             }
         }
     }
+    std::sort(children.begin(), children.end(), [](const CtgChildLookup& a, const CtgChildLookup& b)
+    {
+        return a.page_index < b.page_index;
+    });
+
+    QVector<ctg_signature_t*> sigs;
+    QVector<ctg_entry_t*> entries;
+    QVector<bool> found;
+    int games = 0;
+    for (int first = 0; first < children.count();)
+    {
+        int last = first;
+        sigs.clear();
+        entries.clear();
+        while (last < children.count() && children[last].page_index == children[first].page_index)
+        {
+            sigs.append(&children[last].sig);
+            entries.append(&children[last].entry);
+            ++last;
+        }
+        found.fill(false, last - first);
+        ctg_lookup_entries(children[first].page_index, sigs.data(), entries.data(), found.data(), last - first);
+
+        for (int i = first; i < last; ++i)
+        {
+            if (found[i - first])
+            {
+                MoveData md;
+                int newGames = entry_to_move_data(pos, children[i].move, children[i].entry, md);
+                if (newGames)
+                {
+                    games += newGames;
+                    moveList.insert(md.move, md);
+                }
+            }
+        }
+        first = last;
+    }
 
     return games;
 }
@@ -656,19 +803,399 @@ unsigned int CtgDatabase::getMoveMapForBoard(const BoardX &pos, QMap<Move, MoveD
 // Book building - public interface
 // ---------------------------------------------------------
 
-bool CtgDatabase::openForWriting(const QString &filename, int /*maxPly*/, int /*minGame*/, bool /*uniform*/)
+bool CtgDatabase::openForWriting(const QString &filename, int maxPly, int minGame, bool /*uniform*/)
 {
     if(ctg_file)
     {
         return false;
     }
 
-    // todo
-
+    // ctg books do not store move weights, so uniform has no meaning here
+    m_maxPly = maxPly;
+    m_minGame = minGame;
+    m_break = false;
+    m_filename = filename;
+    m_utf8 = false;
     return openFile(filename, false);
 }
 
-void CtgDatabase::book_make(Database& /*db*/, volatile bool& /*breakFlag*/)
+void CtgDatabase::book_make(Database& db, volatile bool& breakFlag)
 {
-    // todo
+    QMutexLocker m(mutex());
+    CtgBookPositions positions;
+    if (!breakFlag) add_database(db, positions, breakFlag);
+    if (!breakFlag) book_save(positions);
+    close();
+}
+
+// ---------------------------------------------------------
+// Book building
+// ---------------------------------------------------------
+
+CtgBookPosition& CtgBookPosition::operator+=(const CtgBookPosition& rhs)
+{
+    games += rhs.games;
+    wins += rhs.wins;
+    losses += rhs.losses;
+    draws += rhs.draws;
+    ratedGames += rhs.ratedGames;
+    ratingSum += rhs.ratingSum;
+    for (int i=0; i<4; ++i) moves[i] |= rhs.moves[i];
+    return *this;
+}
+
+/** Index of a piece type in "PNBRQK", the piece glyphs of the move tables */
+static int ctg_glyph_index(char glyph)
+{
+    switch (glyph) {
+        case 'P': return 0;
+        case 'N': return 1;
+        case 'B': return 2;
+        case 'R': return 3;
+        case 'Q': return 4;
+        case 'K': return 5;
+        default: return -1;
+    }
+}
+
+/** Inverse of the move tables: byte of piece glyph, piece index, left and forward distance */
+struct CtgMoveBytes
+{
+    CtgMoveBytes()
+    {
+        memset(bytes, -1, sizeof(bytes));
+        for (int byte=255; byte>=0; --byte) {
+            // Castling is encoded separately
+            if (byte == 107 || byte == 246) continue;
+            int glyph = ctg_glyph_index(ctg_piece_code[byte]);
+            int nth = ctg_piece_index[byte];
+            if (glyph < 0 || nth < 1 || nth > 8) continue;
+            bytes[glyph][nth][(ctg_left[byte] + 8) % 8][(ctg_forward[byte] + 8) % 8] = byte;
+        }
+    }
+
+    int16_t bytes[6][9][8][8];
+};
+
+int CtgDatabase::move_to_byte(const BoardX& pos, Move move) const
+{
+    if (move.isCastling())
+    {
+        return move.isCastlingShort() ? 107 : 246;
+    }
+    // CTG does not support underpromotion
+    if (move.isPromotion() && pieceType(move.promotedPiece()) != Queen)
+    {
+        return -1;
+    }
+
+    // Normalize the board as in byte_to_move()
+    bool flip_board = pos.blackToMove();
+    Color white = pos.toMove();
+    bool mirror_board = (File(pos.kingSquare(white)) < chessx::FILE_E) &&
+        (pos.castlingRights() == 0);
+    auto normalize = [&](Square sq)
+    {
+        if (flip_board) sq = SquareMirrorRank(sq);
+        if (mirror_board) sq = SquareMirrorFile(sq);
+        return sq;
+    };
+
+    Piece pc = flip_board ? flipPiece(pos.pieceAt(move.from())) : pos.pieceAt(move.from());
+    int glyph = -1;
+    switch (pc) {
+        case WhitePawn: glyph = 0; break;
+        case WhiteKnight: glyph = 1; break;
+        case WhiteBishop: glyph = 2; break;
+        case WhiteRook: glyph = 3; break;
+        case WhiteQueen: glyph = 4; break;
+        case WhiteKing: glyph = 5; break;
+        default: return -1;
+    }
+
+    Square from = normalize(move.from());
+    Square to = normalize(move.to());
+    int nth_piece = 0;
+    for (unsigned char file=0; file<8; ++file) {
+        for (int rank=0; rank<8; ++rank) {
+            Square sq = create_square(file, rank);
+            Piece piece = flip_board ? flipPiece(pos.pieceAt(normalize(sq))) : pos.pieceAt(normalize(sq));
+            if (piece == pc) ++nth_piece;
+            if (sq == from) {
+                file = 8;
+                break;
+            }
+        }
+    }
+    if (nth_piece > 8) return -1;
+
+    static const CtgMoveBytes moveBytes;
+    int left = (File(from) - File(to) + 8) % 8;
+    int forward = (Rank(to) - Rank(from) + 8) % 8;
+    return moveBytes.bytes[glyph][nth_piece][left][forward];
+}
+
+/** Count the result of a game for the side which moved into @p position */
+static void ctg_add_result(CtgBookPosition& position, Result result, Color mover, int elo)
+{
+    ++position.games;
+    if (result == Draw)
+    {
+        ++position.draws;
+    }
+    else if (result == WhiteWin || result == BlackWin)
+    {
+        if ((result == WhiteWin) == (mover == White))
+            ++position.wins;
+        else
+            ++position.losses;
+    }
+    if (elo > 0)
+    {
+        ++position.ratedGames;
+        position.ratingSum += elo;
+    }
+}
+
+void CtgDatabase::add_game(GameX& g, CtgBookPositions& positions) const
+{
+    if (!(BoardX::standardStartBoard == g.startingBoard()))
+    {
+        return;
+    }
+    Result result = g.result();
+    int elo[2] = { g.tag(TagNameWhiteElo).toInt(), g.tag(TagNameBlackElo).toInt() };
+
+    g.moveToStart();
+    ctg_signature_t sig;
+    position_to_ctg_signature(g.board(), &sig);
+    QByteArray key((const char*)sig.buf, sig.buf_len);
+    Color mover = oppositeColor(g.board().toMove());
+    ctg_add_result(positions[key], result, mover, elo[mover]);
+
+    for (int ply = 0; ply < m_maxPly && !g.atLineEnd(); ++ply)
+    {
+        BoardX board = g.board();
+        g.forward();
+        Move m = g.move();
+        if (m.isNullMove())
+        {
+            // terminate game here, can happen in case of null move
+            break;
+        }
+        int byte = move_to_byte(board, m);
+        position_to_ctg_signature(g.board(), &sig);
+        if (byte < 0 || sig.buf_len >= 32)
+        {
+            break;
+        }
+        // Positions may move when the child is inserted, so the parent is updated first
+        positions[key].moves[byte >> 6] |= quint64(1) << (byte & 63);
+        key = QByteArray((const char*)sig.buf, sig.buf_len);
+        mover = board.toMove();
+        ctg_add_result(positions[key], result, mover, elo[mover]);
+    }
+}
+
+CtgBookPositions CtgDatabase::add_database_chunk(Database* db, int start, int end, volatile bool* breakFlag)
+{
+    // Each thread collects its own positions, they are merged afterwards
+    CtgBookPositions positions;
+    int progressCount = 1 + end / 100;
+    GameX game;
+    for(int i = start; i < end; ++i)
+    {
+        if (!start)
+        {
+            if ((i)%progressCount==0) emit progress((i)/progressCount);
+        }
+
+        if (*breakFlag) break;
+        if (db->deleted(i)) continue;
+        game.reset();
+        db->loadGameMainline(i, game);
+        db->loadGameHeader(i, game, TagNameResult);
+        db->loadGameHeader(i, game, TagNameWhiteElo);
+        db->loadGameHeader(i, game, TagNameBlackElo);
+        add_game(game, positions);
+        m_gamesAdded.fetchAndAddRelaxed(1);
+    }
+    return positions;
+}
+
+void CtgDatabase::add_database(Database& db, CtgBookPositions& positions, volatile bool& breakFlag)
+{
+    int maxThreads = QThread::idealThreadCount();
+    int n = db.count();
+    int chunk = n/maxThreads + 1;
+    m_gamesAdded = 0;
+
+    RefKeeper m(db.refCounter());
+    QList<QFuture<CtgBookPositions> > futures;
+    for (int start = 0; start < n; start += chunk)
+    {
+        int end = std::min(start + chunk, n);
+#if QT_VERSION < 0x060000
+        futures.append(QtConcurrent::run(this, &CtgDatabase::add_database_chunk, &db, start, end, &breakFlag));
+#else
+        futures.append(QtConcurrent::run(&CtgDatabase::add_database_chunk, this, &db, start, end, &breakFlag));
+#endif
+    }
+
+    for (QFuture<CtgBookPositions>& future : futures)
+    {
+        CtgBookPositions chunkPositions = future.result();
+        if (positions.isEmpty())
+        {
+            positions.swap(chunkPositions);
+            continue;
+        }
+        for (auto it = chunkPositions.cbegin(); it != chunkPositions.cend(); ++it)
+        {
+            positions[it.key()] += it.value();
+        }
+    }
+}
+
+/** Append the lowest @p size bytes of @p n in big endian order */
+static void ctg_append(QByteArray& buf, quint64 n, int size)
+{
+    for (int i = size-1; i >= 0; --i)
+    {
+        buf.append(char((n >> (i*8)) & 0xFF));
+    }
+}
+
+/** A position as written to a page */
+struct CtgBookEntry
+{
+    quint32 bucket;
+    QByteArray data;
+};
+
+void CtgDatabase::book_save(const CtgBookPositions& positions)
+{
+    const int PageSize = 4096;
+    const int PageHeaderSize = 4;
+    const quint32 MaxCount = 0xFFFFFF;
+
+    // Encode the entries
+    QVector<CtgBookEntry> entries;
+    QVector<int32_t> hashes;
+    qint64 totalSize = 0;
+    for (auto it = positions.cbegin(); it != positions.cend(); ++it)
+    {
+        const CtgBookPosition& position = it.value();
+        if (position.games < m_minGame) continue;
+
+        ctg_signature_t sig = { };
+        memcpy(sig.buf, it.key().constData(), it.key().size());
+        sig.buf_len = it.key().size();
+
+        CtgBookEntry entry;
+        entry.data = it.key();
+        QByteArray moves;
+        for (int byte = 0; byte < 256 && moves.size() < 98; ++byte)
+        {
+            if (position.moves[byte >> 6] & (quint64(1) << (byte & 63)))
+            {
+                moves.append(char(byte));
+                moves.append(char(0)); // no annotation
+            }
+        }
+        entry.data.append(char(moves.size() + 1));
+        entry.data.append(moves);
+        ctg_append(entry.data, std::min(position.games, MaxCount), 3);
+        ctg_append(entry.data, std::min(position.losses, MaxCount), 3);
+        ctg_append(entry.data, std::min(position.wins, MaxCount), 3);
+        ctg_append(entry.data, std::min(position.draws, MaxCount), 3);
+        ctg_append(entry.data, 0, 4);
+        ctg_append(entry.data, std::min(position.ratedGames, MaxCount), 3);
+        ctg_append(entry.data, std::min(position.ratingSum, quint64(0x7FFFFFFF)), 4);
+        ctg_append(entry.data, 0, 3); // performance
+        ctg_append(entry.data, 0, 4);
+        ctg_append(entry.data, 0, 3); // recommendation, unknown, comment
+        totalSize += entry.data.size();
+        entries.append(entry);
+        hashes.append(ctg_signature_to_hash(&sig));
+    }
+    m_count = entries.count();
+
+    // The page of a position is found by the lowest bits of its hash, see
+    // ctg_get_page_index(). Use enough bits that each bucket fits on a page.
+    quint32 mask = 1;
+    while ((qint64(mask) + 1) * (PageSize / 2) < totalSize) mask = mask * 2 + 1;
+    QVector<int> bucketSize;
+    forever
+    {
+        bucketSize.fill(0, mask + 1);
+        int largest = 0;
+        for (int i = 0; i < entries.count(); ++i)
+        {
+            entries[i].bucket = quint32(hashes.at(i)) & mask;
+            largest = std::max(largest, bucketSize[entries[i].bucket] += entries[i].data.size());
+        }
+        if (largest <= PageSize - PageHeaderSize) break;
+        mask = mask * 2 + 1;
+    }
+    std::sort(entries.begin(), entries.end(), [](const CtgBookEntry& a, const CtgBookEntry& b)
+    {
+        return a.bucket < b.bucket;
+    });
+
+    // The index is read up to the next larger mask, unused slots are -1
+    QVector<int32_t> index(4 * mask + 3, -1);
+
+    // Header page, then the pages filled bucket by bucket
+    QByteArray header(PageSize, 0);
+    qToBigEndian<quint32>(m_gamesAdded.loadRelaxed(), (uchar*)header.data());
+    ctg_file->write(header);
+
+    QByteArray page;
+    int pageIndex = 0;
+    int pagePositions = 0;
+    auto flushPage = [&]()
+    {
+        int used = page.size() + PageHeaderSize;
+        QByteArray head;
+        ctg_append(head, pagePositions, 2);
+        ctg_append(head, used, 2);
+        page.prepend(head);
+        page.append(QByteArray(PageSize - used, 0));
+        ctg_file->write(page);
+        page.clear();
+        pagePositions = 0;
+        ++pageIndex;
+    };
+    for (int first = 0; first < entries.count();)
+    {
+        int last = first;
+        while (last < entries.count() && entries.at(last).bucket == entries.at(first).bucket) ++last;
+        if (page.size() + PageHeaderSize + bucketSize.at(entries.at(first).bucket) > PageSize)
+        {
+            flushPage();
+        }
+        index[mask + entries.at(first).bucket] = pageIndex;
+        for (int i = first; i < last; ++i)
+        {
+            page.append(entries.at(i).data);
+            ++pagePositions;
+        }
+        first = last;
+    }
+    if (pagePositions) flushPage();
+
+    QByteArray cto(16, 0);
+    qToBigEndian<quint32>(index.count(), (uchar*)cto.data() + 4);
+    for (int32_t n : qAsConst(index))
+    {
+        ctg_append(cto, quint32(n), 4);
+    }
+    cto_file->write(cto);
+
+    QByteArray ctb;
+    ctg_append(ctb, 0, 4);
+    ctg_append(ctb, mask, 4);
+    ctg_append(ctb, 2 * mask, 4);
+    ctb_file->write(ctb);
 }
@@ -8,10 +8,32 @@
 #include "database.h"
 #include "movedata.h"
 #include <stdint.h>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHash>
 #include "ctg.h"
 
 struct _results_t;
 
+/** Statistics of a position collected while compiling a ctg book */
+struct CtgBookPosition
+{
+    /** Results are seen from the side which moved into the position */
+    quint32 games = 0;
+    quint32 wins = 0;
+    quint32 losses = 0;
+    quint32 draws = 0;
+    quint32 ratedGames = 0;
+    quint64 ratingSum = 0;
+    /** Bitmap of the ctg move bytes played from the position */
+    quint64 moves[4] = { 0, 0, 0, 0 };
+
+    CtgBookPosition& operator+=(const CtgBookPosition& rhs);
+};
+
+/** Book positions keyed by their ctg signature */
+typedef QHash<QByteArray, CtgBookPosition> CtgBookPositions;
+
 class CtgDatabase : public Database
 {
     Q_OBJECT
@@ -52,7 +74,7 @@ public:
     unsigned int getMoveMapForBoard(const BoardX &board, QMap<Move, MoveData>& moves);
     /** Start a search for a new key */
     void reset();
-    /** Compile a ctg book (to be done) */
+    /** Compile a ctg book from the games of @p db */
     void book_make(Database& db, volatile bool& breakFlag);
 
 signals:
@@ -77,6 +99,23 @@ protected: // Methods which are CTG only
             ctg_signature_t* sig,
             ctg_entry_t* entry) const;
 
+    /**
+     * Find the entries of @p count signatures stored on the same page in a
+     * single scan of that page. @p found is set for each signature located.
+     * @return the number of entries found
+     */
+    int ctg_lookup_entries(int page_index,
+            ctg_signature_t* const* sigs,
+            ctg_entry_t* const* entries,
+            bool* found,
+            int count) const;
+
+    /** @return the 4 KB page @p page_index of the .ctg file, read into @p buf if the file is not mapped */
+    const uint8_t* ctg_page(int page_index, uint8_t* buf) const;
+
+    /** Read the page index stored for @p key in the .cto file */
+    bool cto_read(uint32_t key, int* page_index) const;
+
     void dump_signature(ctg_signature_t* sig) const;
 
 protected: // Methods which interface with ChessX
@@ -103,15 +142,38 @@ protected: // Methods which interface with ChessX
      */
     uint64_t move_weight(const BoardX& pos, Move move, MoveData& md) const;
 
+    /** Fill @p md for @p move from @p pos, given the @p entry of the resulting position */
+    uint64_t entry_to_move_data(const BoardX& pos, Move move, const ctg_entry_t& entry, MoveData& md) const;
+
     /** Get the ctg entry associated with the given position. */
     bool ctg_get_entry(const BoardX& pos, ctg_entry_t* entry) const;
 
+protected: // Book building
+    /** Convert a native move to the ctg move byte, the inverse of byte_to_move(). @return -1 if it cannot be encoded */
+    int move_to_byte(const BoardX& pos, Move move) const;
+    /** Collect the positions of games [@p start, @p end) of @p db, called in parallel for separate ranges */
+    CtgBookPositions add_database_chunk(Database* db, int start, int end, volatile bool* breakFlag);
+    /** Collect the positions of all games of @p db into @p positions */
+    void add_database(Database& db, CtgBookPositions& positions, volatile bool& breakFlag);
+    /** Add the positions of the first m_maxPly plies of @p g */
+    void add_game(GameX& g, CtgBookPositions& positions) const;
+    /** Write the positions with enough games to the .ctg, .cto and .ctb files in one sequential pass */
+    void book_save(const CtgBookPositions& positions);
+
 private:
     QString m_filename;
     QIODevice* ctg_file;
     QIODevice* cto_file;
     QIODevice* ctb_file;
+    /** The .ctg and .cto files mapped into memory, or nullptr to read them page by page */
+    const uchar* m_ctgMap;
+    qint64 m_ctgSize;
+    const uchar* m_ctoMap;
+    qint64 m_ctoSize;
     quint64 m_count;
+    int m_maxPly;
+    quint32 m_minGame;
+    QAtomicInt m_gamesAdded;
 
     page_bounds_t page_bounds;
 };
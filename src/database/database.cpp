@@ -50,6 +50,18 @@ const IndexX* Database::index() const
     return &m_index;
 }
 
+const GameStatistics& Database::statistics()
+{
+    m_statistics.update(&m_index);
+    return m_statistics;
+}
+
+const Crosstables& Database::crosstables()
+{
+    m_crosstables.update(&m_index, statistics());
+    return m_crosstables;
+}
+
 quint64 Database::count() const
 {
     return 0;
@@ -86,6 +98,16 @@ bool Database::loadGame(GameId /*gameId*/, GameX& /*game*/)
     return false;
 }
 
+bool Database::loadGameMainline(GameId index, GameX& game)
+{
+    if(index >= count())
+    {
+        return false;
+    }
+    loadGameMoves(index, game);
+    return true;
+}
+
 void Database::loadGameHeaders(GameId gameId, GameX &game) const
 {
     m_index.loadGameHeaders(gameId, game);
@@ -108,11 +130,12 @@ QString Database::tagValue(GameId gameId, TagIndex tag) const
 
 void Database::findPosition(const BoardX& position, PositionSearchOptions options, const QList<GameId>& games, QList<MoveId>& output, QMap<Move, MoveData>& stats)
 {
+    GameX g;
     for (auto gameId: games)
     {
         // search for position
-        GameX g;
-        loadGameMoves(gameId, g);
+        g.reset();
+        loadGameMainline(gameId, g);
         const auto& cursor = g.cursor();
         auto moveId = cursor.findPosition(position);
         if ((options & PositionSearch_GameEnd) && !cursor.atGameEnd(moveId))
@@ -11,7 +11,9 @@
 #ifndef DATABASE_H_INCLUDED
 #define DATABASE_H_INCLUDED
 
+#include "crosstable.h"
 #include "filter.h"
+#include "gamestatistics.h"
 #include "gamex.h"
 #include "index.h"
 #include "refcount.h"
@@ -87,6 +89,9 @@ public:
     virtual QString tagValue(GameId gameId, TagIndex tag) const;
     /** Loads only moves into a game from the given position */
     virtual void loadGameMoves(GameId index, GameX& game) = 0;
+    /** Loads only the main line moves into a game, without comments, nags and variations.
+        The default implementation loads all moves. Returns false if the moves could not be read completely. */
+    virtual bool loadGameMainline(GameId index, GameX& game);
     /** Loads game moves and try to find a position */
     virtual int findPosition(GameId index, const BoardX& position) = 0;
     /** Perform batched position search */
@@ -107,6 +112,10 @@ public:
     IndexX *index();
     /** @return const pointer to the index of the database */
     const IndexX *index() const;
+    /** @return the typed columns and game lists of the index, brought up to date if it changed */
+    const GameStatistics& statistics();
+    /** @return the crosstables of all events, rebuilt where games changed */
+    const Crosstables& crosstables();
     /** Returns the number of games in the database */
     virtual quint64 count() const;
     /** @return true if the database has been modified. */
@@ -133,6 +142,8 @@ signals:
 
 protected:
     IndexX m_index;
+    GameStatistics m_statistics;
+    Crosstables m_crosstables;
     bool m_utf8;
     QMutex m_mutex;
 };
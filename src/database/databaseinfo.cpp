@@ -11,6 +11,7 @@
 #include <QUndoStack>
 
 #include "arenabook.h"
+#include "compressedfile.h"
 #include "ctgdatabase.h"
 #include "databaseinfo.h"
 #include "ficsdatabase.h"
@@ -79,7 +80,13 @@ DatabaseInfo::DatabaseInfo(QUndoGroup* undoGroup, const QString& fname): m_filte
     {
         m_database = new CtgDatabase;
     }
-    else if(file.size()/(1024 * 1024) < AppSettings->getValue("/General/EditLimit").toInt())
+    else if (CompressedFile::isCompressed(fname))
+    {
+        // Compressed games are streamed from the archive and cannot be edited
+        m_database = new PgnDatabase;
+        ((PgnDatabase*)m_database)->set64bit(true);
+    }
+    else if(file.size()/(1024 * 1024) < AppSettings->snapshot().editLimit)
     {
         m_database = new MemoryDatabase;
     }
@@ -197,8 +204,8 @@ bool DatabaseInfo::loadGame(GameId index)
 
 void DatabaseInfo::updateMaterial()
 {
-    m_game.scoreMaterial(m_material);
-    m_game.scoreEvaluations(m_evaluations);
+    m_game.scoreMaterial(m_material, m_materialLine);
+    m_game.scoreEvaluations(m_evaluations, m_evaluationAnnotations);
     emit signalGameModified(!m_undoStack->isClean());
 }
 
@@ -277,9 +284,10 @@ bool DatabaseInfo::saveGame()
         eco.clear();
     }
 
-    if(AppSettings->getValue("/General/automaticECO").toBool())
+    const SettingsSnapshot& settings = AppSettings->snapshot();
+    if(settings.automaticECO)
     {
-        if(eco.isEmpty() || !AppSettings->getValue("/General/preserveECO").toBool())
+        if(eco.isEmpty() || !settings.preserveECO)
         {
             eco = m_game.ecoClassify().left(3);
             if(!eco.isEmpty())
@@ -458,6 +466,7 @@ bool DatabaseInfo::IsBook() const
     QString suffix = fi.suffix().toLower();
 
     return ((suffix == "pgn") ||
+            s.endsWith(".pgn.gz", Qt::CaseInsensitive) ||
             (suffix == "si4") ||
             (suffix == "bin") ||
             (suffix == "abk") ||
@@ -121,6 +121,9 @@ public:
 
     QList<double> m_material;
     QList<double> m_evaluations;
+    /** Mainline moves and annotations m_material and m_evaluations were computed for */
+    QVector<Move> m_materialLine;
+    QStringList m_evaluationAnnotations;
 
     const QList<double> &material() const;
     const QList<double> &evaluations() const;
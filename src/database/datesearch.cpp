@@ -3,7 +3,6 @@
 ****************************************************************************/
 
 #include "datesearch.h"
-#include "gamex.h"
 #include "database.h"
 
 using namespace chessx;
@@ -15,17 +14,24 @@ using namespace chessx;
 
 /* DateSearch class
  * **********************/
-DateSearch::DateSearch()
+DateSearch::DateSearch(Database* database) : Search(database)
 {
     m_minDate = m_maxDate = PartialDate();
+    initialize();
 }
 
-DateSearch::DateSearch(const PartialDate& minDate, const PartialDate& maxDate)
+DateSearch::DateSearch(Database* database, const PartialDate& minDate, const PartialDate& maxDate) : Search(database)
 {
     Q_ASSERT(minDate < maxDate);
 
     m_minDate = minDate;
     m_maxDate = maxDate;
+    initialize();
+}
+
+void DateSearch::initialize()
+{
+    m_matches = m_database ? m_database->index()->listInDateRange(m_minDate, m_maxDate) : QBitArray();
 }
 
 PartialDate DateSearch::minDate() const
@@ -43,14 +49,11 @@ void DateSearch::setDateRange(const PartialDate& minDate, const PartialDate& max
     Q_ASSERT(minDate < maxDate);
     m_minDate = minDate;
     m_maxDate = maxDate;
+    initialize();
 }
 
 int DateSearch::matches(GameId index) const
 {
-    GameX g;
-    m_database->loadGameHeaders(index, g);
-    PartialDate date(g.tag("Date"));
-
-    return (date >= m_minDate && date <= m_maxDate);
+    return (int)index < m_matches.size() && m_matches.at(index);
 }
 
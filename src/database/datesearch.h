@@ -7,6 +7,7 @@
 
 #include "search.h"
 #include "partialdate.h"
+#include <QBitArray>
 
 /** @ingroup Search
 The DataSearch class defines a search based on a date range */
@@ -16,9 +17,9 @@ class DateSearch : public Search
 
 public:
     /** Standard constructor. */
-    DateSearch();
+    explicit DateSearch(Database* database);
     /** Constructor for searching games in given time period. */
-    DateSearch(const PartialDate &minDate, const PartialDate &maxDate);
+    DateSearch(Database* database, const PartialDate &minDate, const PartialDate &maxDate);
     /** @return beginning of the acceptable period. */
     PartialDate minDate() const;
     /** @return end of the acceptable period. */
@@ -29,6 +30,9 @@ public:
     virtual int matches(GameId index) const;
 
 private:
+    /** Recompute the matching games from the index */
+    void initialize();
+
     PartialDate m_minDate;
     PartialDate m_maxDate;
     QBitArray m_matches;
@@ -24,9 +24,18 @@ DuplicateSearch::DuplicateSearch(FilterX *filter, DSMode mode):Search(filter ? f
    m_filter = filter;
 }
 
+void DuplicateSearch::loadGames(GameId i, GameX& gI, GameId j, GameX& gJ) const
+{
+    gI.reset();
+    m_database->loadGame(i, gI);
+    gJ.reset();
+    m_database->loadGame(j, gJ);
+}
+
 void DuplicateSearch::PrepareFilter(volatile bool &breakFlag)
 {
     const IndexX* index = m_database->index();
+    GameX gI, gJ;
     for (GameId i = 0; (int)i<index->count(); ++i)
     {
         if (!m_filter->contains(i)) continue;
@@ -41,9 +50,7 @@ void DuplicateSearch::PrepareFilter(volatile bool &breakFlag)
                 GameId j = iter.value();
                 if (index->isIndexItemEqual(i,j))
                 {
-                    GameX gI, gJ;
-                    m_database->loadGame(i, gI);
-                    m_database->loadGame(j, gJ);
+                    loadGames(i, gI, j, gJ);
                     found = gI.isEqual(gJ);
                 }
             }
@@ -66,6 +73,7 @@ void DuplicateSearch::Prepare(volatile bool &breakFlag)
             PrepareFilter(breakFlag);
         }
 
+        GameX gI, gJ;
         for (GameId i = 0; (int)i<index->count(); ++i)
         {
             if (i % 1024 == 0) emit prepareUpdate(i*100/index->count());
@@ -84,9 +92,7 @@ void DuplicateSearch::Prepare(volatile bool &breakFlag)
                     {
                         if ((m_mode == DS_Both) || (m_mode == DS_Both_All) || (m_mode == DS_Game) || (m_mode == DS_Game_All))
                         {
-                            GameX gI, gJ;
-                            m_database->loadGame(i, gI);
-                            m_database->loadGame(j, gJ);
+                            loadGames(i, gI, j, gJ);
                             found = gI.isEqual(gJ);
                             if (((m_mode == DS_Both_All) || (m_mode == DS_Game_All)) && found)
                             {
@@ -95,9 +101,7 @@ void DuplicateSearch::Prepare(volatile bool &breakFlag)
                         }
                         else if (m_mode == DS_Tags_BestGame)
                         {
-                            GameX gI, gJ;
-                            m_database->loadGame(i, gI);
-                            m_database->loadGame(j, gJ);
+                            loadGames(i, gI, j, gJ);
                             if (gJ.isBetterOrEqual(gI))
                             {
                                 found = true;
@@ -9,6 +9,8 @@
 #include <QBitArray>
 #include <QMultiHash>
 
+class GameX;
+
 /** @ingroup Search
 The DuplicateSearch class defines a search for duplicates within a database */
 class DuplicateSearch : public Search
@@ -36,6 +38,9 @@ public:
     void PrepareFilter(volatile bool& breakFlag);
 
 private:
+    /** Load games @p i and @p j into the reused scratch games @p gI and @p gJ */
+    void loadGames(GameId i, GameX& gI, GameId j, GameX& gJ) const;
+
     QMultiHash<quint64, GameId> m_hashToGames;
     QBitArray m_matches;
     DSMode m_mode;
@@ -0,0 +1,126 @@
+#include "ecoclassifier.h"
+#include "filter.h"
+#include "tags.h"
+
+#include <QFutureSynchronizer>
+#include <QtConcurrent/QtConcurrent>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+EcoClassifier::EcoClassifier(QObject *parent) :
+    QThread(parent),
+    m_database(nullptr),
+    m_break(false)
+{
+}
+
+EcoClassifier::~EcoClassifier()
+{
+}
+
+void EcoClassifier::classifyChunk(int start, int end)
+{
+    int total = m_gameIds.count();
+    int progressCount = 1 + total / 100;
+    QHash<GameId, QString> changes;
+    GameX game;
+    for(int i = start; i < end; ++i)
+    {
+        if (m_break) return;
+
+        GameId gameId = m_gameIds.at(i);
+        m_database->loadGameMainline(gameId, game);
+        QString eco = game.ecoClassify().left(3);
+        if (!eco.isEmpty())
+        {
+            QString oldEco = m_database->tagValue(gameId, TagNameECO).left(3);
+            if (eco != oldEco)
+            {
+                changes.insert(gameId, eco);
+            }
+        }
+
+        int done = ++m_done;
+        if (done % progressCount == 0)
+        {
+            emit progress(done / progressCount);
+        }
+    }
+
+    QMutexLocker m(&m_changesMutex);
+    m_changes.insert(changes);
+}
+
+void EcoClassifier::run()
+{
+    RefKeeper m(m_database->refCounter());
+
+    int maxThreads = QThread::idealThreadCount();
+    int n = m_gameIds.count();
+    int chunk = n / maxThreads + 1;
+
+    QFutureSynchronizer<void> synchronizer;
+    for (int start = 0; start < n; start += chunk)
+    {
+        int end = std::min(start + chunk, n);
+#if QT_VERSION < 0x060000
+        QFuture<void> future = QtConcurrent::run(this, &EcoClassifier::classifyChunk, start, end);
+#else
+        QFuture<void> future = QtConcurrent::run(&EcoClassifier::classifyChunk, this, start, end);
+#endif
+        synchronizer.addFuture(future);
+    }
+    synchronizer.waitForFinished();
+
+    if (m_break)
+    {
+        emit classificationCanceled(m_database, this);
+    }
+    else
+    {
+        if (!m_changes.isEmpty())
+        {
+            DatabaseTransaction transaction(m_database);
+            m_database->index()->setTagValues(TagNameECO, m_changes);
+            m_database->setModified(true);
+        }
+        emit progress(100);
+        emit classificationFinished(m_database, this);
+    }
+    deleteLater();
+}
+
+// ---------------------------------------------------------
+// Mainthread Interface
+// ---------------------------------------------------------
+
+void EcoClassifier::classifyDatabase(Database *database, const FilterX* filter)
+{
+    m_break = false;
+    m_database = database;
+    m_changes.clear();
+    m_gameIds.clear();
+    m_done = 0;
+
+    for (GameId i = 0, sz = static_cast<GameId>(database->index()->count()); i < sz; ++i)
+    {
+        if (database->deleted(i))
+        {
+            continue;
+        }
+        if (filter && !filter->contains(i))
+        {
+            continue;
+        }
+        m_gameIds.append(i);
+    }
+    start();
+}
+
+void EcoClassifier::cancel()
+{
+    m_break = true;
+}
@@ -0,0 +1,61 @@
+#ifndef ECOCLASSIFIER_H
+#define ECOCLASSIFIER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPointer>
+#include <QThread>
+
+#include "database.h"
+
+class FilterX;
+
+/** @ingroup Database
+    The EcoClassifier class recomputes the ECO tag of all games of a database
+    (or of a filter) in a background thread.
+    Games are classified in parallel chunks using EcoPositions. Only tags which
+    actually change are collected, and they are written into the index in one
+    batch inside a database transaction when all chunks are done.
+*/
+
+class EcoClassifier : public QThread
+{
+    Q_OBJECT
+public:
+    explicit EcoClassifier(QObject *parent = nullptr);
+    ~EcoClassifier();
+
+    /** Classify all games of @p database, or only the games in @p filter if it is not null */
+    void classifyDatabase(Database* database, const FilterX* filter = nullptr);
+
+    /** @return the number of ECO tags changed by the last run */
+    int changedCount() const { return m_changes.count(); }
+
+signals:
+    void classificationFinished(Database*, EcoClassifier*);
+    void classificationCanceled(Database*, EcoClassifier*);
+    void progress(int);
+
+public slots:
+    void cancel();
+
+    // QThread interface
+protected:
+    virtual void run();
+
+private:
+    /** Classify the games m_gameIds[start..end[ and collect the changed tags */
+    void classifyChunk(int start, int end);
+
+    QPointer<Database> m_database;
+    QList<GameId> m_gameIds;
+    QHash<GameId, QString> m_changes;
+    QMutex m_changesMutex;
+    QAtomicInt m_done;
+
+    volatile bool m_break;
+};
+
+#endif // ECOCLASSIFIER_H
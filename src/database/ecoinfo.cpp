@@ -57,43 +57,40 @@ void EcoInfo::setCode(const QString& eco)
     update();
 }
 
-int EcoInfo::toResult(const QString& res) const
+/** Add the points of the players of @p color in @p games to @p points and their number of scored games to @p gameCount */
+static void countPlayerPoints(const GameStatistics& statistics, const QVector<GameId>& games, Color color,
+                              QHash<ValueIndex, float>& points, QHash<ValueIndex, int>& gameCount)
 {
-    if(res.startsWith("1/2"))
+    for(GameId game : games)
     {
-        return Draw;
-    }
-    else if(res.startsWith('1'))
-    {
-        return WhiteWin;
-    }
-    else if(res.startsWith('0'))
-    {
-        return BlackWin;
-    }
-    else
-    {
-        return ResultUnknown;
+        ValueIndex player = statistics.value(color == White ? GameStatistics::WhitePlayer : GameStatistics::BlackPlayer, game);
+        int halfPoints = statistics.whiteHalfPoints(game);
+        // The following works as QHash initializes a default-constructed value to 0
+        if(halfPoints >= 0 && statistics.result(game) != ResultUnknown)
+        {
+            points[player] += (color == White) ? halfPoints / 2.0 : 1.0 - halfPoints / 2.0;
+            gameCount[player]++;
+        }
+        else
+        {
+            points[player] += 0;
+        }
     }
 }
 
-float EcoInfo::toPoints(const QString& res) const
+/** Add the players in @p points with their names to @p players and @p games */
+static void namePlayers(const IndexX* index, const QHash<ValueIndex, float>& points, const QHash<ValueIndex, int>& gameCount,
+                        QHash<QString, float>& players, QHash<QString, int>& games)
 {
-    if(res.startsWith("1/2"))
-    {
-        return 0.5;
-    }
-    else if(res.startsWith('1'))
-    {
-        return 1.0;
-    }
-    else if(res.startsWith('0'))
-    {
-        return 0.0;
-    }
-    else
+    for(auto it = points.cbegin(); it != points.cend(); ++it)
     {
-        return -1.0;
+        QString name = index->valueName(it.key());
+        players[name] += it.value();
+        int count = gameCount.value(it.key());
+        if(count)
+        {
+            games[name] += count;
+        }
     }
 }
 
@@ -103,6 +100,7 @@ void EcoInfo::update()
     QHash<QString, float> playersBlack;
 
     const IndexX* index = m_database->index();
+    const GameStatistics& statistics = m_database->statistics();
 
     // Determine matching tag values
     ValueIndex eco = index->getValueIndex(m_code);
@@ -110,40 +108,17 @@ void EcoInfo::update()
     // Clean previous statistics
     reset();
 
-    for(int i = 0; i < (int) m_database->count(); ++i)
+    const QVector<GameId>& games = statistics.games(GameStatistics::Opening, eco);
+    m_count = games.count();
+    statistics.countResults(games, m_result);
+    for(int c = White; c <= Black; ++c)
     {
-        if(index->valueIndexFromTag(TagNameECO, i) != eco)
-        {
-            continue;
-        }
-        QString result = index->tagValue(TagNameResult, i);
-        int res = toResult(result);
-        QString whitePlayer = index->tagValue(TagNameWhite, i);
-        QString blackPlayer = index->tagValue(TagNameBlack, i);
-        // The following works as QHash initializes a default-constructed value to 0
-        float fres = toPoints(result);
-        if(fres >= 0)
-        {
-            playersWhite[whitePlayer] += fres;
-            playersBlack[blackPlayer] += (1.0 - fres);
-            m_gamesWhite[whitePlayer]++;
-            m_gamesBlack[blackPlayer]++;
-        }
-        else
-        {
-            // This looks silly, but the []operator has a side effect!
-            if(playersWhite[whitePlayer] == 0)
-            {
-                playersWhite[whitePlayer] = 0;
-            }
-            if(playersBlack[blackPlayer] == 0)
-            {
-                playersBlack[blackPlayer] = 0;
-            }
-        }
-
-        m_result[res]++;
-        m_count++;
+        QHash<ValueIndex, float> points;
+        QHash<ValueIndex, int> gameCount;
+        countPlayerPoints(statistics, games, Color(c), points, gameCount);
+        namePlayers(index, points, gameCount,
+                    c == White ? playersWhite : playersBlack,
+                    c == White ? m_gamesWhite : m_gamesBlack);
     }
 
     for (auto it = playersWhite.cbegin(); it != playersWhite.cend(); ++it)
@@ -14,14 +14,8 @@
 #define new DEBUG_NEW
 #endif // _MSC_VER
 
-static bool sortPlayersLt(const PlayerInfoListItem& a1, const PlayerInfoListItem& a2)
-{
-    if(a1.second == a2.second)
-    {
-        return (a1.first < a2.first);
-    }
-    return a1.second > a2.second;
-}
+/** Events with more players are listed without the results of each pairing */
+const int MaxCrosstablePlayers = 24;
 
 EventInfo::EventInfo()
 {
@@ -57,47 +51,10 @@ void EventInfo::setName(const QString& event)
     update();
 }
 
-float EventInfo::toPoints(const QString& res) const
-{
-    if(res.startsWith("1/2"))
-    {
-        return 0.5;
-    }
-    else if(res.startsWith('1'))
-    {
-        return 1.0;
-    }
-    else if(res.startsWith('0'))
-    {
-        return 0.0;
-    }
-    else if(res.startsWith("+-"))
-    {
-        return 1.0;
-    }
-    else if(res.startsWith("-+"))
-    {
-        return 0.0;
-    }
-    else if(res.startsWith("+--"))
-    {
-        return 1.0;
-    }
-    else if(res.startsWith("--+"))
-    {
-        return 0.0;
-    }
-    else
-    {
-        return ResultUnknown;
-    }
-}
-
 void EventInfo::update()
 {
-    QHash<QString, float> players;
-
     const IndexX* index = m_database->index();
+    const GameStatistics& statistics = m_database->statistics();
 
     // Determine matching tag values
     ValueIndex event = index->getValueIndex(m_name);
@@ -105,39 +62,11 @@ void EventInfo::update()
     // Clean previous statistics
     reset();
 
-    for(int i = 0; i < (int) m_database->count(); ++i)
-    {
-        if(index->valueIndexFromTag(TagNameEvent, i) != event)
-        {
-            continue;
-        }
-        QString result = index->tagValue(TagNameResult, i);
-        int res = ResultFromString(result);
-        QString whitePlayer = index->tagValue(TagNameWhite, i);
-        QString blackPlayer = index->tagValue(TagNameBlack, i);
-        // The following works as QHash initializes a default-constructed value to 0
-        players[whitePlayer] += toPoints(result);
-        players[blackPlayer] += (1.0 - toPoints(result));
-        m_games[whitePlayer]++;
-        m_games[blackPlayer]++;
-        m_result[res]++;
-        m_count++;
-        PartialDate date(index->tagValue(TagNameDate, i));
-        if(date.year() > 1000)
-        {
-            m_date[0] = qMin(date, m_date[0]);
-            m_date[1] = qMax(date, m_date[1]);
-        }
-    }
-
-    QHashIterator<QString,float> kviter(players);
-
-    while(kviter.hasNext())
-    {
-        kviter.next();
-        m_players.append(PlayerInfoListItem(kviter.key(), kviter.value()));
-    }
-    std::sort(m_players.begin(), m_players.end(), sortPlayersLt);
+    const QVector<GameId>& games = statistics.games(GameStatistics::Event, event);
+    m_count = games.count();
+    statistics.countResults(games, m_result);
+    statistics.dateRange(games, m_date[0], m_date[1]);
+    m_crosstable = m_database->crosstables().crosstable(event);
 }
 
 
@@ -180,8 +109,7 @@ void EventInfo::reset()
             m_result[r] = 0;
         }
     }
-    m_players.clear();
-    m_games.clear();
+    m_crosstable = Crosstable();
     m_count = 0;
     m_rating[0] = 99999;
     m_rating[1] = 0;
@@ -228,15 +156,39 @@ QString EventInfo::formattedRange() const
 
 QString EventInfo::listOfPlayers() const
 {
+    int count = m_crosstable.count();
+    bool pairings = count <= MaxCrosstablePlayers;
+
     QString playersList;
-    playersList.append(QCoreApplication::translate("EventInfo", "<table><tr><th>Participants</th><th>Score</th></tr>"));
+    playersList.append(QCoreApplication::translate("EventInfo", "<table><tr><th>#</th><th>Participants</th>"));
+    if(pairings)
+    {
+        for(int column = 0; column < count; ++column)
+        {
+            playersList += QString("<th>%1</th>").arg(column + 1);
+        }
+    }
+    playersList.append(QCoreApplication::translate("EventInfo", "<th>Score</th><th>SB</th><th>Buchholz</th><th>Perf.</th></tr>"));
 
-    for(PlayerInfoList::const_iterator it = m_players.begin(); it != m_players.end(); ++it)
+    const IndexX* index = m_database->index();
+    for(int row = 0; row < count; ++row)
     {
-        playersList += QString("<tr><td><a href='player:%1'>%2</a></td><td>%3/%4</td></tr>")
-                       .arg((*it).first, (*it).first)
-                       .arg((*it).second)
-                       .arg(m_games[(*it).first]);
+        const Crosstable::Player& player = m_crosstable.player(row);
+        QString name = index->valueName(player.value);
+        playersList += QString("<tr><td>%1</td><td><a href='player:%2'>%3</a></td>").arg(row + 1).arg(name, name);
+        if(pairings)
+        {
+            for(int column = 0; column < count; ++column)
+            {
+                playersList += QString("<td align='center'>%1</td>").arg(column == row ? QString("X") : m_crosstable.results(row, column));
+            }
+        }
+        playersList += QString("<td>%1/%2</td><td>%3</td><td>%4</td><td>%5</td></tr>")
+                       .arg(Crosstable::formatPoints(player.halfPoints))
+                       .arg(player.pairings.count())
+                       .arg(player.sonnebornBerger / 4.0)
+                       .arg(Crosstable::formatPoints(player.buchholz))
+                       .arg(player.performance ? QString::number(player.performance) : QString());
     }
 
     playersList = playersList.append("</table>");
@@ -5,6 +5,7 @@
 #ifndef EVENTINFO_H
 #define EVENTINFO_H
 
+#include "crosstable.h"
 #include "partialdate.h"
 
 #include <QtCore>
@@ -42,7 +43,7 @@ public:
     QString formattedRating() const;
     /** @return string with formatted game count. */
     QString formattedGameCount() const;
-    /** @return string with list of players in the event */
+    /** @return string with the standings of the event, with its crosstable unless it has many players */
     QString listOfPlayers() const;
 
 private:
@@ -56,13 +57,11 @@ private:
 
     /** Format score statistics for single color. */
     QString formattedScore(const int results[4], int count) const;
-    float toPoints(const QString& res) const;
 
     int m_result[4];
     int m_count;
     int m_rating[2];
-    PlayerInfoList m_players;
-    QHash<QString, int> m_games;
+    Crosstable m_crosstable;
     PartialDate m_date[2];
 
 };
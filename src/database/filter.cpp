@@ -12,8 +12,13 @@
 #include "database.h"
 #include "filter.h"
 #include "filtersearch.h"
+#include <QFutureSynchronizer>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrent>
 #include <QtDebug>
 
+#include <algorithm>
+
 using namespace chessx;
 
 #if defined(_MSC_VER) && defined(_DEBUG)
@@ -21,11 +26,23 @@ using namespace chessx;
 #define new DEBUG_NEW
 #endif // _MSC_VER
 
+static inline int wordCount(unsigned int size)
+{
+    return static_cast<int>((size + 63) / 64);
+}
+
+static inline quint64 wordBit(GameId game)
+{
+    return quint64(1) << (game & 63);
+}
+
 FilterX::FilterX(Database* database) : QThread()
 {
     m_database = database;
-    m_count = m_database->count();
-    m_vector = new QVector<FilterX::value_type>(m_count, 1);
+    m_size = m_database->count();
+    m_count = m_size;
+    m_bits = QVector<quint64>(wordCount(m_size), ~quint64(0));
+    maskTail();
     m_gamesSearched = 0;
     m_searchTime = 0;
     currentSearchOperator = NullOperator;
@@ -36,12 +53,10 @@ FilterX::~FilterX()
 {
     cancel();
     delete currentSearch;
-    delete m_vector;
 }
 
 FilterX::FilterX(FilterX const& rhs) : QThread()
 {
-    m_vector = nullptr;
     *this = rhs;
 }
 
@@ -51,8 +66,9 @@ FilterX& FilterX::operator= (FilterX const& rhs)
     {
         m_database = rhs.m_database;
         m_count = rhs.m_count;
-        delete m_vector;
-        m_vector = new QVector<FilterX::value_type>(*rhs.m_vector);
+        m_size = rhs.m_size;
+        m_bits = rhs.m_bits;
+        m_positions = rhs.m_positions;
         m_gamesSearched = 0;
         m_searchTime = 0;
         currentSearch = nullptr;
@@ -80,84 +96,241 @@ Database* FilterX::database()
 
 void FilterX::set(GameId game, FilterX::value_type value)
 {
-    if((game >= size()) || (gamePosition(game) == value))
+    if(game >= m_size)
     {
         return;
     }
-    if(value && !contains(game))
+    quint64& word = m_bits[static_cast<int>(game >> 6)];
+    quint64 bit = wordBit(game);
+    if(value)
     {
-        ++m_count;
+        if(!(word & bit))
+        {
+            word |= bit;
+            ++m_count;
+        }
+        if(value == 1)
+        {
+            m_positions.remove(game);
+        }
+        else
+        {
+            m_positions[game] = value;
+        }
     }
-    else if(!value && contains(game))
+    else if(word & bit)
     {
+        word &= ~bit;
         --m_count;
+        m_positions.remove(game);
     }
-
-    (*m_vector)[game] = value;
 }
 
 void FilterX::setAll(FilterX::value_type value)
 {
     cancel();
-    m_vector->fill(value);
-    m_count = value ? size() : 0;
+    m_positions.clear();
+    m_bits.fill(value ? ~quint64(0) : 0);
+    maskTail();
+    m_count = value ? m_size : 0;
+    if(value && value != 1)
+    {
+        m_positions.reserve(m_size);
+        for(GameId i = 0; i < m_size; ++i)
+        {
+            m_positions.insert(i, value);
+        }
+    }
 }
 
 bool FilterX::contains(GameId game) const
 {
-    if(static_cast<int>(game) < m_vector->count())
+    if(game < m_size)
     {
-        return (m_vector->at(game) != 0);
+        return (m_bits.at(static_cast<int>(game >> 6)) & wordBit(game)) != 0;
     }
     return false;
 }
 
 FilterX::value_type FilterX::gamePosition(GameId game) const
 {
-    return m_vector->at(static_cast<int>(game));
+    if(!contains(game))
+    {
+        return 0;
+    }
+    return m_positions.isEmpty() ? 1 : m_positions.value(game, 1);
+}
+
+void FilterX::resize(unsigned int newsize, bool includeNew)
+{
+    unsigned int oldsize = m_size;
+    m_bits.resize(wordCount(newsize));
+    m_size = newsize;
+    if(newsize < oldsize)
+    {
+        maskTail();
+        prunePositions();
+        recount();
+        return;
+    }
+    if(includeNew)
+    {
+        // Set the new games of the last old word one by one, the following words at once
+        unsigned int i = oldsize;
+        for(; i < newsize && (i & 63); ++i)
+        {
+            m_bits[static_cast<int>(i >> 6)] |= wordBit(i);
+        }
+        if(i < newsize)
+        {
+            std::fill(m_bits.begin() + static_cast<int>(i >> 6), m_bits.end(), ~quint64(0));
+            maskTail();
+        }
+        m_count += newsize - oldsize;
+    }
+}
+
+void FilterX::invert()
+{
+    cancel();
+    for(quint64& word : m_bits)
+    {
+        word = ~word;
+    }
+    maskTail();
+    m_positions.clear();
+    m_count = m_size - m_count;
 }
 
-unsigned int FilterX::size() const
+void FilterX::intersect(const FilterX& filter)
 {
-    return static_cast<unsigned int>(m_vector->size());
+    cancel();
+    int n = qMin(m_bits.size(), filter.m_bits.size());
+    quint64* bits = m_bits.data();
+    const quint64* other = filter.m_bits.constData();
+    for(int i = 0; i < n; ++i)
+    {
+        bits[i] &= other[i];
+    }
+    std::fill(bits + n, bits + m_bits.size(), 0);
+    prunePositions();
+    recount();
 }
 
-void FilterX::resize(unsigned int newsize, bool includeNew)
+void FilterX::unite(const FilterX& filter)
 {
-    for(GameId i = static_cast<GameId>(newsize); i < size(); ++i)   // Decrease count by number of removed games
+    cancel();
+    for(auto it = filter.m_positions.cbegin(); it != filter.m_positions.cend(); ++it)
     {
-        if(contains(i))
+        if(it.key() < m_size && !contains(it.key()))
         {
-            --m_count;
+            m_positions.insert(it.key(), it.value());
         }
     }
-    unsigned int oldsize = size();
-    m_vector->resize(newsize);
-    // Set new (uninitialized games) to 'includeNew' value.
-    for(unsigned int i = oldsize; i < newsize; ++i)
+    int n = qMin(m_bits.size(), filter.m_bits.size());
+    quint64* bits = m_bits.data();
+    const quint64* other = filter.m_bits.constData();
+    for(int i = 0; i < n; ++i)
     {
-        (*m_vector)[i] = includeNew;
+        bits[i] |= other[i];
     }
-    if(includeNew)
+    maskTail();
+    recount();
+}
+
+void FilterX::subtract(const FilterX& filter)
+{
+    cancel();
+    int n = qMin(m_bits.size(), filter.m_bits.size());
+    quint64* bits = m_bits.data();
+    const quint64* other = filter.m_bits.constData();
+    for(int i = 0; i < n; ++i)
     {
-        m_count += newsize - oldsize;
+        bits[i] &= ~other[i];
     }
+    prunePositions();
+    recount();
 }
 
-void FilterX::invert()
+void FilterX::recount()
 {
-    cancel();
-    m_count = size() - m_count;
-    for(int i = 0, sz = static_cast<int>(size()); i < sz; ++i)
+    unsigned int count = 0;
+    for(quint64 word : qAsConst(m_bits))
     {
-        if(m_vector->at(i))
+        count += qPopulationCount(word);
+    }
+    m_count = static_cast<int>(count);
+}
+
+void FilterX::maskTail()
+{
+    if((m_size & 63) && !m_bits.isEmpty())
+    {
+        m_bits.last() &= wordBit(m_size) - 1;
+    }
+}
+
+void FilterX::prunePositions()
+{
+    for(auto it = m_positions.begin(); it != m_positions.end();)
+    {
+        if(contains(it.key()))
         {
-            (*m_vector)[i] = 0;
+            ++it;
         }
         else
         {
-            (*m_vector)[i] = 1;
+            it = m_positions.erase(it);
+        }
+    }
+}
+
+void FilterX::searchWords(Search* s, FilterOperator op, int firstWord, int endWord, int chunk)
+{
+    int totalWords = qMax(1, m_bits.size());
+    quint64* matches = m_searchMatches.data();
+    QHash<GameId, value_type>& positions = m_searchPositions[chunk];
+    for(int w = firstWord; w < endWord; ++w)
+    {
+        if (m_break) return;
+
+        // And and Remove only look at games in the filter, Or only at games not in it
+        quint64 candidates;
+        switch (op)
+        {
+        case FilterOperator::And:
+        case FilterOperator::Remove:
+            candidates = m_bits.at(w);
+            break;
+        case FilterOperator::Or:
+            candidates = ~m_bits.at(w);
+            break;
+        default:
+            candidates = ~quint64(0);
+            break;
+        }
+
+        GameId base = static_cast<GameId>(w) << 6;
+        quint64 match = 0;
+        for(; candidates; candidates &= candidates - 1)
+        {
+            int bit = qCountTrailingZeroBits(candidates);
+            GameId game = base + bit;
+            if (game >= m_size) break;
+            int n = s->matches(game);
+            if (n)
+            {
+                match |= quint64(1) << bit;
+                if (n != 1)
+                {
+                    positions.insert(game, static_cast<value_type>(n));
+                }
+            }
         }
+        matches[w] = match;
+
+        int done = m_wordsSearched.fetchAndAddRelaxed(1) + 1;
+        if (done % 16 == 0) emit searchProgress(done * 100 / totalWords);
     }
 }
 
@@ -168,57 +341,85 @@ void FilterX::runSingleSearch(Search* s, FilterOperator op)
     switch (op)
     {
     case FilterOperator::NullOperator:
-        for(int searchIndex = 0, sz = static_cast<int>(size()); searchIndex < sz; ++searchIndex)
-        {
-            if (m_break) break;
-            set(searchIndex, s->matches(searchIndex));
-            if (searchIndex % 1024 == 0) emit searchProgress(searchIndex*100/size());
-        }
+    case FilterOperator::And:
+    case FilterOperator::Or:
+    case FilterOperator::Remove:
+        break;
+    default:
+        return;
+    }
+
+    int words = m_bits.size();
+    int maxThreads = QThread::idealThreadCount();
+    int chunk = words / maxThreads + 1;
+    m_searchMatches = QVector<quint64>(words);
+    m_searchPositions = QVector<QHash<GameId, value_type> >((words + chunk - 1) / chunk);
+    m_wordsSearched = 0;
+
+    QFutureSynchronizer<void> synchronizer;
+    for (int start = 0, i = 0; start < words; start += chunk, ++i)
+    {
+        int end = std::min(start + chunk, words);
+#if QT_VERSION < 0x060000
+        QFuture<void> future = QtConcurrent::run(this, &FilterX::searchWords, s, op, start, end, i);
+#else
+        QFuture<void> future = QtConcurrent::run(&FilterX::searchWords, this, s, op, start, end, i);
+#endif
+        synchronizer.addFuture(future);
+    }
+    synchronizer.waitForFinished();
+
+    if (m_break)
+    {
+        m_searchMatches.clear();
+        m_searchPositions.clear();
+        return;
+    }
+
+    // Merge the results into the filter
+    quint64* bits = m_bits.data();
+    const quint64* match = m_searchMatches.constData();
+    switch (op)
+    {
+    case FilterOperator::NullOperator:
+        std::copy(match, match + words, bits);
+        m_positions.clear();
         break;
     case FilterOperator::And:
-        for(int searchIndex = 0, sz = static_cast<int>(size()); searchIndex < sz; ++searchIndex)
+        for(int w = 0; w < words; ++w)
         {
-            if (m_break) break;
-            if (contains(searchIndex))
-            {
-                int n = s->matches(searchIndex);
-                if (n!=1) // Better search result or and does not apply
-                {
-                    set(searchIndex, n);
-                }
-            }
-            if (searchIndex % 1024 == 0) emit searchProgress(searchIndex*100/size());
+            bits[w] &= match[w];
         }
         break;
     case FilterOperator::Or:
-        for(int searchIndex = 0, sz = static_cast<int>(size()); searchIndex < sz; ++searchIndex)
+        for(int w = 0; w < words; ++w)
         {
-            if (m_break) break;
-            if (!contains(searchIndex))
-            {
-                int n = s->matches(searchIndex);
-                if (n)
-                {
-                    set(searchIndex, n);
-                }
-            }
-            if (searchIndex % 1024 == 0) emit searchProgress(searchIndex*100/size());
+            bits[w] |= match[w];
         }
         break;
     case FilterOperator::Remove:
-        for(int searchIndex = 0, sz = static_cast<int>(size()); searchIndex < sz; ++searchIndex)
+        for(int w = 0; w < words; ++w)
         {
-            if (m_break) break;
-            if (contains(searchIndex) && s->matches(searchIndex))
-            {
-                set(searchIndex, 0);
-            }
-            if (searchIndex % 1024 == 0) emit searchProgress(searchIndex*100/size());
+            bits[w] &= ~match[w];
         }
         break;
     default:
         break;
     }
+    if (op != FilterOperator::Remove)
+    {
+        for (const QHash<GameId, value_type>& chunkPositions : qAsConst(m_searchPositions))
+        {
+            for(auto it = chunkPositions.cbegin(); it != chunkPositions.cend(); ++it)
+            {
+                m_positions.insert(it.key(), it.value());
+            }
+        }
+    }
+    m_searchMatches.clear();
+    m_searchPositions.clear();
+    prunePositions();
+    recount();
 }
 
 void FilterX::run()
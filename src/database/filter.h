@@ -12,10 +12,13 @@
 #ifndef FILTER_H_INCLUDED
 #define FILTER_H_INCLUDED
 
+#include <QAtomicInt>
 #include <QBitArray>
+#include <QHash>
 #include <QPair>
 #include <QPointer>
 #include <QThread>
+#include <QVector>
 
 #include "gameid.h"
 #include "filteroperator.h"
@@ -27,6 +30,12 @@ class Database;
    The FilterX class represents a set of games. It is always associated with
    some Database object. On creation it has the same size as database,
    but it is not automatically resized when database size changes.
+   Membership is kept in a bitmap of 64 bit words, so combining, inverting
+   and counting filters works on whole words. Only games which are found at
+   a ply other than 1 get an entry in a sparse position table.
+   Searches are run in parallel over ranges of words, each range collecting
+   its matches in its own words of a result bitmap, which is then merged into
+   the filter according to the search operator.
 */
 
 class FilterX : public QThread
@@ -63,12 +72,18 @@ public:
     /** @return number of games in the filter. */
     inline int count() const { return m_count; }
     /** @return the size of the filter. */
-    unsigned int size() const;
+    inline unsigned int size() const { return m_size; }
     /** Resize the filter to the specified size, keeping current content. If the filter is increased,
     added game will be initialized to @p includeNew (by default - not in filter). */
     void resize(unsigned int newsize, bool includeNew = false);
     /** Reverse the filter (complement set). */
     void invert();
+    /** Keep only the games which are also in @p filter. */
+    void intersect(const FilterX& filter);
+    /** Add all games of @p filter, taking over their positions. */
+    void unite(const FilterX& filter);
+    /** Remove all games of @p filter. */
+    void subtract(const FilterX& filter);
     /** Executes search 'search' on database m_database,
        and modifies this filter with the results. */
     void executeSearch(Search *search, FilterOperator searchOperator=FilterOperator::NullOperator);
@@ -78,14 +93,32 @@ signals:
     void searchFinished();
 
 protected:
+    /** Recompute m_count from the bitmap */
+    void recount();
+    /** Clear the bits of the last word which are beyond size() */
+    void maskTail();
+    /** Drop the positions of games which are no longer in the filter */
+    void prunePositions();
+    /** Run @p s on the candidate games of the words [firstWord, endWord[ for operator @p op.
+        Writes the matching games into m_searchMatches and their positions into m_searchPositions[chunk] */
+    void searchWords(Search* s, FilterOperator op, int firstWord, int endWord, int chunk);
 
     int m_count;
-    QVector<value_type>* m_vector;
+    unsigned int m_size;
+    /** One bit per game, set if the game is in the filter */
+    QVector<quint64> m_bits;
+    /** Ply of the games in the filter which are not found at ply 1 */
+    QHash<GameId, value_type> m_positions;
     Database* m_database;
 
     /* Search statistics variables */
     int m_gamesSearched;
     int m_searchTime;
+    QAtomicInt m_wordsSearched;
+    /** Matching games of the running search, one range of words per chunk */
+    QVector<quint64> m_searchMatches;
+    /** Positions of the matching games of the running search, per chunk */
+    QVector<QHash<GameId, value_type> > m_searchPositions;
 
     QPointer<Search> currentSearch;
     FilterOperator currentSearchOperator;
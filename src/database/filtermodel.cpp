@@ -173,6 +173,30 @@ void FilterModel::set(GameId game, int value)
     emit dataChanged(start, end);
 }
 
+void FilterModel::set(const QList<int>& games, const QList<int>& values)
+{
+    int first = -1;
+    int last = -1;
+    int sz = static_cast<int>(filter()->size());
+    for (int i = 0, n = qMin(games.size(), values.size()); i < n; ++i)
+    {
+        int game = games.at(i);
+        if (game < 0 || game >= sz)
+        {
+            continue;
+        }
+        filter()->set(game, values.at(i));
+        if (first < 0 || game < first) first = game;
+        if (game > last) last = game;
+    }
+    if (last >= 0)
+    {
+        QModelIndex start = createIndex(first, 0, (void*) nullptr);
+        QModelIndex end = createIndex(last, columnCount()-1, (void*) nullptr);
+        emit dataChanged(start, end);
+    }
+}
+
 QVariant FilterModel::data(const QModelIndex &index, int role) const
 {
     int sz = static_cast<int>(m_filter->size());
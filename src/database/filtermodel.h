@@ -77,6 +77,8 @@ public:
 
     void updateColumns();
     void set(GameId game, int value);
+    /** Set the filter values of many games, emitting one dataChanged for the range of touched rows */
+    void set(const QList<int>& games, const QList<int>& values);
     static QStringList additionalTags();
 
     void invert();
@@ -10,6 +10,7 @@
 
 #include <QtDebug>
 #include <QFile>
+#include <QStack>
 #include "annotation.h"
 #include "gamecursor.h"
 #include "settings.h"
@@ -62,6 +63,38 @@ GameCursor& GameCursor::operator=(const GameCursor& rhs)
     return *this;
 }
 
+GameCursor::GameCursor(GameCursor&& rhs)
+    : m_currentBoard(rhs.m_currentBoard)
+    , m_nodes(std::move(rhs.m_nodes))
+    , m_currentNode(rhs.m_currentNode)
+    , m_startPly(rhs.m_startPly)
+    , m_startingBoard(rhs.m_startingBoard)
+{
+    if (!m_currentBoard)
+    {
+        m_currentBoard = new BoardX;
+    }
+    rhs.m_currentBoard = nullptr;
+    rhs.clear();
+}
+
+GameCursor& GameCursor::operator=(GameCursor&& rhs)
+{
+    if (this != &rhs)
+    {
+        m_nodes = std::move(rhs.m_nodes);
+        m_currentNode = rhs.m_currentNode;
+        m_startPly = rhs.m_startPly;
+        m_startingBoard = rhs.m_startingBoard;
+        if (m_currentBoard && rhs.m_currentBoard)
+        {
+            std::swap(m_currentBoard, rhs.m_currentBoard);
+        }
+        rhs.clear();
+    }
+    return *this;
+}
+
 GameCursor::~GameCursor()
 {
     unmountBoard();
@@ -90,9 +123,19 @@ void GameCursor::unmountBoard()
     }
 }
 
-void GameCursor::clear()
+void GameCursor::clearNodes()
 {
+    // Reserve the previous size again: clear() frees the nodes when they are
+    // shared with a copy of the cursor, as after an undo snapshot, and with Qt 5
+    // before 5.7. Games loaded one after another then reuse a single allocation.
+    int capacity = m_nodes.capacity();
     m_nodes.clear();
+    m_nodes.reserve(capacity);
+}
+
+void GameCursor::clear()
+{
+    clearNodes();
     m_startingBoard.setStandardPosition();
     m_startPly = 0;
     initCursor();
@@ -100,7 +143,7 @@ void GameCursor::clear()
 
 void GameCursor::clear(const QString& fen, bool chess960)
 {
-    m_nodes.clear();
+    clearNodes();
     m_startingBoard.setChess960(chess960);
     m_startingBoard.fromFen(fen);
     m_startPly = (m_startingBoard.moveNumber() - 1) * 2 + (m_startingBoard.toMove() == Black);
@@ -148,14 +191,50 @@ int GameCursor::variationCount(MoveId moveId) const
     MoveId node = makeNodeIndex(moveId);
     if(node != NO_MOVE)
     {
-        return m_nodes[node].variations.size();
+        int count = 0;
+        for (MoveId v = m_nodes[node].firstVariation; v != NO_MOVE; v = m_nodes[v].nextVariation)
+        {
+            ++count;
+        }
+        return count;
     }
     return 0;
 }
 
-const QList<MoveId>& GameCursor::variations() const
+QList<MoveId> GameCursor::variations(MoveId moveId) const
 {
-    return m_nodes[m_currentNode].variations;
+    QList<MoveId> list;
+    for (MoveId v = m_nodes[moveId].firstVariation; v != NO_MOVE; v = m_nodes[v].nextVariation)
+    {
+        list.append(v);
+    }
+    return list;
+}
+
+void GameCursor::setVariations(MoveId moveId, const QList<MoveId>& variations)
+{
+    MoveId* link = &m_nodes[moveId].firstVariation;
+    for (MoveId v: variations)
+    {
+        *link = v;
+        link = &m_nodes[v].nextVariation;
+    }
+    *link = NO_MOVE;
+}
+
+void GameCursor::unlinkVariation(MoveId moveId, MoveId variation)
+{
+    MoveId* link = &m_nodes[moveId].firstVariation;
+    while (*link != NO_MOVE)
+    {
+        if (*link == variation)
+        {
+            *link = m_nodes[variation].nextVariation;
+            m_nodes[variation].nextVariation = NO_MOVE;
+            return;
+        }
+        link = &m_nodes[*link].nextVariation;
+    }
 }
 
 bool GameCursor::isMainline(MoveId moveId) const
@@ -332,7 +411,7 @@ MoveId GameCursor::variationBranchPoint(MoveId variation) const
         MoveId prevNode = variation;
         while ((prevNode = m_nodes[prevNode].previousNode) != NO_MOVE)
         {
-            if (m_nodes[prevNode].variations.size())
+            if (m_nodes[prevNode].firstVariation != NO_MOVE)
             {
                 branch = prevNode;
                 break;
@@ -445,7 +524,7 @@ bool GameCursor::moveToEnd()
 
 void GameCursor::moveIntoVariation(MoveId moveId)
 {
-    Q_ASSERT(variations().contains(moveId));
+    Q_ASSERT(m_nodes[moveId].parentNode == m_currentNode);
     m_currentBoard->doMove(m_nodes[moveId].move);
     m_currentNode = moveId;
 }
@@ -480,7 +559,12 @@ MoveId GameCursor::addVariation(const Move& move)
     auto saveNextNode = m_nodes[m_currentNode].nextNode;
     auto node = addMove(move);
     m_nodes[m_currentNode].parentNode = previousNode;
-    m_nodes[previousNode].variations.append(node);
+    MoveId* link = &m_nodes[previousNode].firstVariation;
+    while (*link != NO_MOVE)
+    {
+        link = &m_nodes[*link].nextVariation;
+    }
+    *link = node;
     m_nodes[previousNode].nextNode = saveNextNode;
     return node;
 }
@@ -503,7 +587,7 @@ void GameCursor::remove(MoveId moveId, QList<MoveId>* removed)
     {
         removed->append(node);
     }
-    for (auto v: qAsConst(m_nodes[node].variations))
+    for (MoveId v = m_nodes[node].firstVariation; v != NO_MOVE; v = m_nodes[v].nextVariation)
     {
         remove(v, removed);
     }
@@ -525,7 +609,7 @@ void GameCursor::truncateFrom(MoveId moveId, QList<MoveId>* removed)
     if (node == NO_MOVE)
         return;
     remove(m_nodes[node].nextNode, removed);
-    for (auto v: qAsConst(m_nodes[node].variations))
+    for (MoveId v = m_nodes[node].firstVariation; v != NO_MOVE; v = m_nodes[v].nextVariation)
     {
         remove(v, removed);
     }
@@ -552,8 +636,8 @@ void GameCursor::truncateUpto(MoveId moveId, QList<MoveId>* removed)
     // Keep variation if truncating main line
     if(m_nodes[m_nodes[m_currentNode].previousNode].nextNode == m_currentNode)
     {
-        firstNode.variations = m_nodes[m_nodes[m_currentNode].previousNode].variations;
-        foreach(MoveId var, firstNode.variations)
+        firstNode.firstVariation = m_nodes[m_nodes[m_currentNode].previousNode].firstVariation;
+        for (MoveId var = firstNode.firstVariation; var != NO_MOVE; var = m_nodes[var].nextVariation)
         {
             reparentVariation(var, 0);
             m_nodes[var].previousNode = 0;
@@ -584,8 +668,11 @@ void GameCursor::promoteVariation(MoveId variation)
     reparentVariation(variation, m_nodes[parent].parentNode);
 
     // Swap main line and the variation
-    int index = m_nodes[parent].variations.indexOf(variation);
-    qSwap(m_nodes[parent].nextNode, m_nodes[parent].variations[index]);
+    QList<MoveId> vars = variations(parent);
+    int index = vars.indexOf(variation);
+    qSwap(m_nodes[parent].nextNode, vars[index]);
+    setVariations(parent, vars);
+    m_nodes[m_nodes[parent].nextNode].nextVariation = NO_MOVE;
     moveToId(save);
 }
 
@@ -597,7 +684,7 @@ bool GameCursor::canMoveVariationUp(MoveId moveId) const
     auto variation = variationNumber(moveId);
     auto parentNode = m_nodes[moveId].parentNode;
 
-    auto& vars = m_nodes[parentNode].variations;
+    auto vars = variations(parentNode);
     int i = vars.indexOf(variation);
     return i > 0;
 }
@@ -610,7 +697,7 @@ bool GameCursor::canMoveVariationDown(MoveId moveId) const
     auto variation = variationNumber(moveId);
     auto parentNode = m_nodes[moveId].parentNode;
 
-    auto& vars = m_nodes[parentNode].variations;
+    auto vars = variations(parentNode);
     int i = vars.indexOf(variation);
     return 0 <= i && i + 1 < vars.size();
 }
@@ -623,12 +710,13 @@ bool GameCursor::moveVariationUp(MoveId moveId)
     auto variation = variationNumber(moveId);
     auto parentNode = m_nodes[moveId].parentNode;
 
-    auto& vars = m_nodes[parentNode].variations;
+    auto vars = variations(parentNode);
     int i = vars.indexOf(variation);
     auto possible = i > 0;
     if (possible)
     {
         vars.swapItemsAt(i, i - 1);
+        setVariations(parentNode, vars);
     }
     return possible;
 }
@@ -641,12 +729,13 @@ bool GameCursor::moveVariationDown(MoveId moveId)
     auto variation = variationNumber(moveId);
     auto parentNode = m_nodes[moveId].parentNode;
 
-    auto& vars = m_nodes[parentNode].variations;
+    auto vars = variations(parentNode);
     int i = vars.indexOf(variation);
     auto possible = 0 <= i && i + 1 < vars.size();
     if (possible)
     {
         vars.swapItemsAt(i, i + 1);
+        setVariations(parentNode, vars);
     }
     return possible;
 }
@@ -662,9 +751,7 @@ bool GameCursor::removeVariation(MoveId variation)
     remove(variation);
     moveToId(parentNode);
 
-    QList<MoveId> &vars = m_nodes[m_currentNode].variations;
-    int n = vars.indexOf(variation);
-    vars.removeAt(n);
+    unlinkVariation(m_currentNode, variation);
     return true;
 }
 
@@ -672,9 +759,9 @@ void GameCursor::removeVariations()
 {
     for(int i = 0; i < m_nodes.size(); ++i)
     {
-        while (!m_nodes[i].variations.empty())
+        while (m_nodes[i].firstVariation != NO_MOVE)
         {
-            removeVariation(m_nodes[i].variations.at(0));
+            removeVariation(m_nodes[i].firstVariation);
         }
     }
 }
@@ -696,15 +783,12 @@ void GameCursor::removeNullLines()
                     // This is the first move of an empty variation
                     MoveId parentNode = m_nodes[self].parentNode;
                     remove(self);
-                    QList<MoveId> &vars = m_nodes[parentNode].variations;
-                    int n = vars.indexOf(self);
-                    vars.removeAt(n);
+                    unlinkVariation(parentNode, self);
                  }
                 else
                 {
                     MoveId previousNode = m_nodes[self].previousNode;
-                    QList<MoveId> &vars = m_nodes[previousNode].variations;
-                    if (vars.isEmpty())
+                    if (m_nodes[previousNode].firstVariation == NO_MOVE)
                     {
                         // This is an empty move at the end of a line
                         m_nodes[previousNode].nextNode = NO_MOVE;
@@ -714,11 +798,11 @@ void GameCursor::removeNullLines()
                     {
                         // There are siblings - swap with first sibling and remove
                         MoveId parentNode = m_nodes[self].parentNode;
-                        int variation = vars.at(0);
+                        MoveId variation = m_nodes[previousNode].firstVariation;
                         reparentVariation(variation, parentNode);
                         node.remove();
                         m_nodes[previousNode].nextNode = variation;
-                        vars.removeAt(0);
+                        unlinkVariation(previousNode, variation);
                     }
                 }
             }
@@ -772,6 +856,25 @@ QMap<MoveId, MoveId> GameCursor::compact()
     // map NO_MOVE for simplicity
     renames[NO_MOVE] = NO_MOVE;
 
+    // drop removed nodes from the variation chains while the indices are still valid
+    for (auto& node: m_nodes)
+    {
+        if (node.Removed())
+            continue;
+        MoveId* link = &node.firstVariation;
+        while (*link != NO_MOVE)
+        {
+            if (*link == ROOT_NODE || m_nodes[*link].Removed())
+            {
+                *link = m_nodes[*link].nextVariation;
+            }
+            else
+            {
+                link = &m_nodes[*link].nextVariation;
+            }
+        }
+    }
+
     // arena ends
     auto ib = m_nodes.cbegin(), ie = m_nodes.cend();
     // read iterator
@@ -803,12 +906,8 @@ QMap<MoveId, MoveId> GameCursor::compact()
         node.nextNode = renames[node.nextNode];
         node.previousNode = renames[node.previousNode];
         node.parentNode = renames[node.parentNode];
-        for (auto& v: node.variations)
-        {
-            v = renames[v];
-        }
-        node.variations.removeAll(NO_MOVE);
-        node.variations.removeAll(ROOT_NODE);
+        node.firstVariation = renames[node.firstVariation];
+        node.nextVariation = renames[node.nextVariation];
     }
     m_currentNode = renames[m_currentNode];
     return renames;
@@ -850,11 +949,102 @@ void GameCursor::dumpMoveNode(MoveId moveId) const
         qDebug() << "   Prev node   : " << m_nodes.at(moveId).previousNode;
         qDebug() << "   Parent node : " << m_nodes.at(moveId).parentNode;
         qDebug() << "   Deleted     : " << m_nodes.at(moveId).Removed();
-        qDebug() << "   # Variations: " << m_nodes.at(moveId).variations.size();
-        qDebug() << "   Variations  : " << m_nodes.at(moveId).variations;
+        qDebug() << "   # Variations: " << variationCount(moveId);
+        qDebug() << "   Variations  : " << variations(moveId);
         qDebug() << "   Move        : " << m_nodes.at(moveId).move.toAlgebraic()
                  << " (" << m_nodes.at(moveId).move.rawMove()
                  << ", " << m_nodes.at(moveId).move.rawUndo()
                  << ")";
     }
 }
+
+GameCursorView::GameCursorView()
+    : m_cursor(nullptr)
+    , m_board()
+    , m_currentNode(NO_MOVE)
+{
+}
+
+GameCursorView::GameCursorView(const GameCursor& cursor)
+{
+    reset(cursor);
+}
+
+void GameCursorView::reset(const GameCursor& cursor)
+{
+    m_cursor = &cursor;
+    if (cursor.currentBoard() && cursor.currMove() != NO_MOVE)
+    {
+        m_board = *cursor.currentBoard();
+        m_currentNode = cursor.currMove();
+    }
+    else
+    {
+        moveToStart();
+    }
+}
+
+bool GameCursorView::forward()
+{
+    MoveId next = m_cursor->nextMove(m_currentNode);
+    if (next == NO_MOVE)
+    {
+        return false;
+    }
+    m_currentNode = next;
+    m_board.doMove(m_cursor->moveAt(m_currentNode));
+    return true;
+}
+
+bool GameCursorView::backward()
+{
+    MoveId prev = m_cursor->prevMove(m_currentNode);
+    if (prev < 0)
+    {
+        return false;
+    }
+    m_board.undoMove(m_cursor->moveAt(m_currentNode));
+    m_currentNode = prev;
+    return true;
+}
+
+void GameCursorView::moveToStart()
+{
+    m_currentNode = ROOT_NODE;
+    m_board = m_cursor->initialBoard();
+}
+
+void GameCursorView::moveToEnd()
+{
+    if (!m_cursor->isMainline(m_currentNode))
+    {
+        moveToStart();
+    }
+    while (forward())
+    {
+    }
+}
+
+bool GameCursorView::moveToId(MoveId moveId)
+{
+    moveId = m_cursor->makeNodeIndex(moveId);
+    if (moveId == NO_MOVE)
+    {
+        return false;
+    }
+    if (moveId != m_currentNode)
+    {
+        QStack<Move> moveStack;
+        for (MoveId node = moveId; node; node = m_cursor->prevMove(node))
+        {
+            moveStack.push(m_cursor->moveAt(node));
+        }
+        m_board = m_cursor->initialBoard();
+        while (!moveStack.isEmpty())
+        {
+            m_board.doMove(moveStack.pop());
+        }
+        m_currentNode = moveId;
+    }
+    return true;
+}
@@ -2,6 +2,7 @@
 #define GAMECURSOR_H
 
 #include <QObject>
+#include <QVector>
 #include "board.h"
 #include "move.h"
 
@@ -16,18 +17,25 @@ typedef int MoveId;
 class GameCursor
 {
 public:
+    /** A node of the move tree.
+        Nodes are plain values kept in one contiguous array. The variations
+        branching off a node are chained through their first moves:
+        firstVariation points to the first one, and each first move points
+        to the next sibling with nextVariation.
+     */
     struct Node
     {
         MoveId previousNode;
         MoveId nextNode;
         MoveId parentNode;
+        MoveId firstVariation;
+        MoveId nextVariation;
         short m_ply;
         Move move;
-        QList<MoveId> variations;
         void remove()
         {
-            parentNode = previousNode = nextNode = NO_MOVE;
-            variations.clear();
+            // nextVariation is kept, so that the sibling chain stays intact until compact()
+            parentNode = previousNode = nextNode = firstVariation = NO_MOVE;
             setRemoved();
         }
         void setRemoved()
@@ -37,7 +45,7 @@ public:
         Node()
         {
             parentNode = nextNode = previousNode = NO_MOVE;
-            variations.clear();
+            firstVariation = nextVariation = NO_MOVE;
             m_ply = 0;
         }
         void SetPly(short ply) { Q_ASSERT(m_ply<0x7FFF); m_ply = ply; }
@@ -46,7 +54,8 @@ public:
         inline bool operator==(const struct Node& c) const
         {
             return (move == c.move &&
-                    variations == c.variations &&
+                    firstVariation == c.firstVariation &&
+                    nextVariation == c.nextVariation &&
                     m_ply == c.m_ply);
         }
     };
@@ -54,9 +63,12 @@ public:
     GameCursor();
     GameCursor(const GameCursor& rhs);
     GameCursor& operator=(const GameCursor& rhs);
-    // TODO: maybe implement moving constructor/assignment later
-    GameCursor(GameCursor&& rhs) = delete;
-    GameCursor& operator=(GameCursor&& rhs) = delete;
+    /** Takes over the nodes and the board of @p rhs, which is left empty and unmounted */
+    GameCursor(GameCursor&& rhs);
+    /** Takes over the nodes of @p rhs, which is left empty.
+        The board is only exchanged if both cursors are mounted, as for the copy assignment.
+     */
+    GameCursor& operator=(GameCursor&& rhs);
     ~GameCursor();
 
     /** @returns initial position */
@@ -68,7 +80,7 @@ public:
 
     void unmountBoard();
 
-    /** Re-initialize all fields  */
+    /** Re-initialize all fields, the node storage is kept for reuse */
     void clear();
     void clear(const QString& fen, bool chess960 = false);
 
@@ -82,6 +94,7 @@ public:
     /** @return the move at node @p moveId. */
     Move move(MoveId moveId = CURRENT_MOVE) const;
     Move& moveAt(MoveId moveId) { return m_nodes[moveId].move; }
+    const Move& moveAt(MoveId moveId) const { return m_nodes[moveId].move; }
     /** @return current move id. */
     MoveId currMove() const { return m_currentNode; }
     /** @return moveId of the previous move */
@@ -96,8 +109,12 @@ public:
     /** @return number of variations at the current position */
     int variationCount(MoveId moveId = CURRENT_MOVE) const;
     /** @return list of variation at the current move */
-    const QList<MoveId>& variations() const;
-    const QList<MoveId>& variations(MoveId moveId) const { return m_nodes[moveId].variations; }
+    QList<MoveId> variations() const { return variations(m_currentNode); }
+    QList<MoveId> variations(MoveId moveId) const;
+    /** @return first move of the first variation at node @p moveId, or NO_MOVE */
+    MoveId firstVariation(MoveId moveId) const { return m_nodes[moveId].firstVariation; }
+    /** @return first move of the variation following @p variation, or NO_MOVE */
+    MoveId nextVariation(MoveId variation) const { return m_nodes[variation].nextVariation; }
     /** @returns amount of allocated nodes */
     int capacity() const { return m_nodes.size(); }
 
@@ -198,11 +215,15 @@ public:
     /** compare game moves and annotations */
     int isEqual(const GameCursor& rhs) const { return m_nodes == rhs.m_nodes; }
 
+private:
+    /** Remove all nodes, keeping an allocation of the same capacity */
+    void clearNodes();
+
 private:
     /** Keeps the current position of the game */
     BoardX* m_currentBoard;
-    /** List of nodes */
-    QList<Node> m_nodes;
+    /** Node arena, its capacity is kept when the cursor is cleared */
+    QVector<Node> m_nodes;
     /** Keeps the current node in the game */
     MoveId m_currentNode;
     /** Keeps the start ply of the game, 0 for standard starting position */
@@ -211,6 +232,55 @@ private:
     BoardX m_startingBoard;
 
     void initCursor();
+    /** Relink the variations of @p moveId to @p variations, in that order */
+    void setVariations(MoveId moveId, const QList<MoveId>& variations);
+    /** Unlink @p variation from the variations of @p moveId */
+    void unlinkVariation(MoveId moveId, MoveId variation);
+};
+
+/** A read-only traversal of the moves of a GameCursor.
+    The view keeps its own board and current node, so a const game can be
+    walked without copying its move tree. The viewed cursor must outlive the
+    view and must not be modified while the view is in use.
+*/
+class GameCursorView
+{
+public:
+    GameCursorView();
+    /** Creates a view positioned at the current move of @p cursor */
+    explicit GameCursorView(const GameCursor& cursor);
+
+    /** Attaches the view to @p cursor, positioned at its current move */
+    void reset(const GameCursor& cursor);
+
+    /** @return the viewed cursor */
+    const GameCursor& cursor() const { return *m_cursor; }
+    /** @return the position at the current node of the view */
+    const BoardX& board() const { return m_board; }
+    /** @return current move id of the view */
+    MoveId currMove() const { return m_currentNode; }
+    /** @return moveId of the next move */
+    MoveId nextMove() const { return m_cursor->nextMove(m_currentNode); }
+    /** @return moveId of the parent node */
+    MoveId parentMove() const { return m_cursor->parentMove(m_currentNode); }
+    /** @return list of variations at the current node */
+    QList<MoveId> variations() const { return m_cursor->variations(m_currentNode); }
+
+    /** Moves one move forward along the current line, returns false at the end of the line */
+    bool forward();
+    /** Moves one move back, returns false at the start of the game */
+    bool backward();
+    /** Moves to the start position */
+    void moveToStart();
+    /** Moves to the end of the main line */
+    void moveToEnd();
+    /** Moves to the position corresponding to the given move id */
+    bool moveToId(MoveId moveId);
+
+private:
+    const GameCursor* m_cursor;
+    BoardX m_board;
+    MoveId m_currentNode;
 };
 
 #endif // GAMECURSOR_H
@@ -0,0 +1,161 @@
+#include "gamestatistics.h"
+#include "index.h"
+#include "tags.h"
+
+#include <climits>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+/** Dates of the year 1000 and before are ignored, as by the player and event statistics */
+const qint32 MinimumDate = PartialDate(1001).toPacked();
+
+static qint8 parseHalfPoints(const QString& s)
+{
+    if (s.startsWith("1/2"))
+    {
+        return 1;
+    }
+    else if (s.startsWith('1') || s.startsWith("+-"))
+    {
+        return 2;
+    }
+    else if (s.startsWith('0') || s.startsWith("-+") || s.startsWith("--+"))
+    {
+        return 0;
+    }
+    return -1;
+}
+
+/** Fill @p column with the values of @p tagName decoded by @p parse, which is called once per distinct value */
+template<class T, class Parse>
+static void decodeColumn(const IndexX* index, const QString& tagName, int count, QVector<T>& column, Parse parse)
+{
+    QVector<ValueIndex> values = index->valueIndexColumn(tagName);
+    values.resize(count);
+    QHash<ValueIndex, T> decoded;
+    column.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        typename QHash<ValueIndex, T>::const_iterator it = decoded.constFind(values[i]);
+        if (it == decoded.constEnd())
+        {
+            it = decoded.insert(values[i], parse(index->valueName(values[i])));
+        }
+        column[i] = *it;
+    }
+}
+
+GameStatistics::GameStatistics() :
+    m_index(nullptr),
+    m_revision(0)
+{
+}
+
+void GameStatistics::update(const IndexX* index)
+{
+    if (index && index == m_index && index->revision() == m_revision)
+    {
+        return;
+    }
+
+    m_index = index;
+    for (int e = 0; e < EntityCount; ++e)
+    {
+        m_values[e].clear();
+        m_games[e].clear();
+    }
+    m_results.clear();
+    m_halfPoints.clear();
+    m_elo[White].clear();
+    m_elo[Black].clear();
+    m_dates.clear();
+    if (!index)
+    {
+        return;
+    }
+    m_revision = index->revision();
+
+    const char* const tagNames[EntityCount] = { TagNameWhite, TagNameBlack, TagNameEvent, TagNameECO };
+    for (int e = 0; e < EntityCount; ++e)
+    {
+        m_values[e] = index->valueIndexColumn(tagNames[e]);
+    }
+    // Games added meanwhile are left to the next update
+    int count = m_values[0].count();
+    for (int e = 0; e < EntityCount; ++e)
+    {
+        m_values[e].resize(count);
+        QHash<ValueIndex, QVector<GameId> >& games = m_games[e];
+        for (int i = 0; i < count; ++i)
+        {
+            games[m_values[e][i]].append(i);
+        }
+    }
+
+    decodeColumn(index, TagNameResult, count, m_halfPoints, parseHalfPoints);
+    m_results = index->resultColumn();
+    m_results.resize(count);
+    m_elo[White] = index->eloColumn(White);
+    m_elo[White].resize(count);
+    m_elo[Black] = index->eloColumn(Black);
+    m_elo[Black].resize(count);
+    m_dates = index->dateColumn();
+    m_dates.resize(count);
+}
+
+const QVector<GameId>& GameStatistics::games(Entity entity, ValueIndex value) const
+{
+    static const QVector<GameId> none;
+    QHash<ValueIndex, QVector<GameId> >::const_iterator it = m_games[entity].constFind(value);
+    return it == m_games[entity].constEnd() ? none : *it;
+}
+
+PartialDate GameStatistics::date(GameId game) const
+{
+    return PartialDate::fromPacked(m_dates[game]);
+}
+
+void GameStatistics::countResults(const QVector<GameId>& games, int result[4]) const
+{
+    for (GameId game : games)
+    {
+        ++result[m_results[game]];
+    }
+}
+
+void GameStatistics::ratingRange(const QVector<GameId>& games, Color color, int& min, int& max) const
+{
+    const QVector<qint16>& elo = m_elo[color];
+    for (GameId game : games)
+    {
+        int rating = elo[game];
+        if (rating)
+        {
+            min = qMin(rating, min);
+            max = qMax(rating, max);
+        }
+    }
+}
+
+void GameStatistics::dateRange(const QVector<GameId>& games, PartialDate& min, PartialDate& max) const
+{
+    qint32 first = INT_MAX;
+    qint32 last = 0;
+    for (GameId game : games)
+    {
+        qint32 date = m_dates[game];
+        if (date >= MinimumDate)
+        {
+            first = qMin(date, first);
+            last = qMax(date, last);
+        }
+    }
+    if (last)
+    {
+        min = qMin(PartialDate::fromPacked(first), min);
+        max = qMax(PartialDate::fromPacked(last), max);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef GAMESTATISTICS_H
+#define GAMESTATISTICS_H
+
+#include <QHash>
+#include <QVector>
+
+#include "gameid.h"
+#include "indexitem.h"
+#include "partialdate.h"
+#include "piece.h"
+#include "result.h"
+
+class IndexX;
+
+/** @ingroup Database
+ * Typed columns of the game headers of an index, and for each player, event
+ * and ECO code the list of its games.
+ *
+ * The results, ratings and dates are taken from the numeric columns of the
+ * index, the lists of games are built in a single pass over it. The statistics of
+ * a player, event or opening are then reductions over its list of games,
+ * which only read the numeric columns.
+ */
+class GameStatistics
+{
+public:
+    /** Tags of which the games of each value are listed */
+    enum Entity { WhitePlayer, BlackPlayer, Event, Opening, EntityCount };
+
+    GameStatistics();
+
+    /** Bring the columns up to date with @p index, if it was modified since the last update */
+    void update(const IndexX* index);
+
+    /** @return the revision of the index the columns were computed from */
+    quint32 revision() const { return m_revision; }
+    /** @return the values of the tag of @p entity which occur in some game */
+    QList<ValueIndex> values(Entity entity) const { return m_games[entity].keys(); }
+    /** @return the games in which the tag of @p entity has the value @p value */
+    const QVector<GameId>& games(Entity entity, ValueIndex value) const;
+    /** @return the value of the tag of @p entity in @p game */
+    ValueIndex value(Entity entity, GameId game) const { return m_values[entity][game]; }
+    /** @return the result of @p game */
+    Result result(GameId game) const { return Result(m_results[game]); }
+    /** @return the points of White in @p game in half points, or -1 if the game was not decided */
+    int whiteHalfPoints(GameId game) const { return m_halfPoints[game]; }
+    /** @return the rating of @p color in @p game, 0 if there is none */
+    int elo(GameId game, Color color) const { return m_elo[color][game]; }
+    /** @return the date of @p game */
+    PartialDate date(GameId game) const;
+
+    /** Add the number of games with each result in @p games to @p result */
+    void countResults(const QVector<GameId>& games, int result[4]) const;
+    /** Extend [@p min, @p max] by the ratings of @p color in @p games, ignoring missing ratings */
+    void ratingRange(const QVector<GameId>& games, Color color, int& min, int& max) const;
+    /** Extend [@p min, @p max] by the dates of @p games, ignoring dates before the year 1000 */
+    void dateRange(const QVector<GameId>& games, PartialDate& min, PartialDate& max) const;
+
+private:
+    const IndexX* m_index;
+    quint32 m_revision;
+    QVector<ValueIndex> m_values[EntityCount];
+    QHash<ValueIndex, QVector<GameId> > m_games[EntityCount];
+    QVector<quint8> m_results;
+    QVector<qint8> m_halfPoints;
+    QVector<qint16> m_elo[2];
+    /** Dates packed by PartialDate::toPacked() */
+    QVector<qint32> m_dates;
+};
+
+#endif // GAMESTATISTICS_H
@@ -98,6 +98,31 @@ GameX& GameX::operator=(const GameX& game)
     return *this;
 }
 
+GameX::GameX(GameX&& game)
+    : GameX()
+{
+    *this = std::move(game);
+}
+
+GameX& GameX::operator=(GameX&& game)
+{
+    if (this != &game)
+    {
+        bool mounted = game.m_moves.currentBoard() != nullptr;
+        m_moves = std::move(game.m_moves);
+        m_variationStartAnnotations = std::move(game.m_variationStartAnnotations);
+        m_annotations = std::move(game.m_annotations);
+        m_nags = std::move(game.m_nags);
+        m_tags = std::move(game.m_tags);
+        m_needsCleanup = game.m_needsCleanup;
+        if (m_moves.currentBoard() && !mounted)
+        {
+            moveToStart();
+        }
+    }
+    return *this;
+}
+
 GameX::~GameX()
 {
 }
@@ -410,8 +435,17 @@ bool GameX::positionRepetition(const BoardX& b)
 
 bool GameX::positionRepetition3(const BoardX& b) const
 {
-    GameX g = *this;
-    return g.positionRepetition(b);
+    GameCursorView view(m_moves);
+    int repCount = 1;
+    while(view.backward())
+    {
+        if (view.board() == b)
+        {
+            repCount++;
+            if (repCount >= 3) break;
+        }
+    }
+    return repCount >= 3;
 }
 
 bool GameX::insufficientMaterial(const BoardX& b) const
@@ -468,7 +502,7 @@ bool GameX::currentNodeHasVariation(Square from, Square to) const
     return false;
 }
 
-const QList<MoveId>& GameX::currentVariations() const
+QList<MoveId> GameX::currentVariations() const
 {
     return m_moves.variations();
 }
@@ -1293,12 +1327,12 @@ QString GameX::specAnnotations(MoveId moveId, Position position) const
 
 GameX::AnnotationFilter GameX::textFilter() const
 {
-    return AppSettings->getValue("/GameText/HideSpecAnnotations").toBool() ? FilterAll : FilterNone;
+    return AppSettings->snapshot().hideSpecAnnotations ? FilterAll : FilterNone;
 }
 
 GameX::AnnotationFilter GameX::textFilter2() const
 {
-    return AppSettings->getValue("/GameText/HideSpecAnnotations").toBool() ? static_cast<GameX::AnnotationFilter>(GameX::FilterTan | GameX::FilterCan) : FilterNone;
+    return AppSettings->snapshot().hideSpecAnnotations ? static_cast<GameX::AnnotationFilter>(GameX::FilterTan | GameX::FilterCan) : FilterNone;
 }
 
 QString GameX::textAnnotation(MoveId moveId, Position position, AnnotationFilter f) const
@@ -1557,9 +1591,28 @@ void GameX::clear()
     m_nags.clear();
 }
 
+void GameX::reset()
+{
+    clear();
+    clearTags();
+    m_needsCleanup = false;
+}
+
 void GameX::clearTags()
 {
-    m_tags.clear();
+    if (m_tags.isDetached())
+    {
+        // erase instead of clear() to keep the buckets of the hash,
+        // games loaded one after another mostly have the same tags
+        for (auto it = m_tags.begin(); it != m_tags.end();)
+        {
+            it = m_tags.erase(it);
+        }
+    }
+    else
+    {
+        m_tags.clear();
+    }
 }
 
 QString GameX::tag(const QString& tag) const
@@ -1584,9 +1637,10 @@ void GameX::setTag(const QString& tag, const QString& value)
 
 void GameX::setSourceTag(const QString& value)
 {
-    if(AppSettings->getValue("/General/mergeAddSource").toBool())
+    const SettingsSnapshot& settings = AppSettings->snapshot();
+    if(settings.mergeAddSource)
     {
-        setTag(AppSettings->getValue("/General/mergeAddTag").toString(), value);
+        setTag(settings.mergeAddTag, value);
     }
 }
 
@@ -1766,22 +1820,23 @@ void GameX::setNeedsCleanup(bool value)
 
 QString GameX::ecoClassify() const
 {
-    //move to end of main line
-    GameX g = *this;
-    if (g.startingBoard() != BoardX::standardStartBoard)
+    if (startingBoard() != BoardX::standardStartBoard)
     {
-        if (g.isChess960())
+        if (isChess960())
         {
             return QString();
         }
     }
-    g.m_moves.moveToEnd();
+
+    //move to end of main line
+    GameCursorView view(m_moves);
+    view.moveToEnd();
 
     //search backwards for the first eco position
-    while(g.m_moves.backward())
+    while(view.backward())
     {
         QString eco;
-        if (EcoPositions::isEcoPosition(g.board(),eco))
+        if (EcoPositions::isEcoPosition(view.board(),eco))
         {
             return eco;
         }
@@ -1798,22 +1853,59 @@ bool GameX::isEcoPosition() const
 
 void GameX::scoreMaterial(QList<double>& scores) const
 {
-    GameX g = *this;
-    g.moveToStart();
+    QVector<Move> line;
     scores.clear();
+    scoreMaterial(scores, line);
+}
 
-    do
+/** @return the change of the material score by @p move, from the pieces it captures and promotes */
+static int materialChange(const Move& move)
+{
+    int change = -centiPawnValue(move.capturedPiece());
+    if (move.isPromotion())
+    {
+        change += centiPawnValue(move.promotedPiece()) - centiPawnValue(move.pieceMoved());
+    }
+    return change;
+}
+
+void GameX::scoreMaterial(QList<double>& scores, QVector<Move>& line) const
+{
+    double start = m_moves.initialBoard().score();
+    if (scores.isEmpty() || scores[0] != start || scores.count() != line.count() + 1)
+    {
+        scores.clear();
+        line.clear();
+        scores.append(start);
+    }
+
+    // Keep the scores of the unchanged start of the mainline
+    int ply = 0;
+    MoveId node = m_moves.nextMove(ROOT_NODE);
+    while (node != NO_MOVE && ply < line.count() && line[ply] == m_moves.moveAt(node))
+    {
+        ++ply;
+        node = m_moves.nextMove(node);
+    }
+    line.resize(ply);
+    while (scores.count() > ply + 1)
     {
-        int score = g.board().score();
-        scores.append(score);
-    } while(g.forward());
+        scores.removeLast();
+    }
+
+    for (; node != NO_MOVE; node = m_moves.nextMove(node))
+    {
+        const Move& move = m_moves.moveAt(node);
+        scores.append(scores.last() + materialChange(move));
+        line.append(move);
+    }
 }
 
-void GameX::evaluation(double& d) const
+void GameX::evaluation(double& d, MoveId moveId) const
 {
-    QRegularExpression eval(s_eval);
+    static const QRegularExpression eval(s_eval);
     QRegularExpressionMatch match;
-    int pos = annotation().indexOf(eval, 0, &match);
+    int pos = annotation(moveId).indexOf(eval, 0, &match);
     if(pos >= 0)
     {
         QString w = match.captured(2);
@@ -1828,16 +1920,39 @@ void GameX::evaluation(double& d) const
 
 void GameX::scoreEvaluations(QList<double>& evaluations) const
 {
-    GameX g = *this;
-    g.moveToStart();
+    QStringList annotations;
     evaluations.clear();
-    double score = 0.0;
-    g.evaluation(score);
-    evaluations.append(score);
-    while(g.forward())
+    scoreEvaluations(evaluations, annotations);
+}
+
+void GameX::scoreEvaluations(QList<double>& evaluations, QStringList& annotations) const
+{
+    if (evaluations.count() != annotations.count())
+    {
+        evaluations.clear();
+        annotations.clear();
+    }
+
+    // An evaluation holds until the next one, so keep those before the first changed annotation
+    int ply = 0;
+    MoveId node = ROOT_NODE;
+    while (node != NO_MOVE && ply < annotations.count() && annotations[ply] == annotation(node))
+    {
+        ++ply;
+        node = m_moves.nextMove(node);
+    }
+    while (annotations.count() > ply)
+    {
+        annotations.removeLast();
+        evaluations.removeLast();
+    }
+
+    double score = evaluations.isEmpty() ? 0.0 : evaluations.last();
+    for (; node != NO_MOVE; node = m_moves.nextMove(node))
     {
-        g.evaluation(score);
+        evaluation(score, node);
         evaluations.append(score);
+        annotations.append(annotation(node));
     }
 }
 
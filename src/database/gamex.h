@@ -92,6 +92,8 @@ public :
     GameX();
     GameX(const GameX& game);
     GameX& operator=(const GameX& game);
+    GameX(GameX&& game);
+    GameX& operator=(GameX&& game);
     virtual ~GameX();
 
     void unmountBoard() { m_moves.unmountBoard(); }
@@ -171,8 +173,8 @@ public :
     QString specAnnotations(MoveId moveId = CURRENT_MOVE, Position position = AfterMove) const;
     QString specAnnotations(QString s) const;
 
-    /** Get a the current annotation for an evaluation string, d is modified only if there is such an evaluation */
-    void evaluation(double& d) const;
+    /** Get the annotation of @p moveId for an evaluation string, d is modified only if there is such an evaluation */
+    void evaluation(double& d, MoveId moveId = CURRENT_MOVE) const;
 
     /** Adds a nag to move at node @p moveId */
     bool dbAddNag(Nag nag, MoveId moveId = CURRENT_MOVE);
@@ -190,7 +192,7 @@ public :
     MoveId nextMove() const { return m_moves.nextMove(); }
     MoveId parentMove() const { return m_moves.parentMove(); }
     int variationCount(MoveId moveId = CURRENT_MOVE) const { return m_moves.variationCount(moveId); }
-    const QList<MoveId>& variations() const { return m_moves.variations(); }
+    QList<MoveId> variations() const { return m_moves.variations(); }
 
     bool isMainline(MoveId moveId = CURRENT_MOVE) const { return m_moves.isMainline(moveId); }
     bool atLineStart(MoveId moveId = CURRENT_MOVE) const { return m_moves.atLineStart(moveId); }
@@ -300,6 +302,9 @@ public :
     void truncateVariation(Position position = AfterMove);
     /** Removes all tags and moves */
     void clear();
+    /** Removes moves, annotations and tags but keeps the allocated storage,
+        so that a scratch game can be reused for many games in a loop */
+    void reset();
     /** Set the game start position from FEN. */
     void dbSetStartingBoard(const QString& fen, bool chess960 = false);
     /** set comment associated with game */
@@ -318,7 +323,7 @@ public :
     /** Remove all time Comments w/o noticiations */
     void removeTimeCommentsDb();
     /* Manipulating and querying tags */
-    /** Removes all tags */
+    /** Removes all tags, keeping the storage of the tag map if it is not shared */
     void clearTags();
     /** @return value of the given tag */
     QString tag(const QString& tag) const;
@@ -345,11 +350,19 @@ public :
     /** @return true if the move @p from @p to is already in a variation */
     bool currentNodeHasVariation(chessx::Square from, chessx::Square to) const;
     /** Return the list of variations of the current node */
-    const QList<MoveId>& currentVariations() const;
+    QList<MoveId> currentVariations() const;
 
     /** Evaluate a list of scores for the complete game (mainline only) */
     void scoreMaterial(QList<double> &scores) const;
     void scoreEvaluations(QList<double> &evaluations) const;
+    /** Bring @p scores up to date with the mainline. @p line holds the moves the
+        scores were computed for and is updated as well. Only the plies from the
+        first changed move on are scored again, from the material change of each move. */
+    void scoreMaterial(QList<double> &scores, QVector<Move> &line) const;
+    /** Bring @p evaluations up to date with the mainline. @p annotations holds the
+        annotations they were read from, only the plies from the first changed
+        annotation on are evaluated again. */
+    void scoreEvaluations(QList<double> &evaluations, QStringList &annotations) const;
 
     /** @return ECO code for the game */
     QString ecoClassify() const;
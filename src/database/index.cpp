@@ -19,6 +19,8 @@
 #include <QRegularExpression>
 #include <QVector>
 
+#include <algorithm>
+
 #include "index.h"
 #include "tags.h"
 
@@ -29,8 +31,58 @@ using namespace chessx;
 #define new DEBUG_NEW
 #endif // _MSC_VER
 
-IndexX::IndexX() : m_mutex(QReadWriteLock::Recursive)
+/** Names of the tags kept in numeric columns, in the order of IndexX::NumericTag */
+static const char* const NumericTagNames[] = { TagNameWhiteElo, TagNameBlackElo, TagNameDate, TagNameResult, TagNamePlyCount };
+
+/** @return the index of @p tagName in NumericTagNames, or -1 */
+static int numericTagOf(QStringView tagName)
+{
+    for (int t = 0; t < int(sizeof(NumericTagNames) / sizeof(NumericTagNames[0])); ++t)
+    {
+        if (tagName == QLatin1String(NumericTagNames[t]))
+        {
+            return t;
+        }
+    }
+    return -1;
+}
+
+/** @return @p value of the numeric tag @p tag as it is stored in its column */
+static qint32 numericValue(int tag, const QString& value)
+{
+    switch (tag)
+    {
+    case 2: // DateTag
+        return PartialDate(value).toPacked();
+    case 3: // ResultTag
+        return ResultFromString(value);
+    default:
+        return value.toInt();
+    }
+}
+
+/** @return a bit array of the games whose value in @p column is in [@p minValue, @p maxValue] */
+template<class T>
+static QBitArray listColumnInRange(const QVector<T>& column, qint32 minValue, qint32 maxValue)
 {
+    QBitArray list(column.count(), false);
+    for (int i = 0; i < column.count(); ++i)
+    {
+        qint32 value = column[i];
+        if ((minValue <= value) && (value <= maxValue))
+        {
+            list.setBit(i);
+        }
+    }
+    return list;
+}
+
+IndexX::IndexX() : m_revision(0), m_mutex(QReadWriteLock::Recursive)
+{
+    for (int t = 0; t < NumericTagCount; ++t)
+    {
+        m_numericTags[t] = TagNoIndex;
+    }
     // Dummy Values in case a index is miscalculated
     init();
 }
@@ -44,22 +96,54 @@ GameId IndexX::add()
     QWriteLocker m(&m_mutex);
     GameId gameId = m_indexItems.count();
     m_indexItems.insert(gameId, IndexItem());
+    resizeNumericColumns(m_indexItems.count());
+    ++m_revision;
     return gameId;
 }
 
-TagIndex IndexX::AddTagName(const QString& name)
+TagIndex IndexX::AddTagName(QStringView name)
+{
+    quint32 n;
+    if(m_tagNameDictionary.find(name, n))
+    {
+        return n;
+    }
+    QString tagName = name.toString();
+    if(m_tagNameIndex.contains(tagName))
+    {
+        n = m_tagNameIndex.value(tagName);
+    }
+    else
+    {
+        n = m_tagNameIndex.size();
+        m_tagNameIndex[tagName] = n;
+        m_tagNames[n] = tagName;
+        int numericTag = numericTagOf(tagName);
+        if (numericTag >= 0)
+        {
+            m_numericTags[numericTag] = n;
+        }
+    }
+    m_tagNameDictionary.insert(m_tagNames.value(n, tagName), n);
+    return n;
+}
+
+ValueIndex IndexX::AddTagValue(QStringView value)
 {
-    if(m_tagNameIndex.contains(name))
+    ValueIndex n;
+    if (m_valueDictionary.find(value, n))
     {
-        return m_tagNameIndex.value(name);
+        return n;
     }
-    TagIndex n = m_tagNameIndex.size();
-    m_tagNameIndex[name] = n;
-    m_tagNames[n] = name;
+    QString name = value.toString();
+    n = newValueIndex(name);
+    m_tagValues[n] = name;
+    // The dictionary shares the string, a colliding value is found by its text before the '\0'
+    m_valueDictionary.insert(name, n, value.size());
     return n;
 }
 
-ValueIndex IndexX::AddTagValue(QString name)
+ValueIndex IndexX::newValueIndex(QString& name) const
 {
     ValueIndex n = qHash(name);
     if (m_tagValues.contains(n))
@@ -78,16 +162,27 @@ ValueIndex IndexX::AddTagValue(QString name)
             {
                 if (m_tagValues[n] == prelim)
                 {
+                    name = prelim;
                     return n;
                 }
             }
         } while(m_tagValues.contains(n));
         name = prelim;
     }
-    m_tagValues[n] = name;
     return n;
 }
 
+void IndexX::rebuildValueDictionary()
+{
+    m_valueDictionary.clear();
+    m_valueDictionary.reserve(m_tagValues.count());
+    for (auto it = m_tagValues.cbegin(); it != m_tagValues.cend(); ++it)
+    {
+        const QString& value = it.value();
+        m_valueDictionary.insert(value, it.key(), value.indexOf(QChar(0)));
+    }
+}
+
 void IndexX::setTag(const QString& tagName, const QString& value, GameId gameId)
 {
 	QWriteLocker m(&m_mutex); // PERF 10s aus 30s (aus 115s Gesamtdatei) 
@@ -95,6 +190,11 @@ void IndexX::setTag(const QString& tagName, const QString& value, GameId gameId)
 }
 
 void IndexX::setTag_nolock(const QString& tagName, const QString& value, GameId gameId)
+{
+    setTag_nolock(QStringView(tagName), QStringView(value), gameId);
+}
+
+void IndexX::setTag_nolock(QStringView tagName, QStringView value, GameId gameId)
 {
 	TagIndex tagIndex = AddTagName(tagName);
 	ValueIndex valueIndex = AddTagValue(value);
@@ -104,6 +204,24 @@ void IndexX::setTag_nolock(const QString& tagName, const QString& value, GameId
 		(void) add();
 	}
 	m_indexItems[gameId].set(tagIndex, valueIndex);
+	for (int t = 0; t < NumericTagCount; ++t)
+	{
+		if (tagIndex == m_numericTags[t])
+		{
+			setNumericValue(NumericTag(t), numericValue(t, value.toString()), gameId);
+			break;
+		}
+	}
+	++m_revision;
+}
+
+void IndexX::setTagValues(const QString& tagName, const QHash<GameId, QString>& values)
+{
+    QWriteLocker m(&m_mutex);
+    for (auto it = values.cbegin(); it != values.cend(); ++it)
+    {
+        setTag_nolock(tagName, it.value(), it.key());
+    }
 }
 
 void IndexX::removeTag(const QString& tagName, GameId gameId)
@@ -115,6 +233,14 @@ void IndexX::removeTag(const QString& tagName, GameId gameId)
         if((int)gameId < m_indexItems.count())
         {
             m_indexItems[gameId].remove(tagIndex);
+            for (int t = 0; t < NumericTagCount; ++t)
+            {
+                if (tagIndex == m_numericTags[t])
+                {
+                    setNumericValue(NumericTag(t), numericValue(t, QString()), gameId);
+                }
+            }
+            ++m_revision;
         }
     }
 }
@@ -167,7 +293,18 @@ bool IndexX::replaceTagValue(const QStringList& tags, const QString& newValue, c
         i->replaceValue(tl, valueIndex, newIndex);
     }
 
+    // Colliding values are stored as "name\0N" but looked up by name
+    m_valueDictionary.remove(tagValueName(valueIndex), valueIndex);
     m_tagValues.remove(valueIndex);
+    foreach (QString t, tags)
+    {
+        if (numericTagOf(t) >= 0)
+        {
+            calculateNumericColumns();
+            break;
+        }
+    }
+    ++m_revision;
     return true;
 }
 
@@ -186,8 +323,10 @@ bool IndexX::write(QDataStream &out) const
 	out << m_indexItems;
     out << m_validFlags;
 
-    bool extension = false;
+    // The numeric columns follow since VERSION_INDEX_1_7
+    bool extension = true;
     out << extension;
+    out << m_elo[White] << m_elo[Black] << m_dates << m_results << m_plyCounts;
 
     return true;
 }
@@ -195,6 +334,7 @@ bool IndexX::write(QDataStream &out) const
 void IndexX::reserve(quint32 estimation)
 {
     m_tagValues.reserve(estimation+16);
+    m_valueDictionary.reserve(estimation+16);
 }
 
 void IndexX::squeeze()
@@ -204,8 +344,6 @@ void IndexX::squeeze()
 
 bool IndexX::read(QDataStream &in, volatile bool *breakFlag, short version)
 {
-    Q_UNUSED(version);
-
     QWriteLocker m(&m_mutex);
 
     in >> m_tagNames;
@@ -217,6 +355,23 @@ bool IndexX::read(QDataStream &in, volatile bool *breakFlag, short version)
     in >> extension;
 
     m_tagNameIndex.clear();
+    m_tagNameDictionary.clear();
+    rebuildValueDictionary();
+    findNumericTags();
+
+    bool columns = false;
+    if (extension && version >= VERSION_INDEX_1_7)
+    {
+        in >> m_elo[White] >> m_elo[Black] >> m_dates >> m_results >> m_plyCounts;
+        int n = m_indexItems.count();
+        columns = (m_elo[White].count() == n && m_elo[Black].count() == n && m_dates.count() == n &&
+                   m_results.count() == n && m_plyCounts.count() == n);
+    }
+    if (!columns)
+    {
+        calculateNumericColumns();
+    }
+    ++m_revision;
 
     calculateCache(breakFlag);
 
@@ -227,6 +382,7 @@ void IndexX::clearCache()
 {
     QWriteLocker m(&m_mutex);
     m_tagNameIndex.clear();
+    m_tagNameDictionary.clear();
 }
 
 void IndexX::calculateCache(volatile bool* breakFlag)
@@ -251,8 +407,8 @@ void IndexX::calculateReverseMaps(volatile bool* breakFlag)
 
 void IndexX::init()
 {
-    AddTagName("?");
-    AddTagValue("?");
+    AddTagName(u"?");
+    AddTagValue(u"?");
 }
 
 void IndexX::clear()
@@ -262,8 +418,16 @@ void IndexX::clear()
     m_tagNames.clear();
     m_tagNameIndex.clear();
     m_tagValues.clear();
+    m_tagNameDictionary.clear();
+    m_valueDictionary.clear();
     m_deletedGames.clear();
     m_validFlags.clear();
+    for (int t = 0; t < NumericTagCount; ++t)
+    {
+        m_numericTags[t] = TagNoIndex;
+    }
+    resizeNumericColumns(0);
+    ++m_revision;
     init(); // Just to make sure that the index can be used after clearing
 }
 
@@ -315,6 +479,18 @@ QBitArray IndexX::listInRange(const QString &tagName, int minValue, int maxValue
 {
     QReadLocker m(&m_mutex);
 
+    switch (numericTagOf(tagName))
+    {
+    case WhiteEloTag:
+        return listColumnInRange(m_elo[White], minValue, maxValue);
+    case BlackEloTag:
+        return listColumnInRange(m_elo[Black], minValue, maxValue);
+    case PlyCountTag:
+        return listColumnInRange(m_plyCounts, minValue, maxValue);
+    default:
+        break;
+    }
+
     TagIndex tagIndex = m_tagNameIndex.value(tagName);
 
     QBitArray list(count(), false);
@@ -406,31 +582,12 @@ TagIndex IndexX::getTagIndex(const QString& value) const
 
 ValueIndex IndexX::getValueIndex(QString name) const
 {
-    ValueIndex n = qHash(name);
-
-    if (m_tagValues.contains(n))
+    ValueIndex n;
+    if (m_valueDictionary.find(name, n))
     {
-        if (m_tagValues[n] == name)
-        {
-            return n;
-        }
-        name.append(QChar(0));
-        QString prelim;
-        int i = 0;
-        do {
-            prelim = name + QString::number(i++);
-            n = qHash(prelim);
-            if (m_tagValues.contains(n))
-            {
-                if (m_tagValues[n] == prelim)
-                {
-                    return n;
-                }
-            }
-        } while(m_tagValues.contains(n));
+        return n;
     }
-
-    return n;
+    return newValueIndex(name);
 }
 
 unsigned int IndexX::hashIndexItem(GameId gameId) const
@@ -501,6 +658,207 @@ QStringList IndexX::playerNames() const
     return allPlayerNames;
 }
 
+QVector<ValueIndex> IndexX::sortedTagValues(const QStringList& tagNames) const
+{
+    QReadLocker m(&m_mutex);
+
+    QSet<ValueIndex> values;
+    foreach(QString tagName, tagNames)
+    {
+        TagIndex tagIndex = getTagIndex(tagName);
+        if(tagIndex != TagNoIndex)
+        {
+            QVector<IndexItem>::const_iterator i;
+            for (i = m_indexItems.constBegin(); i != m_indexItems.constEnd(); ++i)
+            {
+                values.insert(i->valueIndex(tagIndex));
+            }
+        }
+    }
+
+    QVector<QPair<QString, ValueIndex> > names;
+    names.reserve(values.count());
+    foreach(ValueIndex valueIndex, values)
+    {
+        names.append(qMakePair(tagValueName(valueIndex), valueIndex));
+    }
+    std::sort(names.begin(), names.end(), [](const QPair<QString, ValueIndex>& a, const QPair<QString, ValueIndex>& b)
+    {
+        int c = a.first.compare(b.first, Qt::CaseInsensitive);
+        return c ? c < 0 : a.first < b.first;
+    });
+
+    QVector<ValueIndex> sorted;
+    sorted.reserve(names.count());
+    for (const QPair<QString, ValueIndex>& name : names)
+    {
+        sorted.append(name.second);
+    }
+    return sorted;
+}
+
+QString IndexX::valueName(ValueIndex valueIndex) const
+{
+    QReadLocker m(&m_mutex);
+    return tagValueName(valueIndex);
+}
+
+QStringList IndexX::valueNames(const QVector<ValueIndex>& values) const
+{
+    QReadLocker m(&m_mutex);
+    QStringList names;
+    names.reserve(values.count());
+    for (ValueIndex valueIndex : values)
+    {
+        names.append(tagValueName(valueIndex));
+    }
+    return names;
+}
+
+QVector<ValueIndex> IndexX::valueIndexColumn(const QString& tagName) const
+{
+    QReadLocker m(&m_mutex);
+    TagIndex tagIndex = getTagIndex(tagName);
+    QVector<ValueIndex> column(m_indexItems.count());
+    for (int i = 0; i < m_indexItems.count(); ++i)
+    {
+        column[i] = valueIndexFromIndex(tagIndex, i);
+    }
+    return column;
+}
+
+quint32 IndexX::revision() const
+{
+    QReadLocker m(&m_mutex);
+    return m_revision;
+}
+
+int IndexX::elo(GameId gameId, Color color) const
+{
+    QReadLocker m(&m_mutex);
+    return (int)gameId < m_elo[color].count() ? m_elo[color][gameId] : 0;
+}
+
+PartialDate IndexX::date(GameId gameId) const
+{
+    QReadLocker m(&m_mutex);
+    return PartialDate::fromPacked((int)gameId < m_dates.count() ? m_dates[gameId] : 0);
+}
+
+Result IndexX::result(GameId gameId) const
+{
+    QReadLocker m(&m_mutex);
+    return (int)gameId < m_results.count() ? Result(m_results[gameId]) : ResultUnknown;
+}
+
+int IndexX::plyCount(GameId gameId) const
+{
+    QReadLocker m(&m_mutex);
+    return (int)gameId < m_plyCounts.count() ? m_plyCounts[gameId] : 0;
+}
+
+QVector<qint16> IndexX::eloColumn(Color color) const
+{
+    QReadLocker m(&m_mutex);
+    return m_elo[color];
+}
+
+QVector<qint32> IndexX::dateColumn() const
+{
+    QReadLocker m(&m_mutex);
+    return m_dates;
+}
+
+QVector<quint8> IndexX::resultColumn() const
+{
+    QReadLocker m(&m_mutex);
+    return m_results;
+}
+
+QBitArray IndexX::listInDateRange(const PartialDate& minDate, const PartialDate& maxDate) const
+{
+    QReadLocker m(&m_mutex);
+    return listColumnInRange(m_dates, minDate.toPacked(), maxDate.toPacked());
+}
+
+void IndexX::findNumericTags()
+{
+    for (int t = 0; t < NumericTagCount; ++t)
+    {
+        m_numericTags[t] = TagNoIndex;
+    }
+    for (auto it = m_tagNames.cbegin(); it != m_tagNames.cend(); ++it)
+    {
+        int numericTag = numericTagOf(it.value());
+        if (numericTag >= 0)
+        {
+            m_numericTags[numericTag] = it.key();
+        }
+    }
+}
+
+void IndexX::setNumericValue(NumericTag tag, qint32 value, GameId gameId)
+{
+    if ((int)gameId >= m_results.count())
+    {
+        resizeNumericColumns(gameId + 1);
+    }
+    switch (tag)
+    {
+    case WhiteEloTag:
+        m_elo[White][gameId] = qint16(qBound(0, value, 0x7FFF));
+        break;
+    case BlackEloTag:
+        m_elo[Black][gameId] = qint16(qBound(0, value, 0x7FFF));
+        break;
+    case DateTag:
+        m_dates[gameId] = value;
+        break;
+    case ResultTag:
+        m_results[gameId] = quint8(value);
+        break;
+    case PlyCountTag:
+        m_plyCounts[gameId] = quint16(qBound(0, value, 0xFFFF));
+        break;
+    default:
+        break;
+    }
+}
+
+void IndexX::calculateNumericColumns()
+{
+    resizeNumericColumns(0);
+    resizeNumericColumns(m_indexItems.count());
+    for (int t = 0; t < NumericTagCount; ++t)
+    {
+        if (m_numericTags[t] == TagNoIndex)
+        {
+            continue;
+        }
+        // Each distinct value is converted once
+        QHash<ValueIndex, qint32> values;
+        for (int i = 0; i < m_indexItems.count(); ++i)
+        {
+            ValueIndex valueIndex = valueIndexFromIndex(m_numericTags[t], i);
+            QHash<ValueIndex, qint32>::const_iterator it = values.constFind(valueIndex);
+            if (it == values.constEnd())
+            {
+                it = values.insert(valueIndex, numericValue(t, tagValueName(valueIndex)));
+            }
+            setNumericValue(NumericTag(t), *it, i);
+        }
+    }
+}
+
+void IndexX::resizeNumericColumns(int count)
+{
+    m_elo[White].resize(count);
+    m_elo[Black].resize(count);
+    m_dates.resize(count);
+    m_results.resize(count);
+    m_plyCounts.resize(count);
+}
+
 QSet<ValueIndex> IndexX::tagValueSet(const QString& tagName) const
 {
 	QReadLocker m(&m_mutex);
@@ -537,11 +895,13 @@ QStringList IndexX::tagValues(const QString& tagName) const
 
 bool IndexX::deleted(GameId gameId) const
 {
+    QReadLocker m(&m_mutex);
     return m_deletedGames.contains(gameId);
 }
 
 void IndexX::setDeleted(GameId gameId, bool df)
 {
+    QWriteLocker m(&m_mutex);
     if (df)
     {
         m_deletedGames.insert(gameId);
@@ -550,4 +910,5 @@ void IndexX::setDeleted(GameId gameId, bool df)
     {
         m_deletedGames.remove(gameId);
     }
+    ++m_revision;
 }
@@ -12,6 +12,7 @@
 #ifndef INDEX_H_INCLUDED
 #define INDEX_H_INCLUDED
 
+#include <QBitArray>
 #include <QList>
 #include <QPair>
 #include <QObject>
@@ -21,12 +22,16 @@
 
 #include "indexitem.h"
 #include "gamex.h"
+#include "partialdate.h"
+#include "stringdictionary.h"
 
 #define VERSION_INDEX_1_2 0x0001
 #define VERSION_INDEX_1_3 0x0002
 #define VERSION_INDEX_1_4 0x0101
 #define VERSION_INDEX_1_5 0x0201
-#define VERSION_INDEX_CURRENT VERSION_INDEX_1_5
+#define VERSION_INDEX_1_6 0x0202
+#define VERSION_INDEX_1_7 0x0203
+#define VERSION_INDEX_CURRENT VERSION_INDEX_1_7
 
 #define INDEX_FILE_MAGIC 0xce55
 
@@ -35,6 +40,9 @@
  * for each game in the current database. This enables fast access to
  * game header information.
  *
+ * The ratings, the date, the result and the ply count of each game are
+ * also kept as numbers in columns, so that range searches and statistics
+ * need not parse the tag values.
  */
 
 class IndexX : public QObject
@@ -60,6 +68,10 @@ public:
     void setTag(const QString& tagName, const QString &value, GameId gameId);
 	/** Store the tag value for the given game, tag is given by name w/o locking*/
 	void setTag_nolock(const QString& tagName, const QString &value, GameId gameId);
+    /** Store the tag value for the given game w/o locking, no string is allocated for known names and values */
+    void setTag_nolock(QStringView tagName, QStringView value, GameId gameId);
+    /** Store the values of tag @p tagName for many games at once, locking only once */
+    void setTagValues(const QString& tagName, const QHash<GameId, QString>& values);
 
     /** Set the valid flag accordingly */
     bool replaceTagValue(const QStringList &tags, const QString& newValue, const QString& oldValue);
@@ -98,6 +110,38 @@ public:
     /** Get the list of players (optimized query, as it reads white and black names w/o duplicates) */
     QStringList playerNames() const;
 
+    /** @return the distinct values of the tags @p tagNames, sorted case insensitively by their names */
+    QVector<ValueIndex> sortedTagValues(const QStringList& tagNames) const;
+
+    /** @return the name of the value @p valueIndex */
+    QString valueName(ValueIndex valueIndex) const;
+    /** @return the names of @p values, locking only once */
+    QStringList valueNames(const QVector<ValueIndex>& values) const;
+
+    /** @return the value indexes of tag @p tagName for all games, locking only once */
+    QVector<ValueIndex> valueIndexColumn(const QString& tagName) const;
+
+    /** @return a number which changes whenever games or tags are added or modified */
+    quint32 revision() const;
+
+    // Numeric tags //
+    //
+    /** @return the rating of @p color in game @p gameId, 0 if there is none */
+    int elo(GameId gameId, Color color) const;
+    /** @return the date of game @p gameId */
+    PartialDate date(GameId gameId) const;
+    /** @return the result of game @p gameId */
+    Result result(GameId gameId) const;
+    /** @return the PlyCount tag of game @p gameId, 0 if there is none */
+    int plyCount(GameId gameId) const;
+
+    /** @return the ratings of @p color in all games */
+    QVector<qint16> eloColumn(Color color) const;
+    /** @return the dates of all games, packed by PartialDate::toPacked() */
+    QVector<qint32> dateColumn() const;
+    /** @return the results of all games */
+    QVector<quint8> resultColumn() const;
+
     // Validity of a game information
     //
     /** Set the valid flag accordingly */
@@ -114,6 +158,9 @@ public:
     /** Returns a bit array to indicate which games in index have a tag value in given range */
     QBitArray listInRange(const QString& tag, int minValue, int maxValue) const;
 
+    /** Returns a bit array to indicate which games in index have a date in the given range */
+    QBitArray listInDateRange(const PartialDate& minDate, const PartialDate& maxDate) const;
+
     /** Returns a bit array to indicate which games in index have a tag value which somewhat matches */
     QBitArray listPartialValue(const QString& tagName, QString value) const;
 
@@ -168,10 +215,17 @@ private:
     void calculateReverseMaps(volatile bool *breakFlag);
 
     /** Add a tag name to the index */
-    TagIndex AddTagName(const QString &);
+    TagIndex AddTagName(QStringView name);
 
     /** Add a tag value to the index */
-    ValueIndex AddTagValue(QString);
+    ValueIndex AddTagValue(QStringView value);
+
+    /** Compute the value index for @p name, resolving hash collisions.
+        On return @p name holds the string to be stored for that index. */
+    ValueIndex newValueIndex(QString& name) const;
+
+    /** Rebuild m_valueDictionary from m_tagValues */
+    void rebuildValueDictionary();
 
     /** Query the value of a tag given the tags index for a specific game */
     QString tagValue(TagIndex tagIndex, GameId gameId) const;
@@ -188,6 +242,18 @@ private:
     /** @ret true if a game @p gameId has a given tag index */
     bool indexItemHasTag(TagIndex tagIndex, GameId gameId) const;
 
+    /** Tags which are kept in numeric columns as well */
+    enum NumericTag { WhiteEloTag, BlackEloTag, DateTag, ResultTag, PlyCountTag, NumericTagCount };
+
+    /** Look up the tag indexes of the numeric tags in m_tagNames */
+    void findNumericTags();
+    /** Store @p value of @p tag, as computed from the tag value, for game @p gameId in its column */
+    void setNumericValue(NumericTag tag, qint32 value, GameId gameId);
+    /** Compute all numeric columns from the tag values */
+    void calculateNumericColumns();
+    /** Resize the numeric columns for @p count games */
+    void resizeNumericColumns(int count);
+
 private:
     /** Contains information which games are marked for deletion */
     QSet<GameId> m_deletedGames;
@@ -197,10 +263,23 @@ private:
     QHash<QString, TagIndex> m_tagNameIndex;
     /** Map an Index to a tagValue */
     QHash<ValueIndex, QString> m_tagValues;
+    /** Interned tag names, mapping to their TagIndex */
+    StringDictionary m_tagNameDictionary;
+    /** Interned tag values, mapping to their ValueIndex */
+    StringDictionary m_valueDictionary;
     /** Contains information which games are marked as valid */
     QSet<GameId> m_validFlags;
     /** Hold the list of index items (=holds all game header information) */
     QVector<IndexItem> m_indexItems;
+    /** Incremented by each modification */
+    quint32 m_revision;
+    /** Tag indexes of the numeric tags, TagNoIndex while a tag is unknown */
+    TagIndex m_numericTags[NumericTagCount];
+    /** Numeric columns, one entry per game */
+    QVector<qint16> m_elo[2];
+    QVector<qint32> m_dates;
+    QVector<quint8> m_results;
+    QVector<quint16> m_plyCounts;
 
     mutable QReadWriteLock m_mutex;
 };
@@ -1,90 +1,303 @@
 #include "lichessopening.h"
+#include "board.h"
 #include "networkhelper.h"
-#include "settings.h"
-#include "version.h"
 
-#include <QApplication>
 #include <QByteArray>
-#include <QEventLoop>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QObject>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QStringList>
-#include <QTimer>
-#include <QUrl>
-#include <QJsonDocument>
 
-LichessOpening::LichessOpening()
+#include <algorithm>
+
+using namespace chessx;
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+/** Number of responses kept in memory */
+const int MemoryCacheSize = 2000;
+/** Responses on disk older than this are requested again */
+const int DiskCacheDays = 7;
+
+LichessOpening::LichessOpening() :
+    m_memoryCache(MemoryCacheSize),
+    m_cacheDirectory(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/explorer"),
+    m_replyIsPrefetch(false),
+    m_prefetchCount(3),
+    m_server("http://explorer.lichess.ovh")
 {
+    m_manager = new QNetworkAccessManager(this);
+    connect(m_manager, SIGNAL(finished(QNetworkReply*)), SLOT(replyFinished(QNetworkReply*)));
+    m_coalesceTimer.setSingleShot(true);
+    m_coalesceTimer.setInterval(150);
+    connect(&m_coalesceTimer, SIGNAL(timeout()), SLOT(sendNext()));
 }
 
 LichessOpening::~LichessOpening()
 {
+    // Replies still running are aborted by the manager, nothing must be sent anymore
+    m_manager->disconnect(this);
 }
 
-QByteArray LichessOpening::sync_request( QNetworkRequest& request )
+QString LichessOpening::query(const QString& fen) const
 {
-    QNetworkAccessManager manager;
-    QNetworkReply* reply;
-    QEventLoop connection_loop;
-    connect(&manager, SIGNAL( finished(QNetworkReply*) ), &connection_loop, SLOT( quit() ) );
-    reply = manager.get( request );
-    connection_loop.exec();
-    reply->deleteLater();
-    return reply->readAll();
+    QString requested = QString("/%1?fen=%2").arg(m_db, fen);
+    if (!m_variant.isEmpty()) requested += QString("&variant=%1").arg(m_variant);
+    foreach(QString interval, m_intervals)
+    {
+       requested += QString("&speeds[]=%1").arg(interval);
+    }
+    if (m_intervals.count())
+    {
+        for (int i=1600;i<=2200;i+=200)
+        {
+            requested += QString("&ratings[]=%1").arg(i);
+        }
+    }
+
+    requested += "&topGames=0";
+    return requested;
+}
+
+QString LichessOpening::cacheFile(const QString& query) const
+{
+    QByteArray hash = QCryptographicHash::hash(query.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QString("%1/%2.json").arg(m_cacheDirectory, QString::fromLatin1(hash));
 }
 
-QByteArray LichessOpening::queryPosition(const QString& fen)
+QByteArray LichessOpening::cachedPosition(const QString& fen)
 {
-    QUrl url;
+    QMutexLocker lock(&m_mutex);
+    QString q = query(fen);
+    if (QByteArray* data = m_memoryCache.object(q))
+    {
+        return *data;
+    }
+    if (m_cacheDirectory.isEmpty())
+    {
+        return QByteArray();
+    }
+
+    QFile file(cacheFile(q));
+    if (QFileInfo(file).lastModified().daysTo(QDateTime::currentDateTime()) > DiskCacheDays
+            || !file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+    QByteArray data = file.readAll();
+    if (!data.isEmpty())
+    {
+        m_memoryCache.insert(q, new QByteArray(data));
+    }
+    return data;
+}
 
-    if (AppSettings->getValue("/General/onlineTablebases").toBool())
+void LichessOpening::storePosition(const QString& fen, const QByteArray& data)
+{
+    QMutexLocker lock(&m_mutex);
+    QString q = query(fen);
+    m_memoryCache.insert(q, new QByteArray(data));
+    if (!m_cacheDirectory.isEmpty() && QDir().mkpath(m_cacheDirectory))
     {
-        QString requested = QString("/%1?fen=%2").arg(m_db).arg(fen);
-        if (!m_variant.isEmpty()) requested += QString("&variant=%1").arg(m_variant);
-        foreach(QString interval, m_intervals)
+        QSaveFile file(cacheFile(q));
+        if (file.open(QIODevice::WriteOnly))
         {
-           requested += QString("&speeds[]=%1").arg(interval);
+            file.write(data);
+            file.commit();
         }
-        if (m_intervals.count())
+    }
+}
+
+void LichessOpening::requestPosition(const QString& fen)
+{
+    if (!cachedPosition(fen).isEmpty())
+    {
+        emit positionAvailable(fen);
+        return;
+    }
+    // The network is only accessed from the thread owning the client
+    QMetaObject::invokeMethod(this, "queuePosition", Qt::QueuedConnection, Q_ARG(QString, fen));
+}
+
+void LichessOpening::queuePosition(QString fen)
+{
+    if (m_reply && m_replyFen == fen)
+    {
+        return;
+    }
+    // A newer position replaces the pending one, and is preferred over prefetching
+    m_pendingFen = fen;
+    m_prefetchFens.clear();
+    if (m_reply && m_replyIsPrefetch)
+    {
+        QNetworkReply* reply = m_reply;
+        m_reply = nullptr;
+        reply->abort();
+    }
+    m_coalesceTimer.start();
+}
+
+void LichessOpening::sendNext()
+{
+    if (m_reply)
+    {
+        return;
+    }
+    if (!m_pendingFen.isEmpty())
+    {
+        if (m_coalesceTimer.isActive())
         {
-            for (int i=1600;i<=2200;i+=200)
-            {
-                requested += QString("&ratings[]=%1").arg(i);
-            }
+            return;
+        }
+        QString fen = m_pendingFen;
+        m_pendingFen.clear();
+        if (!cachedPosition(fen).isEmpty())
+        {
+            emit positionAvailable(fen);
+        }
+        else
+        {
+            sendRequest(fen, false);
+            return;
+        }
+    }
+    while (!m_prefetchFens.isEmpty())
+    {
+        QString fen = m_prefetchFens.takeFirst();
+        if (cachedPosition(fen).isEmpty())
+        {
+            sendRequest(fen, true);
+            return;
         }
+    }
+}
+
+void LichessOpening::sendRequest(const QString& fen, bool prefetch)
+{
+    QMutexLocker lock(&m_mutex);
+    QUrl url(query(fen));
+    lock.unlock();
+    url.setScheme(m_server.scheme());
+    url.setHost(m_server.host());
+    url.setPort(m_server.port());
+
+    m_replyFen = fen;
+    m_replyIsPrefetch = prefetch;
+    m_reply = m_manager->get(NetworkHelper::Request(url));
+}
 
-        requested += "&topGames=0";
+void LichessOpening::replyFinished(QNetworkReply* reply)
+{
+    reply->deleteLater();
+    if (reply != m_reply)
+    {
+        // Aborted in favor of a newer request
+        return;
+    }
+    m_reply = nullptr;
 
-        if (m_requested == requested)
+    if (reply->error() == QNetworkReply::NoError)
+    {
+        QByteArray data = reply->readAll();
+        if (!QJsonDocument::fromJson(data).isNull())
         {
-            return reply;
+            storePosition(m_replyFen, data);
+            emit positionAvailable(m_replyFen);
+            if (!m_replyIsPrefetch)
+            {
+                queuePrefetch(m_replyFen, data);
+            }
         }
+    }
+    sendNext();
+}
 
-        url = requested;
-        url.setHost("explorer.lichess.ovh");
-        url.setScheme("http");
+void LichessOpening::queuePrefetch(const QString& fen, const QByteArray& data)
+{
+    if (m_prefetchCount <= 0)
+    {
+        return;
+    }
+
+    QList<QPair<int, QString> > played;
+    QJsonArray jMoves = QJsonDocument::fromJson(data).object().value("moves").toArray();
+    for (QJsonArray::const_iterator it = jMoves.constBegin(); it != jMoves.constEnd(); ++it)
+    {
+        QJsonObject o = (*it).toObject();
+        int n = o.value("white").toInt() + o.value("draw").toInt() + o.value("black").toInt();
+        played.append(qMakePair(n, o.value("uci").toString()));
+    }
+    std::stable_sort(played.begin(), played.end(),
+                     [](const QPair<int, QString>& a, const QPair<int, QString>& b) { return a.first > b.first; });
 
-        QNetworkRequest request = NetworkHelper::Request(url);
-        reply = sync_request( request );
-        m_requested = requested;
-        return reply;
+    BoardX board;
+    if (!board.fromFen(fen))
+    {
+        return;
+    }
+    for (int i = 0; i < played.count() && i < m_prefetchCount; ++i)
+    {
+        Move m = board.parseMove(played.at(i).second);
+        if (m.isLegal())
+        {
+            BoardX child(board);
+            child.doMove(m);
+            m_prefetchFens.append(child.toFen());
+        }
     }
-    return QByteArray();
 }
 
 void LichessOpening::setDb(const QString &db)
 {
+    QMutexLocker lock(&m_mutex);
     m_db = db;
 }
 
 void LichessOpening::setVariant(const QString &v)
 {
+    QMutexLocker lock(&m_mutex);
     m_variant = v;
 }
 
 void LichessOpening::setIntervals(const QStringList &intervals)
 {
+    QMutexLocker lock(&m_mutex);
     m_intervals = intervals;
 }
+
+void LichessOpening::setServer(const QUrl& url)
+{
+    m_server = url;
+}
+
+void LichessOpening::setCacheDirectory(const QString& path)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cacheDirectory = path;
+    m_memoryCache.clear();
+}
+
+void LichessOpening::setPrefetchCount(int count)
+{
+    m_prefetchCount = count;
+}
+
+void LichessOpening::setCoalesceDelay(int ms)
+{
+    m_coalesceTimer.setInterval(ms);
+}
@@ -1,14 +1,32 @@
 #ifndef LICHESSOPENING_H
 #define LICHESSOPENING_H
 
+#include <QCache>
+#include <QMutex>
 #include <QNetworkAccessManager>
 #include <QObject>
+#include <QPointer>
 #include <QString>
+#include <QStringList>
 #include <QMap>
+#include <QTimer>
+#include <QUrl>
 
 #include "move.h"
 #include "movedata.h"
 
+class QNetworkReply;
+
+/** @ingroup Database
+ * Asynchronous client of the Lichess opening explorer.
+ *
+ * Responses are cached in memory and on disk, keyed by the complete query.
+ * cachedPosition() and requestPosition() may be called from any thread, the
+ * network traffic is handled in the thread owning the client. Requests of
+ * rapidly changing positions are coalesced, only the latest one is sent.
+ * After a position arrived, the positions after its most played moves are
+ * prefetched while the client is idle.
+ */
 class LichessOpening : public QObject
 {
     Q_OBJECT
@@ -17,17 +35,58 @@ public:
     LichessOpening();
     ~LichessOpening();
 
-    QByteArray queryPosition(const QString& fen);
+    /** @return the cached response for @p fen, or an empty array if it is not cached yet */
+    QByteArray cachedPosition(const QString& fen);
+    /** Request @p fen from the server unless it is cached, positionAvailable() is emitted when it arrived */
+    void requestPosition(const QString& fen);
+
     void setDb(const QString &db);
     void setVariant(const QString &v);
     void setIntervals(const QStringList &intervals);
+    /** Use @p url (scheme, host and port) as explorer server */
+    void setServer(const QUrl& url);
+    /** Store responses in @p path, an empty path disables the disk cache */
+    void setCacheDirectory(const QString& path);
+    /** Prefetch the @p count most played moves of each requested position, 0 disables prefetching */
+    void setPrefetchCount(int count);
+    /** Wait @p ms after a request before sending it, so that a following request can replace it */
+    void setCoalesceDelay(int ms);
+
+signals:
+    /** The response for @p fen is now available from cachedPosition() */
+    void positionAvailable(QString fen);
+
+private slots:
+    void queuePosition(QString fen);
+    void sendNext();
+    void replyFinished(QNetworkReply* reply);
 
 private:
-    QByteArray sync_request( QNetworkRequest& networkRequest );
+    /** @return the query for @p fen, m_mutex must be locked as the parameters may be changed from any thread */
+    QString query(const QString& fen) const;
+    QString cacheFile(const QString& query) const;
+    void storePosition(const QString& fen, const QByteArray& data);
+    void queuePrefetch(const QString& fen, const QByteArray& data);
+    void sendRequest(const QString& fen, bool prefetch);
 
 private:
-    QString m_requested;
-    QByteArray reply;
+    /** Guards the caches and the query parameters */
+    QMutex m_mutex;
+    QCache<QString, QByteArray> m_memoryCache;
+    QString m_cacheDirectory;
+
+    QNetworkAccessManager* m_manager;
+    QTimer m_coalesceTimer;
+    /** Latest position requested by the user, not yet sent */
+    QString m_pendingFen;
+    /** Positions after the most played moves of recently received positions */
+    QStringList m_prefetchFens;
+    QPointer<QNetworkReply> m_reply;
+    QString m_replyFen;
+    bool m_replyIsPrefetch;
+    int m_prefetchCount;
+
+    QUrl m_server;
     QString m_db;
     QString m_variant;
     QStringList m_intervals;
@@ -1,8 +1,10 @@
 #include "lichessopeningdatabase.h"
+#include "settings.h"
 #include <QJsonDocument>
 
 LichessOpeningDatabase::LichessOpeningDatabase()
 {
+    connect(&m_client, SIGNAL(positionAvailable(QString)), SIGNAL(positionAvailable(QString)));
 }
 
 bool LichessOpeningDatabase::open(const QString& filename, bool)
@@ -41,7 +43,15 @@ unsigned int LichessOpeningDatabase::getMoveMapForBoard(const BoardX &board, QMa
 {
     unsigned int total = 0;
     QString fen = board.toFen();
-    QByteArray reply = m_client.queryPosition(fen);
+    QByteArray reply = m_client.cachedPosition(fen);
+    if (reply.isEmpty())
+    {
+        if (AppSettings->snapshot().onlineTablebases)
+        {
+            m_client.requestPosition(fen);
+        }
+        return 0;
+    }
 
     QJsonDocument doc = QJsonDocument::fromJson(reply);
 
@@ -22,11 +22,19 @@ public:
     virtual void loadGameMoves(GameId /*index*/, GameX& /*game*/) { };
     /** Loads game moves and try to find a position */
     virtual int findPosition(GameId /*index*/, const BoardX& /*position*/) { return 0; };
-    /** Get a map of MoveData from a given board position */
+    /** Get a map of MoveData from a given board position.
+        If the position is not cached yet it is requested, and positionAvailable() is emitted when it arrived. */
     unsigned int getMoveMapForBoard(const BoardX &board, QMap<Move, MoveData>& moves);
 
     QString name() const { return m_filename; };
 
+    /** Access the explorer client, e.g. to configure its server and caches */
+    LichessOpening& client() { return m_client; }
+
+signals:
+    /** The moves of the position given by @p fen can now be retrieved without waiting */
+    void positionAvailable(QString fen);
+
 private:
     QString m_filename;
     LichessOpening m_client;
@@ -173,9 +173,10 @@ void MemoryDatabase::parseGame()
         eco.clear();
     }
 
-    if(AppSettings->getValue("/General/automaticECO").toBool())
+    const SettingsSnapshot& settings = AppSettings->snapshot();
+    if(settings.automaticECO)
     {
-        if(eco.isEmpty() || !AppSettings->getValue("/General/preserveECO").toBool())
+        if(eco.isEmpty() || !settings.preserveECO)
         {
             eco = game->ecoClassify().left(3);
             if(!eco.isEmpty())
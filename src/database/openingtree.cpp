@@ -8,6 +8,7 @@
  ***************************************************************************/
 
 #include "database.h"
+#include "lichessopeningdatabase.h"
 #include "openingtree.h"
 #include "settings.h"
 #include "movedata.h"
@@ -64,6 +65,11 @@ bool OpeningTree::updateFilter(FilterX& f, const BoardX& b, bool updateFilter, b
     m_updateFilter = updateFilter;
     m_sourceIsDatabase = !sourceIsFilter;
 
+    if (LichessOpeningDatabase* db = qobject_cast<LichessOpeningDatabase*>(f.database()))
+    {
+        connect(db, SIGNAL(positionAvailable(QString)), this, SLOT(positionAvailable(QString)), Qt::UniqueConnection);
+    }
+
     if(!oupd.isRunning())
     {
         emit openingTreeUpdateStarted();
@@ -72,7 +78,7 @@ bool OpeningTree::updateFilter(FilterX& f, const BoardX& b, bool updateFilter, b
         connect(&oupd, SIGNAL(MoveUpdate(BoardX*,QList<MoveData>)), this, SLOT(moveUpdated(BoardX*,QList<MoveData>)), Qt::UniqueConnection);
         connect(&oupd, SIGNAL(UpdateTerminated(BoardX*)), this, SLOT(updateTerminated(BoardX*)), Qt::UniqueConnection);
         connect(&oupd, SIGNAL(progress(int)), SIGNAL(progress(int)), Qt::UniqueConnection);
-        connect(&oupd, SIGNAL(requestGameFilterUpdate(int,int)), SIGNAL(requestGameFilterUpdate(int,int)), Qt::UniqueConnection);
+        connect(&oupd, SIGNAL(requestGameFilterUpdate(QList<int>,QList<int>)), SIGNAL(requestGameFilterUpdate(QList<int>,QList<int>)), Qt::UniqueConnection);
         return oupd.updateFilter(f, b, m_games, m_updateFilter, m_sourceIsDatabase, m_bEnd);
     }
     else
@@ -125,11 +131,24 @@ void OpeningTree::updateTerminated(BoardX*)
         connect(&oupd, SIGNAL(MoveUpdate(BoardX*,QList<MoveData>)), this, SLOT(moveUpdated(BoardX*,QList<MoveData>)), Qt::UniqueConnection);
         connect(&oupd, SIGNAL(UpdateTerminated(BoardX*)), this, SLOT(updateTerminated(BoardX*)), Qt::UniqueConnection);
         connect(&oupd, SIGNAL(progress(int)), SIGNAL(progress(int)), Qt::UniqueConnection);
-        connect(&oupd, SIGNAL(requestGameFilterUpdate(int,int)), SIGNAL(requestGameFilterUpdate(int,int)), Qt::UniqueConnection);
+        connect(&oupd, SIGNAL(requestGameFilterUpdate(QList<int>,QList<int>)), SIGNAL(requestGameFilterUpdate(QList<int>,QList<int>)), Qt::UniqueConnection);
         oupd.updateFilter(*m_filter, m_board, m_games, m_updateFilter, m_sourceIsDatabase, m_bEnd);
     }
 }
 
+void OpeningTree::positionAvailable(QString fen)
+{
+    if (m_filter && fen == m_board.toFen())
+    {
+        // A running update restarts when it finished
+        m_bRequestPending = true;
+        if(!oupd.isRunning())
+        {
+            updateTerminated(&m_board);
+        }
+    }
+}
+
 int OpeningTree::rowCount(const QModelIndex& parent) const
 {
     return parent.isValid() ? 0 : m_moves.count();
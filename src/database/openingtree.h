@@ -62,9 +62,11 @@ protected slots:
     void updateFinished(BoardX*);
     void updateTerminated(BoardX*);
     void moveUpdated(BoardX* b, QList<MoveData> moveList);
+    /** Data for the position @p fen arrived asynchronously, recalculate if it is shown */
+    void positionAvailable(QString fen);
 signals:
     void progress(int);
-    void requestGameFilterUpdate(int,int);
+    void requestGameFilterUpdate(QList<int>,QList<int>);
     void openingTreeUpdated();
     void openingTreeUpdateStarted();
 protected:
@@ -53,6 +53,7 @@ void OpeningTreeThread::run()
     else if (m_filter)
     {
         const auto batchSize = 100;
+        const auto filterBatchSize = 10000;
 
         // setup buffers for batch processing
         QList<GameId> rqBuffer;
@@ -104,14 +105,17 @@ void OpeningTreeThread::run()
             }
             ProgressUpdate(moves, games, processed, total);
 
-            // update filter if necessary
+            // collect filter updates, they are sent in large batches
             if (m_updateFilter)
             {
                 for (auto i = 0; i < rqBuffer.size(); ++i)
                 {
-                    auto rq = rqBuffer.at(i);
-                    auto rs = rsBuffer.at(i);
-                    emit requestGameFilterUpdate(rq, rs + 1);
+                    m_filterGames.append(static_cast<int>(rqBuffer.at(i)));
+                    m_filterValues.append(rsBuffer.at(i) + 1);
+                }
+                if (m_filterGames.size() >= filterBatchSize)
+                {
+                    FlushFilterUpdate();
                 }
             }
 
@@ -121,6 +125,7 @@ void OpeningTreeThread::run()
                 break;
             }
         }
+        FlushFilterUpdate();
     }
     *m_games = games;
     if(!m_break)
@@ -153,11 +158,23 @@ bool OpeningTreeThread::updateFilter(FilterX& f, const BoardX& b, unsigned int&
     m_bEnd  = bEnd;
     m_updateFilter = updateFilter;
     m_sourceIsDatabase = sourceIsDatabase;
+    m_filterGames.clear();
+    m_filterValues.clear();
     // todo: if running wait for stop
     start();
     return true;
 }
 
+void OpeningTreeThread::FlushFilterUpdate()
+{
+    if (!m_filterGames.isEmpty())
+    {
+        emit requestGameFilterUpdate(m_filterGames, m_filterValues);
+        m_filterGames.clear();
+        m_filterValues.clear();
+    }
+}
+
 void OpeningTreeThread::ProgressUpdate(QMap<Move, MoveData> &moves, unsigned int games, int i, int n)
 {
     emit progress(i * 100 / n);
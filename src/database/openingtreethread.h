@@ -21,7 +21,8 @@ public:
     bool updateFilter(FilterX& f, const BoardX& b, unsigned int&, bool updateFilter, bool sourceIsDatabase, bool bEnd);
 
 signals:
-    void requestGameFilterUpdate(int index, int value);
+    /** Filter values @p values for the games @p games, delivered in batches */
+    void requestGameFilterUpdate(QList<int> games, QList<int> values);
     void MoveUpdate(BoardX*, QList<MoveData>);
     void UpdateFinished(BoardX*);
     void UpdateTerminated(BoardX*);
@@ -29,7 +30,12 @@ signals:
 
 protected:
     void ProgressUpdate(QMap<Move, MoveData>& moves, unsigned int games, int i, int n);
+    /** Emit the pending filter updates in one batch */
+    void FlushFilterUpdate();
 private:
+    QList<int> m_filterGames;
+    QList<int> m_filterValues;
+
     unsigned int* m_games;
 
     bool    m_break;
@@ -9,10 +9,15 @@
  ***************************************************************************/
 
 #include <algorithm>
+#include <QFuture>
 #include <QMap>
 #include <QRegularExpression>
+#include <QScopedPointer>
 #include <QTextStream>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
 #include "board.h"
+#include "compressedfile.h"
 #include "output.h"
 #include "settings.h"
 #include "tags.h"
@@ -25,6 +30,10 @@ const char* DEFAULT_HTML_TEMPLATE = "html-default.template";
 const char* DEFAULT_NOTATION_TEMPLATE = "notation-default.template";
 const char* DEFAULT_LATEX_TEMPLATE = "latex-default.template";
 const char* DEFAULT_PGN_TEMPLATE = "pgn-default.template";
+/** Number of games in each independently compressed block of a .pgn.gz file */
+const int GamesPerBlock = 100;
+/** Number of games loaded and formatted together when exporting a database */
+const int ExportBatchSize = 512;
 
 #if defined(_MSC_VER) && defined(_DEBUG)
 #define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
@@ -33,9 +42,43 @@ const char* DEFAULT_PGN_TEMPLATE = "pgn-default.template";
 
 QMap<Output::OutputType, QString> Output::m_outputMap;
 
+/** Open @p filename for writing, a .pgn.gz file is written compressed */
+static QIODevice* openOutputFile(const QString& filename)
+{
+    QIODevice* f;
+    if (filename.endsWith(".pgn.gz", Qt::CaseInsensitive))
+    {
+        f = new CompressedFile(filename);
+    }
+    else
+    {
+        f = new QFile(filename);
+    }
+    if(!f->open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        delete f;
+        return nullptr;
+    }
+    return f;
+}
+
+/** End the compressed block after every GamesPerBlock games, so loading a game decodes a single block */
+static void endCompressedBlock(QTextStream& out, int games)
+{
+    CompressedFile* file = qobject_cast<CompressedFile*>(out.device());
+    if (file && (games % GamesPerBlock == 0))
+    {
+        out.flush();
+        file->endBlock();
+    }
+}
+
 Output::Output(OutputType output, BoardRenderingFunc renderer, const QString& pathToTemplateFile)
     : m_renderer(renderer)
     , m_outputType(output)
+    , m_game(nullptr)
+    , m_fragmentCache(false)
+    , m_fragmentHits(0)
 {
     switch(m_outputType)
     {
@@ -241,12 +284,16 @@ QMap<Output::OutputType, QString>& Output::getFormats()
 QString Output::writeDiagram(int n) const
 {
     QString imageString;
-    if(m_renderer && (m_outputType == NotationWidget) && (AppSettings->getValue("/GameText/ShowDiagrams").toBool()))
+    if(m_renderer && (m_outputType == NotationWidget) && (AppSettings->snapshot().showDiagrams))
     {
-        GameX g = m_game;
-        g.forward(1);
+        BoardX board = m_cursor.board();
+        MoveId next = m_cursor.nextMove();
+        if(next != NO_MOVE)
+        {
+            board.doMove(m_game->cursor().moveAt(next));
+        }
 
-        QString iconBase64 = m_renderer(g.board(), QSize(n, n));
+        QString iconBase64 = m_renderer(board, QSize(n, n));
         imageString = QString("\n") +
                       m_startTagMap[MarkupDiagram] +
                       "<img alt='Diagram' src='data:image/gif;base64," + iconBase64 + "'>\n" +
@@ -266,22 +313,22 @@ QString Output::writeMove(MoveToWrite moveToWrite)
     MoveId moveId;
     if(moveToWrite == NextMove)
     {
-        moveId = m_game.nextMove();
+        moveId = m_cursor.nextMove();
     }
     else
     {
-        moveId = m_game.currentMove();
+        moveId = m_cursor.currMove();
     }
 
     if (moveId <= ROOT_NODE)  return text; // ?
 
     mvno = QString::number(moveId);
-    if(m_game.nags(moveId).count() > 0)
+    if(m_game->nags(moveId).count() > 0)
     {
         if(m_options.getOptionAsBool("SymbolicNag"))
         {
-            nagString += m_game.nags(moveId).toString(m_outputType == Html ? NagSet::HTML : NagSet::Simple);
-            if((m_outputType == Html || m_outputType == NotationWidget) && (m_game.nags(moveId).contains(NagDiagram)))
+            nagString += m_game->nags(moveId).toString(m_outputType == Html ? NagSet::HTML : NagSet::Simple);
+            if((m_outputType == Html || m_outputType == NotationWidget) && (m_game->nags(moveId).contains(NagDiagram)))
             {
                 int n = m_options.getOptionAsInt("DiagramSize");
                 if(n)
@@ -292,22 +339,22 @@ QString Output::writeMove(MoveToWrite moveToWrite)
         }
         else
         {
-            nagString += m_game.nags(moveId).toString(NagSet::PGN);
+            nagString += m_game->nags(moveId).toString(NagSet::PGN);
         }
 
     }
     // Read comments
-    if(m_game.canHaveStartAnnotation(moveId))
-        precommentString = (m_outputType == Pgn) ? m_game.annotation(moveId, GameX::BeforeMove) :
-                           m_game.textAnnotation(moveId, GameX::BeforeMove, m_game.textFilter2());
+    if(m_game->canHaveStartAnnotation(moveId))
+        precommentString = (m_outputType == Pgn) ? m_game->annotation(moveId, GameX::BeforeMove) :
+                           m_game->textAnnotation(moveId, GameX::BeforeMove, m_game->textFilter2());
 
-    QString commentString = (m_outputType == Pgn) ? m_game.annotation(moveId) :
-                                                    m_game.textAnnotation(moveId, GameX::AfterMove, m_game.textFilter2());
+    QString commentString = (m_outputType == Pgn) ? m_game->annotation(moveId) :
+                                                    m_game->textAnnotation(moveId, GameX::AfterMove, m_game->textFilter2());
 
     // Write precomment if any
     text += writeComment(precommentString, mvno, Precomment);
 
-    Color c = m_game.board().toMove();
+    Color c = m_cursor.board().toMove();
 
     if((m_options.getOptionAsBool("ColumnStyle")) &&
             (m_currentVariationLevel == 0) &&
@@ -324,14 +371,20 @@ QString Output::writeMove(MoveToWrite moveToWrite)
 
     // *** Determine actual san
     QString san;
-    GameX::MoveStringFlags flags = (m_outputType == NotationWidget) ? GameX::TranslatePiece : GameX::MoveOnly;
-    if(moveToWrite == NextMove)
-    {
-        san = m_game.moveToSan(flags);
-    }
-    else
+    const Move& move = m_game->cursor().moveAt(moveId);
+    if(move.isLegal() || move.isNullMove())
     {
-        san = m_game.moveToSan((GameX::MoveStringFlags)(flags | GameX::MoveOnly), GameX::PreviousMove);
+        bool translate = (m_outputType == NotationWidget);
+        if(moveToWrite == NextMove)
+        {
+            san = m_cursor.board().moveToSan(move, translate);
+        }
+        else
+        {
+            BoardX board = m_cursor.board();
+            board.undoMove(move);
+            san = board.moveToSan(move, translate);
+        }
     }
 
     if (!san.isEmpty())
@@ -343,11 +396,11 @@ QString Output::writeMove(MoveToWrite moveToWrite)
         }
         if(c == White)
         {
-            text += QString::number(m_game.moveNumber(moveId)) + ". ";
+            text += QString::number(m_game->moveNumber(moveId)) + ". ";
         }
         else if(m_dirtyBlack)
         {
-            text += QString::number(m_game.moveNumber(moveId)) + "... ";
+            text += QString::number(m_game->moveNumber(moveId)) + "... ";
             if((m_options.getOptionAsBool("ColumnStyle")) &&
                     (m_currentVariationLevel == 0))
             {
@@ -406,12 +459,11 @@ QString Output::writeMove(MoveToWrite moveToWrite)
             (c == White))
     {
         text += m_endTagMap[MarkupColumnStyleMove];
-        m_game.forward();
-        if(m_game.atGameEnd())
+        MoveId next = m_cursor.nextMove();
+        if(next != NO_MOVE && m_game->atGameEnd(next))
         {
             text += m_endTagMap[MarkupColumnStyleRow];
         }
-        m_game.backward();
     }
 
     if((m_options.getOptionAsBool("ColumnStyle")) &&
@@ -428,7 +480,7 @@ QString Output::writeMove(MoveToWrite moveToWrite)
     }
 
     text += writeComment(commentString, mvno, Comment);
-    if (m_game.hasNextMove())
+    if (m_cursor.nextMove() != NO_MOVE)
     {
         text += " ";
     }
@@ -441,10 +493,10 @@ QString Output::writeMainLine(MoveId upToNode)
     do
     {
         bool hasNext = false;
-        if (!m_game.atLineEnd())
+        if (!m_game->atLineEnd(m_cursor.currMove()))
         {
             // Training mode: abort main line with current node
-            if(m_game.currentMove() == upToNode)
+            if(m_cursor.currMove() == upToNode)
             {
                 if(m_options.getOptionAsBool("ColumnStyle"))
                 {
@@ -455,12 +507,12 @@ QString Output::writeMainLine(MoveId upToNode)
             }
             // *** Write moves in the main line
             text += writeMove();
-            hasNext = m_game.hasNextMove();
+            hasNext = (m_cursor.nextMove() != NO_MOVE);
         }
 
-        if(m_game.variationCount())
+        if(m_cursor.variations().count())
         {
-            QList<MoveId> variations = m_game.variations();
+            QList<MoveId> variations = m_cursor.variations();
             if(variations.size())
             {
                 if(m_options.getOptionAsBool("ColumnStyle"))
@@ -470,7 +522,7 @@ QString Output::writeMainLine(MoveId upToNode)
                 for(int i = 0; i < variations.size(); ++i)
                 {
                     // *** Enter variation i, and write the rest of the moves
-                    m_game.dbMoveToId(variations[i]);
+                    m_cursor.moveToId(variations[i]);
                     text += writeVariation();
                 }
                 if(hasNext && m_options.getOptionAsBool("ColumnStyle"))
@@ -479,17 +531,65 @@ QString Output::writeMainLine(MoveId upToNode)
                 }
             }
             m_dirtyBlack = true;
-            m_game.dbMoveToId(m_game.parentMove());
+            m_cursor.moveToId(m_cursor.parentMove());
         }
-        m_game.forward();
-    } while(!m_game.atLineEnd());
+        m_cursor.forward();
+    } while(!m_game->atLineEnd(m_cursor.currMove()));
 
     return text;
 }
 
+/** Mix @p value into the hash @p h */
+static inline quint64 combine(quint64 h, quint64 value)
+{
+    return h ^ (value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2));
+}
+
+quint64 Output::variationSignature() const
+{
+    const GameCursor& cursor = m_cursor.cursor();
+    quint64 h = combine(m_cursor.board().getHashValue(), m_currentVariationLevel);
+    h = combine(h, m_game->moveNumber(m_cursor.currMove()));
+
+    // Node ids are part of the text, as anchors of the moves
+    QList<MoveId> lines;
+    lines.append(m_cursor.currMove());
+    while(!lines.isEmpty())
+    {
+        for(MoveId node = lines.takeLast(); node != NO_MOVE; node = cursor.nextMove(node))
+        {
+            h = combine(h, node);
+            h = combine(h, cursor.moveAt(node).rawMove());
+            foreach(Nag nag, m_game->nags(node))
+            {
+                h = combine(h, nag);
+            }
+            h = combine(h, qHash(m_game->annotation(node, GameX::BeforeMove)));
+            h = combine(h, qHash(m_game->annotation(node)));
+            lines.append(cursor.variations(node));
+        }
+    }
+    return h;
+}
+
 QString Output::writeVariation()
 {
     QString text;
+    MoveId start = m_cursor.currMove();
+    quint64 signature = 0;
+    if(m_fragmentCache)
+    {
+        // The cursor is left at the start of the variation, callers only need its parent
+        signature = variationSignature();
+        QHash<MoveId, VariationFragment>::const_iterator it = m_fragments.constFind(start);
+        if(it != m_fragments.constEnd() && it->signature == signature)
+        {
+            m_newFragments.insert(start, *it);
+            ++m_fragmentHits;
+            return it->text;
+        }
+    }
+
     m_currentVariationLevel++;
     // allow up to 9 indentation levels
     auto variationIndentLevel = qMin(m_options.getOptionAsInt("VariationIndentLevel"), 10);
@@ -519,33 +619,33 @@ QString Output::writeVariation()
 
     bool mustAddStart = false;
 
-    while(!m_game.atLineEnd())
+    while(!m_game->atLineEnd(m_cursor.currMove()))
     {
         // *** Writes move in the current variation
         text += writeMove();
-        if(m_game.variationCount())
+        if(m_cursor.variations().count())
         {
             if (indent && !indentLastLevel)
             {
                 text += m_endTagMap[resumeTag];
                 mustAddStart = true;
             }
-            QList<MoveId> variations = m_game.variations();
+            QList<MoveId> variations = m_cursor.variations();
             if(!variations.empty())
             {
                 for(int i = 0; i < variations.size(); ++i)
                 {
                     // *** Enter variation i, and write the rest of the moves
-                    if (m_game.dbMoveToId(variations[i]))
+                    if (m_cursor.moveToId(variations[i]))
                     {
                         text += writeVariation();
                     }
                 }
             }
             m_dirtyBlack = true;
-            m_game.dbMoveToId(m_game.parentMove());
+            m_cursor.moveToId(m_cursor.parentMove());
         }
-        m_game.forward();
+        m_cursor.forward();
 
         if (mustAddStart)
         {
@@ -565,6 +665,13 @@ QString Output::writeVariation()
     }
 
     m_currentVariationLevel--;
+    if(m_fragmentCache)
+    {
+        VariationFragment fragment;
+        fragment.signature = signature;
+        fragment.text = text;
+        m_newFragments.insert(start, fragment);
+    }
     return text;
 }
 
@@ -667,7 +774,7 @@ QString Output::writeGameComment(QString comment) const
 QString Output::writeAllTags() const
 {
     QString text;
-    TagMap tags = m_game.tags();
+    TagMap tags = m_game->tags();
     // write standard tags
     for(int i = 0; i < 7; ++i)
     {
@@ -694,7 +801,7 @@ QString Output::writeAllTags() const
 QString Output::writeBasicTagsHTML() const
 {
     QString text;
-    TagMap tags = m_game.tags();
+    TagMap tags = m_game->tags();
 
     QString eco = tags[TagNameECO].left(3);
     if(eco == "?")
@@ -747,7 +854,7 @@ QString Output::output(const GameX* game, bool upToCurrentMove)
 QString Output::outputTags(const GameX* game)
 {
     QString text;
-    m_game = *game;
+    m_game = game;
     if(m_options.getOptionAsBool("ShowHeader"))
     {
         text += m_startTagMap[MarkupHeaderBlock];
@@ -767,13 +874,14 @@ QString Output::outputTags(const GameX* game)
 QString Output::outputGame(const GameX* g, bool upToCurrentMove)
 {
     QString text;
-    m_game = *g;
-    int id = m_game.currentMove();
-    int mainId = upToCurrentMove ? m_game.cursor().mainLineMove() : NO_MOVE;
+    m_game = g;
+    m_cursor.reset(g->cursor());
+    int mainId = upToCurrentMove ? m_game->cursor().mainLineMove() : NO_MOVE;
     m_currentVariationLevel = 0;
+    m_fragmentHits = 0;
 
-    m_game.moveToStart();
-    m_dirtyBlack = m_game.board().toMove() == Black;
+    m_cursor.moveToStart();
+    m_dirtyBlack = m_cursor.board().toMove() == Black;
     text += m_startTagMap[MarkupNotationBlock];
     text += m_startTagMap[MarkupMainLine];
     if(m_options.getOptionAsBool("ColumnStyle"))
@@ -781,7 +889,7 @@ QString Output::outputGame(const GameX* g, bool upToCurrentMove)
         text += m_startTagMap[MarkupColumnStyleMainline];
     }
 
-    QString gameComment = (m_outputType == Pgn) ? m_game.annotation(0) : m_game.textAnnotation(0, GameX::AfterMove, m_game.textFilter2());
+    QString gameComment = (m_outputType == Pgn) ? m_game->annotation(0) : m_game->textAnnotation(0, GameX::AfterMove, m_game->textFilter2());
     text += writeGameComment(gameComment);
 
     text += writeMainLine(mainId);
@@ -791,10 +899,11 @@ QString Output::outputGame(const GameX* g, bool upToCurrentMove)
     }
     text += m_endTagMap[MarkupMainLine];
     text += m_endTagMap[MarkupNotationBlock];
-    text += m_startTagMap[MarkupResult] + m_game.tag(TagNameResult) + m_endTagMap[MarkupResult];
-
-    m_game.dbMoveToId(id);
+    text += m_startTagMap[MarkupResult] + m_game->tag(TagNameResult) + m_endTagMap[MarkupResult];
 
+    // Only the variations of this game are kept for the next output
+    m_fragments.swap(m_newFragments);
+    m_newFragments.clear();
     return text;
 }
 
@@ -832,74 +941,145 @@ void Output::postProcessOutput(QString& text) const
 
 void Output::output(QTextStream& out, FilterX& filter)
 {
-    int percentDone = 0;
-    GameX game;
-    QString header = m_header;
-    postProcessOutput(header);
-    out << header;
-
-    for(int i = 0; i < filter.count(); ++i)
+    QVector<GameId> games;
+    games.reserve(filter.count());
+    for(GameId i = 0; i < filter.size(); ++i)
     {
-        if(filter.database()->loadGame(i, game))
+        if(filter.contains(i))
         {
-            QString tagText = outputTags(&game);
-            out << tagText;
+            games.append(i);
+        }
+    }
+    outputGames(out, *filter.database(), games);
+}
+
+void Output::output(QTextStream& out, Database& database)
+{
+    if(!database.isUtf8() && (m_outputType == Pgn))
+    {
+        SET_CODEC_LATIN1(out);
+    }
+
+    QVector<GameId> games(database.count());
+    for(int i = 0; i < games.count(); ++i)
+    {
+        games[i] = i;
+    }
+    outputGames(out, database, games);
+
+    database.setModified(false);
+}
 
-            QString outText = outputGame(&game, false);
-            postProcessOutput(outText);
-            out << outText;
-            out << "\n\n";
+/** Load the next batch of @p games from @p database, starting at @p next. Games failing to load are left out. */
+static QList<GameX*> loadBatch(Database& database, const QVector<GameId>& games, int& next)
+{
+    QList<GameX*> batch;
+    int end = std::min(next + ExportBatchSize, int(games.count()));
+    for(; next < end; ++next)
+    {
+        GameX* game = new GameX;
+        if(database.loadGame(games[next], *game))
+        {
+            batch.append(game);
         }
-        int percentDone2 = (i + 1) * 100 / filter.count();
-        if(percentDone2 > percentDone)
+        else
         {
-            emit progress((percentDone = percentDone2));
+            delete game;
         }
     }
+    return batch;
+}
 
-    QString footer = m_footer;
-    postProcessOutput(footer);
-    out << footer;
+/** Write the formatted @p games to @p out in large pieces, @p written counts the games written so far */
+static void writeGames(QTextStream* out, const QStringList& games, int* written)
+{
+    QString buffer;
+    for(const QString& game : games)
+    {
+        buffer += game;
+        if(++*written % GamesPerBlock == 0)
+        {
+            *out << buffer;
+            buffer.clear();
+            endCompressedBlock(*out, *written);
+        }
+    }
+    *out << buffer;
 }
 
-void Output::output(QTextStream& out, Database& database)
+QStringList Output::formatGames(const QList<GameX*>& games)
 {
-    if(!database.isUtf8() && (m_outputType == Pgn))
+    QStringList texts;
+    for(const GameX* game : games)
     {
-        SET_CODEC_LATIN1(out);
+        QString text = outputTags(game);
+        QString outText = outputGame(game, false);
+        postProcessOutput(outText);
+        text += outText;
+        text += "\n\n";
+        texts.append(text);
     }
+    return texts;
+}
 
+void Output::outputGames(QTextStream& out, Database& database, const QVector<GameId>& games)
+{
     QString header = m_header;
     postProcessOutput(header);
     out << header;
 
-    int percentDone = 0;
-    GameX game;
-    for(int i = 0; i < (int)database.count(); ++i)
+    // Formatting keeps its state in the Output, so each formatter thread owns one
+    QList<Output*> formatters;
+    int threads = std::max(1, QThread::idealThreadCount());
+    for(int i = 0; i < threads; ++i)
     {
-        if(database.loadGame(i, game))
+        formatters.append(new Output(m_outputType, m_renderer, m_templateFilename));
+    }
+
+    // Games are loaded in order on this thread, while the previous batch is formatted
+    // in parallel and the one before is written
+    int percentDone = 0;
+    int next = 0;
+    int written = 0;
+    QFuture<void> writing;
+    QList<GameX*> batch = loadBatch(database, games, next);
+    while(!batch.isEmpty())
+    {
+        int slice = batch.count() / formatters.count() + 1;
+        QList<QFuture<QStringList> > formatting;
+        for(int start = 0, i = 0; start < batch.count(); start += slice, ++i)
         {
-            QString tagText = outputTags(&game);
-            out << tagText;
+#if QT_VERSION < 0x060000
+            formatting.append(QtConcurrent::run(formatters[i], &Output::formatGames, batch.mid(start, slice)));
+#else
+            formatting.append(QtConcurrent::run(&Output::formatGames, formatters[i], batch.mid(start, slice)));
+#endif
+        }
+        QList<GameX*> nextBatch = loadBatch(database, games, next);
 
-            QString outText = outputGame(&game, false);
-            postProcessOutput(outText);
-            out << outText;
-            out << "\n\n";
+        QStringList texts;
+        for(QFuture<QStringList>& future : formatting)
+        {
+            texts += future.result();
         }
-        int percentDone2 = (i + 1) * 100 / database.count();
+        qDeleteAll(batch);
+        batch = nextBatch;
+
+        writing.waitForFinished();
+        writing = QtConcurrent::run(writeGames, &out, texts, &written);
+
+        int percentDone2 = next * 100 / games.count();
         if(percentDone2 > percentDone)
         {
             emit progress((percentDone = percentDone2));
         }
     }
-
+    writing.waitForFinished();
+    qDeleteAll(formatters);
 
     QString footer = m_footer;
     postProcessOutput(footer);
     out << footer;
-
-    database.setModified(false);
 }
 
 void Output::output(const QString& filename, const GameX& game)
@@ -920,34 +1100,34 @@ void Output::output(const QString& filename, const GameX& game)
 
 void Output::output(const QString& filename, FilterX& filter)
 {
-    QFile f(filename);
-    if(!f.open(QIODevice::WriteOnly | QIODevice::Text))
+    QScopedPointer<QIODevice> f(openOutputFile(filename));
+    if(!f)
     {
         return;
     }
-    QTextStream out(&f);
+    QTextStream out(f.data());
     if((m_outputType == Html) || (m_outputType == NotationWidget))
     {
         SET_CODEC_UTF8(out);
     }
     output(out, filter);
-    f.close();
+    f->close();
 }
 
 void Output::output(const QString& filename, Database& database)
 {
-    QFile f(filename);
-    if(!f.open(QIODevice::WriteOnly | QIODevice::Text))
+    QScopedPointer<QIODevice> f(openOutputFile(filename));
+    if(!f)
     {
         return;
     }
-    QTextStream out(&f);
+    QTextStream out(f.data());
     if((m_outputType == Html) || (m_outputType == NotationWidget))
     {
         SET_CODEC_UTF8(out);
     }
     output(out, database);
-    f.close();
+    f->close();
 }
 
 QString Output::output(Database* database)
@@ -1001,8 +1181,20 @@ void Output::append(const QString& filename, Database& database)
     f.close();
 }
 
+void Output::setFragmentCache(bool enabled)
+{
+    m_fragmentCache = enabled;
+    m_fragments.clear();
+}
+
+int Output::fragmentHits() const
+{
+    return m_fragmentHits;
+}
+
 void Output::setTemplateFile(QString filename)
 {
+    m_fragments.clear();
     if(filename.isEmpty())
     {
         switch(m_outputType)
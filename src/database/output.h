@@ -150,6 +150,12 @@ public:
     void setTemplateFile(QString filename = "");
     /** Static list of objects. */
     static QMap<OutputType, QString>& getFormats();
+    /** Keep the text of each variation, so that the next output of the game only
+     * writes the variations which changed since. Used by the notation widget,
+     * which outputs the same game after every edit. */
+    void setFragmentCache(bool enabled);
+    /** @return the number of variations the last output took from the fragment cache */
+    int fragmentHits() const;
 
 signals:
     /** Operation progress. */
@@ -178,7 +184,9 @@ private:
     /** Character/string used for newline */
     QString m_newlineChar;
     /** Pointer to the game being exported */
-    GameX m_game;
+    const GameX* m_game;
+    /** Read-only cursor walking the moves of m_game */
+    GameCursorView m_cursor;
     /** Map containing the different types of outputs available, and a description of each */
     static QMap<OutputType, QString> m_outputMap;
     /** Map containing the start markup tag for each markup type */
@@ -187,6 +195,21 @@ private:
     QMap<MarkupType, QString> m_endTagMap;
     QMap<MarkupType, bool> m_expandable;
 
+    /** Text written for a variation */
+    struct VariationFragment
+    {
+        /** Value of variationSignature() when the text was written */
+        quint64 signature;
+        QString text;
+    };
+    bool m_fragmentCache;
+    /** Variations of the output in progress taken from m_fragments */
+    int m_fragmentHits;
+    /** Variations of the previous output, keyed by their first move */
+    QHash<MoveId, VariationFragment> m_fragments;
+    /** Variations of the output in progress */
+    QHash<MoveId, VariationFragment> m_newFragments;
+
     /* Setting and retrieving of option. Methods to inteface
      * with OutputOptions class.
      */
@@ -233,6 +256,10 @@ private:
      * @param database A pointer to a database object. All games in the database will be output, one
      *               after the other, using the output(GameX* game) method */
     void output(QTextStream& out, Database& database);
+    /** Write @p games of @p database, formatting them on several threads */
+    void outputGames(QTextStream& out, Database& database, const QVector<GameId>& games);
+    /** Format @p games for outputGames(), one string per game */
+    QStringList formatGames(const QList<GameX*>& games);
 
     /** Output of a single game - requires postProcessing */
     QString outputGame(const GameX *g, bool upToCurrentMove);
@@ -250,6 +277,8 @@ private:
     QString writeMainLine(MoveId upToNode);
     /** Writes a variation, including sub variations */
     QString writeVariation();
+    /** @return a value changing with anything which writeVariation() writes for the variation at the cursor */
+    quint64 variationSignature() const;
     /** Writes a game tag */
     QString writeTag(const QString& tagName, const QString& tagValue) const;
     /** Writes all game tags */
@@ -49,6 +49,16 @@ int PartialDate::year() const
     return m_year;
 }
 
+qint32 PartialDate::toPacked() const
+{
+    return (qint32(m_year) << 9) | (m_month << 5) | m_day;
+}
+
+PartialDate PartialDate::fromPacked(qint32 packed)
+{
+    return PartialDate(packed >> 9, (packed >> 5) & 15, packed & 31);
+}
+
 int PartialDate::month() const
 {
     return m_month;
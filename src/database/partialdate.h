@@ -50,6 +50,10 @@ public:
     QString range(const PartialDate& d) const;
     /** Test if PartialDate is valid */
     bool isValid() const;
+    /** @return the date as a number which is ordered like the dates */
+    qint32 toPacked() const;
+    /** @return the date packed by toPacked() */
+    static PartialDate fromPacked(qint32 packed);
 
     PartialDate(const PartialDate& rhs)
     {
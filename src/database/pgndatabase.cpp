@@ -15,7 +15,9 @@
 #include <QtDebug>
 #include <QMutexLocker>
 #include <QRegularExpression>
+#include <string.h>
 #include "board.h"
+#include "compressedfile.h"
 #include "nag.h"
 
 #include "pgndatabase.h"
@@ -29,6 +31,9 @@ using namespace chessx;
 #define new DEBUG_NEW
 #endif // _MSC_VER
 
+/** Longest game text read up to the offset of the following game, longer ones are read line by line */
+const qint64 MaxGameTextSize = 1 << 20;
+
 PgnDatabase::PgnDatabase() : Database()
 {
     initialise();
@@ -80,7 +85,7 @@ QString PgnDatabase::offsetFilename(const QString& filename) const
 
 bool PgnDatabase::hasIndexFile() const
 {
-    return AppSettings->getValue("/General/useIndexFile").toBool();
+    return AppSettings->snapshot().useIndexFile;
 }
 
 bool PgnDatabase::readOffsetFile(const QString& filename, volatile bool *breakFlag, bool& bUpdate)
@@ -125,7 +130,7 @@ bool PgnDatabase::readOffsetFile(const QString& filename, volatile bool *breakFl
         return false;
     }
 
-    QDateTime lastModifiedStored = fi.lastModified();
+    QDateTime lastModifiedStored = QFileInfo(CompressedFile::containerName(filename)).lastModified();
     if(lastModified != lastModifiedStored)
     {
         return false;
@@ -141,6 +146,17 @@ bool PgnDatabase::readOffsetFile(const QString& filename, volatile bool *breakFl
     in >> m_gameOffsets32;
     emit progress(10);
 
+    if (version >= VERSION_INDEX_1_6)
+    {
+        // Block table of compressed files
+        QVector<CompressedBlock> blocks;
+        in >> blocks;
+        if (CompressedFile* file = qobject_cast<CompressedFile*>(m_file))
+        {
+            file->setBlocks(blocks);
+        }
+    }
+
     if (bUse64bit)
     {
         if (m_gameOffsets32.count())
@@ -213,12 +229,14 @@ bool PgnDatabase::writeOffsetFile(const QString& filename) const
     QString basefile = fi.completeBaseName();
 
     out << basefile;
-    out << fi.lastModified().toUTC();
+    out << QFileInfo(CompressedFile::containerName(filename)).lastModified().toUTC();
 
     out << m_count;
     out << bUse64bit;
     out << m_gameOffsets64;
     out << m_gameOffsets32;
+    CompressedFile* compressed = qobject_cast<CompressedFile*>(m_file);
+    out << (compressed ? compressed->blocks() : QVector<CompressedBlock>());
     out << magic;
 
     writeIndexFile(out);
@@ -260,13 +278,17 @@ bool PgnDatabase::parseFile()
 bool PgnDatabase::parseFileIntern()
 {
     //indexing game positions in the file, game contents are ignored
-    qint64 size = m_file->size();
+    // The uncompressed size of a compressed file is not known in advance,
+    // so progress is measured in the compressed data
+    CompressedFile* compressed = qobject_cast<CompressedFile*>(m_file);
+    qint64 size = compressed ? compressed->compressedSize() : m_file->size();
     int oldFp = -3;
 
     qint64 countDiff = size / 100;
     qint64 nextDiff = countDiff;
     percentDone = 0;
-    m_index.reserve(size/1000);
+    // PGN compresses to about a quarter
+    m_index.reserve(compressed ? size / 250 : size / 1000);
 
     while(!m_file->atEnd() || !m_currentLine.isEmpty())
     {
@@ -311,7 +333,8 @@ bool PgnDatabase::parseFileIntern()
 
                 if(!m_file->atEnd())
                 {
-                    if(fp > nextDiff)
+                    qint64 done = compressed ? compressed->compressedPos() : fp;
+                    if(done > nextDiff && percentDone < 99)
                     {
                         nextDiff += countDiff;
                         emit progress(++percentDone);
@@ -332,6 +355,19 @@ bool PgnDatabase::parseFileIntern()
 
 bool PgnDatabase::openFile(const QString& filename)
 {
+    if (CompressedFile::isCompressed(filename))
+    {
+        // Read archive members and gzip files without extracting them
+        CompressedFile* file = new CompressedFile(filename);
+        if (!file->open(QIODevice::ReadOnly))
+        {
+            delete file;
+            return false;
+        }
+        m_file = file;
+        return true;
+    }
+
     //open file
     QFile* file = new QFile(filename);
     if(!file->exists())
@@ -413,10 +449,33 @@ void PgnDatabase::loadGameMoves(GameId gameId, GameX& game)
     parseMoves(&game);
 }
 
+bool PgnDatabase::loadGameMainline(GameId gameId, GameX& game)
+{
+    QByteArray text;
+    {
+        // Only reading the text needs the file, several searches may parse at once
+        QMutexLocker m(&m_mutex);
+        if(!m_file || gameId >= m_count)
+        {
+            return false;
+        }
+        text = readGameText(gameId);
+    }
+    game.clear();
+    QString fen = m_index.tagValue(TagNameFEN, gameId);
+    if(fen != "?")
+    {
+        QString variant = m_index.tagValue(TagNameVariant, gameId).toLower();
+        bool chess960 = (variant.startsWith("fischer", Qt::CaseInsensitive) || variant.endsWith("960"));
+        game.dbSetStartingBoard(fen, chess960);
+    }
+    return !text.isEmpty() && parseMainline(text, &game);
+}
+
 int PgnDatabase::findPosition(GameId index, const BoardX &position)
 {
     GameX g;
-    loadGameMoves(index, g);
+    loadGameMainline(index, g);
     return g.cursor().findPosition(position);
 }
 
@@ -480,6 +539,44 @@ void PgnDatabase::skipLine()
     m_lineBuffer = m_file->readLine();
 }
 
+QByteArray PgnDatabase::readGameText(GameId gameId)
+{
+    IndexBaseType start = offset(gameId);
+    if(!m_file->seek(start))
+    {
+        qDebug() << "Seeking offset " << QString::number(start) << " failed!";
+        return QByteArray();
+    }
+    // Usually the next game follows, unless games were replaced at the end of the file
+    if(gameId + 1 < m_count)
+    {
+        IndexBaseType next = offset(gameId + 1);
+        if(next > start && next - start <= MaxGameTextSize)
+        {
+            return m_file->read(next - start);
+        }
+    }
+    QByteArray text;
+    bool inTags = true;
+    while(!m_file->atEnd())
+    {
+        QByteArray line = m_file->readLine();
+        if(line.startsWith('['))
+        {
+            if(!inTags)
+            {
+                break;
+            }
+        }
+        else if(!line.trimmed().isEmpty())
+        {
+            inTags = false;
+        }
+        text += line;
+    }
+    return text;
+}
+
 void PgnDatabase::seekGame(GameId gameId)
 {
     IndexBaseType n = offset(gameId);
@@ -490,18 +587,21 @@ void PgnDatabase::seekGame(GameId gameId)
     readLine();
 }
 
-void PgnDatabase::parseTagIntoIndex(const QString& tag, QString value)
+void PgnDatabase::parseTagIntoIndex(QStringView tag, QStringView value)
 {
-    if(value.contains("\\\""))
+    if(value.contains(QLatin1String("\\\"")))
     {
-        value.replace("\\\"", "\"");
+        QString unescaped = value.toString();
+        unescaped.replace("\\\"", "\"");
+        m_index.setTag_nolock(tag, QStringView(unescaped), m_count - 1);
+        return;
     }
 
-    if(tag == TagNameResult && value == "1/2")
+    if(tag == QLatin1String(TagNameResult) && value == QLatin1String("1/2"))
     {
-        value = "1/2-1/2";
+        value = u"1/2-1/2";
     }
-    m_index.setTag_nolock(tag, value, m_count - 1); // PERF von 30s von 115s (26%)
+    m_index.setTag_nolock(tag, value, m_count - 1);
 }
 
 void PgnDatabase::parseTagsIntoIndex()
@@ -533,7 +633,7 @@ void PgnDatabase::parseTagsIntoIndex()
                             {
                                 lastPos = tagValueEnd+1;
                                 pos = m_currentLine.indexOf('[', tagValueEnd);
-                                parseTagIntoIndex(m_currentLine.mid(tagStart, tagEnd-tagStart), m_currentLine.mid(valueStart, valueEnd-valueStart));
+                                parseTagIntoIndex(QStringView(m_currentLine).mid(tagStart, tagEnd-tagStart), QStringView(m_currentLine).mid(valueStart, valueEnd-valueStart));
                                 continue;
                             }
                         }
@@ -1053,6 +1153,157 @@ void PgnDatabase::parseComment(GameX* game)
     }
 }
 
+static inline bool isTokenEnd(char c)
+{
+    return isspace((unsigned char)c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '\0';
+}
+
+bool PgnDatabase::parseMainline(const QByteArray& text, GameX* game)
+{
+    int depth = 0;
+    bool inComment = false;
+    bool inTags = true;
+    char san[16];
+
+    const char* next = text.constData();
+    const char* textEnd = next + text.size();
+    while(next != textEnd)
+    {
+        const char* s = next;
+        const char* end = static_cast<const char*>(memchr(s, '\n', textEnd - s));
+        end = end ? end + 1 : textEnd;
+        next = end;
+
+        if(!inComment && s != end)
+        {
+            if(*s == '[')
+            {
+                if(inTags)
+                {
+                    continue;
+                }
+                return true; // Next game starts, this one has no result
+            }
+            if(*s == '%')
+            {
+                continue; // Escape line
+            }
+        }
+        inTags = false;
+
+        while(s != end)
+        {
+            char c = *s;
+            if(inComment)
+            {
+                inComment = (c != '}');
+                ++s;
+                continue;
+            }
+            switch(c)
+            {
+            case '{':
+                inComment = true;
+                ++s;
+                continue;
+            case ';':
+                s = end; // Rest of line comment
+                continue;
+            case '(':
+                ++depth;
+                ++s;
+                continue;
+            case ')':
+                if(depth > 0)
+                {
+                    --depth;
+                }
+                ++s;
+                continue;
+            default:
+                break;
+            }
+            if(isTokenEnd(c))
+            {
+                ++s;
+                continue;
+            }
+
+            const char* token = s;
+            while(s != end && !isTokenEnd(*s))
+            {
+                ++s;
+            }
+            if(depth > 0)
+            {
+                continue;
+            }
+
+            int length = s - token;
+            if((length == 1 && *token == '*') ||
+               (length == 3 && (strncmp(token, "1-0", 3) == 0 || strncmp(token, "0-1", 3) == 0)) ||
+               (length >= 3 && strncmp(token, "1/2", 3) == 0))
+            {
+                return true; // Result terminates the game
+            }
+
+            // Skip the move number in front of the move
+            if(isdigit((unsigned char)*token))
+            {
+                const char* p = token;
+                while(p != s && isdigit((unsigned char)*p))
+                {
+                    ++p;
+                }
+                if(p == s)
+                {
+                    continue; // A move number without a dot
+                }
+                if(*p == '.')
+                {
+                    while(p != s && *p == '.')
+                    {
+                        ++p;
+                    }
+                    token = p;
+                    length = s - token;
+                }
+            }
+            // Strip check, mate and annotation suffixes, which parseMove() rejects after castling
+            while(length && strchr("+#!?", token[length - 1]))
+            {
+                --length;
+            }
+            if(!length)
+            {
+                continue;
+            }
+
+            // Skip nags and evaluation symbols, but not null moves
+            c = *token;
+            if(c == '$' || c == '!' || c == '?' || c == '+' || c == '=' || (c == '-' && strncmp(token, "--", 2) != 0) || (unsigned char)c >= 0x80)
+            {
+                continue;
+            }
+
+            if(length >= (int)sizeof(san))
+            {
+                return false; // Not a move, give up on this game
+            }
+            memcpy(san, token, length);
+            san[length] = '\0';
+
+            Move move = game->board().parseMoveLatin1(san);
+            if(!(move.isLegal() || move.isNullMove()))
+            {
+                return false;
+            }
+            game->dbAddMove(move);
+        }
+    }
+    return true;
+}
+
 inline bool onlyWhite(const QByteArray& b)
 {
     for(int i = 0; i < b.length(); ++i)
@@ -50,6 +50,8 @@ public:
     bool loadGame(GameId gameId, GameX& game);
     /** Loads only moves into a game from the given position */
     void loadGameMoves(GameId gameId, GameX& game);
+    /** Loads only the main line moves, parsing the raw bytes of the game text */
+    virtual bool loadGameMainline(GameId gameId, GameX& game);
     virtual int findPosition(GameId index, const BoardX& position);
     /** Open a PGN Data File from a string */
     bool openString(const QString& content);
@@ -76,6 +78,9 @@ protected:
     void parseToken(GameX* game, const QStringRef &token);
     /** Parses a comment from the file */
     void parseComment(GameX* game);
+    /** Parse the main line of a game from its raw @p text, skipping comments and variations.
+        Returns false if a token is neither a move nor a known annotation, the moves up to it are kept. */
+    bool parseMainline(const QByteArray& text, GameX* game);
     /** Skips past any data which is not valid tag or move data */
     IndexBaseType skipJunk();
     /** Skips past any tag data */
@@ -85,7 +90,7 @@ protected:
     /** Parses the tags, and adds the supported types to the index 'm_index' */
     void parseTagsIntoIndex();
     /** Parse a single tag of format 'tag "value"' into the index */
-    void parseTagIntoIndex(const QString &tag, QString value);
+    void parseTagIntoIndex(QStringView tag, QStringView value);
 
     bool parseFileIntern();
     virtual void parseGame();
@@ -111,6 +116,8 @@ protected:
     void readTagLine();
     /** Skips the next line of text from the PGN file */
     void skipLine();
+    /** @return the raw text of the given game, read from the file */
+    QByteArray readGameText(GameId gameId);
     /** Moves the file position to the start of the given game */
     void seekGame(GameId gameId);
 
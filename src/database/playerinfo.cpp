@@ -63,31 +63,12 @@ void PlayerInfo::setName(const QString& player)
     update();
 }
 
-int PlayerInfo::toResult(const QString& res) const
-{
-    if(res.startsWith("1/2"))
-    {
-        return Draw;
-    }
-    else if(res.startsWith('1'))
-    {
-        return WhiteWin;
-    }
-    else if(res.startsWith('0'))
-    {
-        return BlackWin;
-    }
-    else
-    {
-        return ResultUnknown;
-    }
-}
-
 void PlayerInfo::update()
 {
     QHash<QString, EcoFrequencyInfo> openings[2];
     QHash<QString, int> openingsX[2];
     const IndexX* index = m_database->index();
+    const GameStatistics& statistics = m_database->statistics();
 
     // Determine matching tag values
     ValueIndex player = index->getValueIndex(m_name);
@@ -95,46 +76,40 @@ void PlayerInfo::update()
     // Clean previous statistics
     reset();
 
-    for(int i = 0; i < (int)m_database->count(); ++i)
+    for(int c = White; c <= Black; ++c)
     {
-        Color c;
-        if(index->valueIndexFromTag(TagNameWhite, i) == player)
-        {
-            c = White;
-        }
-        else if(index->valueIndexFromTag(TagNameBlack, i) == player)
-        {
-            c = Black;
-        }
-        else
-        {
-            continue;
-        }
-        int res = toResult(index->tagValue(TagNameResult, i));
-        m_result[c][res]++;
-        m_count[c]++;
-        int elo = index->tagValue(c == White ? TagNameWhiteElo : TagNameBlackElo, i).toInt();
-        if(elo)
-        {
-            m_rating[0] = qMin(elo, m_rating[0]);
-            m_rating[1] = qMax(elo, m_rating[1]);
-        }
-        PartialDate date(index->tagValue(TagNameDate, i));
-        if(date.year() > 1000)
-        {
-            m_date[0] = qMin(date, m_date[0]);
-            m_date[1] = qMax(date, m_date[1]);
-        }
-        QString eco = index->tagValue(TagNameECO, i).left(3);
-        if(eco.length() == 3)
+        const QVector<GameId>& games = statistics.games(c == White ? GameStatistics::WhitePlayer : GameStatistics::BlackPlayer, player);
+        m_count[c] = games.count();
+        statistics.countResults(games, m_result[c]);
+        statistics.ratingRange(games, Color(c), m_rating[0], m_rating[1]);
+        statistics.dateRange(games, m_date[0], m_date[1]);
+
+        // Count per ECO value first, so that each distinct code is looked at only once
+        QHash<ValueIndex, EcoFrequencyInfo> codes;
+        for(GameId game : games)
         {
-            openings[c][eco].count++;
-            openings[c][eco].result[res]++;
+            EcoFrequencyInfo& info = codes[statistics.value(GameStatistics::Opening, game)];
+            info.count++;
+            info.result[statistics.result(game)]++;
         }
-        QString ecoX = index->tagValue(TagNameECO, i).left(4);
-        if(ecoX.length() >= 3)
+        for(auto it = codes.cbegin(); it != codes.cend(); ++it)
         {
-            openingsX[c][ecoX]++;
+            QString code = index->valueName(it.key());
+            QString eco = code.left(3);
+            if(eco.length() == 3)
+            {
+                EcoFrequencyInfo& info = openings[c][eco];
+                info.count += it.value().count;
+                for(int r = 0; r < 4; ++r)
+                {
+                    info.result[r] += it.value().result[r];
+                }
+            }
+            QString ecoX = code.left(4);
+            if(ecoX.length() >= 3)
+            {
+                openingsX[c][ecoX] += it.value().count;
+            }
         }
     }
 
@@ -8,6 +8,7 @@
 
 #include "polyglotdatabase.h"
 #include "board.h"
+#include "tags.h"
 
 using namespace  chessx;
 
@@ -855,6 +856,7 @@ void PolyglotDatabase::add_game(GameX& g, int result)
 void PolyglotDatabase::add_database_chunk(Database* db, int start, int end, volatile bool* breakFlag)
 {
     int progressCount = 1 + end / 100;
+    GameX game;
     for(int i = start; i < end; ++i)
     {
         if (!start)
@@ -863,9 +865,10 @@ void PolyglotDatabase::add_database_chunk(Database* db, int start, int end, vola
         }
 
         if (*breakFlag) return;
-        GameX game;
-        if(db->loadGame(i, game))
+        game.reset();
+        if(db->loadGameMainline(i, game))
         {
+            db->loadGameHeader(i, game, TagNameResult);
             int result = game.resultAsInt();
             if ((m_filterResult==0) || (m_filterResult != result))
             {
@@ -30,7 +30,10 @@ Settings::Settings(const QString &fileName) : QSettings(fileName, IniFormat)
 }
 
 Settings::~Settings()
-{}
+{
+    delete m_snapshot.loadRelaxed();
+    qDeleteAll(m_oldSnapshots);
+}
 
 void Settings::initialize()
 {
@@ -38,6 +41,7 @@ void Settings::initialize()
     beginGroup("GameText");
     BitBoard::PieceNames::custom().set(getValue("PieceString").toString());
     endGroup();
+    updateSnapshot();
 }
 
 QString Settings::dataPath()
@@ -224,6 +228,7 @@ QMap<QString, QVariant> Settings::initDefaultValues() const
     map.insert("/General/ListFontSize", DEFAULT_LISTFONTSIZE);
     map.insert("/General/onlineTablebases", true);
     map.insert("/General/tablebaseSource", 0);
+    map.insert("/General/syzygyPath", "");
     map.insert("/General/onlineVersionCheck", true);
     map.insert("/General/autoCommitDB", false);
     map.insert("/General/language", "Default");
@@ -358,6 +363,40 @@ QVariant Settings::getValue(const QString &key) const
     return value(key);
 }
 
+const SettingsSnapshot& Settings::snapshot() const
+{
+    const SettingsSnapshot* snapshot = m_snapshot.loadAcquire();
+    if (!snapshot)
+    {
+        const_cast<Settings*>(this)->updateSnapshot();
+        snapshot = m_snapshot.loadAcquire();
+    }
+    return *snapshot;
+}
+
+void Settings::updateSnapshot()
+{
+    SettingsSnapshot* snapshot = new SettingsSnapshot;
+    snapshot->automaticECO = getValue("/General/automaticECO").toBool();
+    snapshot->preserveECO = getValue("/General/preserveECO").toBool();
+    snapshot->useIndexFile = getValue("/General/useIndexFile").toBool();
+    snapshot->editLimit = getValue("/General/EditLimit").toInt();
+    snapshot->onlineTablebases = getValue("/General/onlineTablebases").toBool();
+    snapshot->tablebaseSource = getValue("/General/tablebaseSource").toInt();
+    snapshot->mergeAddSource = getValue("/General/mergeAddSource").toBool();
+    snapshot->mergeAddTag = getValue("/General/mergeAddTag").toString();
+    snapshot->hideSpecAnnotations = getValue("/GameText/HideSpecAnnotations").toBool();
+    snapshot->showDiagrams = getValue("/GameText/ShowDiagrams").toBool();
+
+    QMutexLocker lock(&m_snapshotMutex);
+    // Readers never lock, so the replaced snapshot stays valid until the settings are deleted
+    const SettingsSnapshot* old = m_snapshot.fetchAndStoreOrdered(snapshot);
+    if (old)
+    {
+        m_oldSnapshots.append(old);
+    }
+}
+
 void Settings::setValue(const QString &key, const QVariant& val)
 {
     QSettings::setValue(key, val);
@@ -10,6 +10,9 @@
 #ifndef SETTINGS_H_INCLUDED
 #define SETTINGS_H_INCLUDED
 
+#include <QAtomicPointer>
+#include <QList>
+#include <QMutex>
 #include <QSettings>
 #include <QString>
 #include "engineoptiondata.h"
@@ -33,6 +36,26 @@
 
 class QWidget;
 
+/** @ingroup Core
+    Immutable, typed copy of the settings read while loading and searching
+    databases. Reading it neither looks up defaults nor touches QSettings, so
+    it is cheap inside loops over games and safe in background threads.
+ */
+struct SettingsSnapshot
+{
+    bool automaticECO;
+    bool preserveECO;
+    bool useIndexFile;
+    /** Size in MB up to which databases are loaded into memory for editing */
+    int editLimit;
+    bool onlineTablebases;
+    int tablebaseSource;
+    bool mergeAddSource;
+    QString mergeAddTag;
+    bool hideSpecAnnotations;
+    bool showDiagrams;
+};
+
 class Settings : public QSettings
 {
     Q_OBJECT
@@ -90,6 +113,11 @@ public:
     /// Shadow `QSettings::setValue()` to have a hook for updating global state
     void setValue(const QString& key, const QVariant& val);
 
+    /** @return the current snapshot of the settings, which may be used from any thread */
+    const SettingsSnapshot& snapshot() const;
+    /** Rebuild the snapshot from the stored settings, after they were changed */
+    void updateSnapshot();
+
     void setMap(const QString& key, const OptionValueMap& map);
     void getMap(const QString& key, OptionValueMap& map);
 
@@ -129,6 +157,11 @@ private:
     QMap<QString, QVariant> defaultValues;
     QMap<QString, QVariant> initDefaultValues() const;
 
+    QAtomicPointer<const SettingsSnapshot> m_snapshot;
+    /** Replaced snapshots, which readers may still refer to */
+    QList<const SettingsSnapshot*> m_oldSnapshots;
+    QMutex m_snapshotMutex;
+
     QStringList getImageList(QString userPath, QString internalPath) const;
 };
 
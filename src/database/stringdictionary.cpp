@@ -0,0 +1,147 @@
+#include "stringdictionary.h"
+
+#include <QHash>
+
+#include <utility>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+StringDictionary::StringDictionary() :
+    m_count(0),
+    m_used(0)
+{
+}
+
+void StringDictionary::clear()
+{
+    m_slots.clear();
+    m_count = 0;
+    m_used = 0;
+}
+
+void StringDictionary::reserve(int size)
+{
+    int slots = 16;
+    while (slots * 3 < size * 4)
+    {
+        slots *= 2;
+    }
+    if (slots > m_slots.size())
+    {
+        rehash(slots);
+    }
+}
+
+int StringDictionary::findSlot(QStringView value, uint hash) const
+{
+    if (m_slots.isEmpty())
+    {
+        return -1;
+    }
+    int mask = m_slots.size() - 1;
+    for (int i = hash & mask; ; i = (i + 1) & mask)
+    {
+        const Slot& slot = m_slots.at(i);
+        if (slot.state == EmptySlot)
+        {
+            return -1;
+        }
+        if (slot.state == 0 && slot.hash == hash && slot.length == value.size() &&
+            QStringView(slot.value.constData(), slot.length) == value)
+        {
+            return i;
+        }
+    }
+}
+
+bool StringDictionary::find(QStringView value, quint32& id) const
+{
+    int i = findSlot(value, qHash(value));
+    if (i < 0)
+    {
+        return false;
+    }
+    id = m_slots.at(i).id;
+    return true;
+}
+
+void StringDictionary::insert(QStringView value, quint32 id)
+{
+    insert(value.toString(), id);
+}
+
+void StringDictionary::insert(const QString& value, quint32 id, int length)
+{
+    if (length < 0)
+    {
+        length = value.size();
+    }
+    QStringView key(value.constData(), length);
+    uint hash = qHash(key);
+    int i = findSlot(key, hash);
+    if (i >= 0)
+    {
+        m_slots[i].id = id;
+        m_slots[i].value = value;
+        return;
+    }
+
+    if ((m_used + 1) * 4 > m_slots.size() * 3)
+    {
+        rehash(qMax(16, (m_count + 1) * 4 > m_slots.size() * 3 ? m_slots.size() * 2 : m_slots.size()));
+    }
+
+    int mask = m_slots.size() - 1;
+    for (i = hash & mask; m_slots.at(i).state == 0; i = (i + 1) & mask)
+    {
+    }
+    if (m_slots.at(i).state == EmptySlot)
+    {
+        ++m_used;
+    }
+    Slot& slot = m_slots[i];
+    slot.hash = hash;
+    slot.id = id;
+    slot.state = 0;
+    slot.length = length;
+    slot.value = value;
+    ++m_count;
+}
+
+void StringDictionary::remove(QStringView value, quint32 id)
+{
+    int i = findSlot(value, qHash(value));
+    if (i >= 0 && m_slots.at(i).id == id)
+    {
+        m_slots[i].state = RemovedSlot;
+        m_slots[i].value.clear();
+        --m_count;
+    }
+}
+
+void StringDictionary::rehash(int size)
+{
+    QVector<Slot> slots(size);
+    for (Slot& slot: slots)
+    {
+        slot.state = EmptySlot;
+    }
+    int mask = size - 1;
+    for (Slot& slot: m_slots)
+    {
+        if (slot.state == 0)
+        {
+            int i = slot.hash & mask;
+            while (slots.at(i).state != EmptySlot)
+            {
+                i = (i + 1) & mask;
+            }
+            slots[i] = std::move(slot);
+        }
+    }
+    m_slots.swap(slots);
+    m_used = m_count;
+}
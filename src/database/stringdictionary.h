@@ -0,0 +1,62 @@
+#ifndef STRINGDICTIONARY_H
+#define STRINGDICTIONARY_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/** @ingroup Database
+    The StringDictionary class maps strings to ids chosen by the caller.
+    The strings are shared with the caller instead of copied, so a string
+    already held elsewhere is stored only once. The hash of each entry is
+    kept, so a lookup with a QStringView never allocates and rehashing never
+    hashes strings again. It is used by IndexX to find the ids of tag names
+    and values.
+*/
+
+class StringDictionary
+{
+public:
+    StringDictionary();
+
+    /** Removes all entries */
+    void clear();
+    /** Prepare the table for @p size entries */
+    void reserve(int size);
+    /** @return the number of entries */
+    int count() const { return m_count; }
+
+    /** Looks up @p value, returns true and sets @p id if it is known */
+    bool find(QStringView value, quint32& id) const;
+    /** Maps the first @p length characters of @p value, all if -1, to @p id, replacing a previous id of the same key */
+    void insert(const QString& value, quint32 id, int length = -1);
+    /** Maps a copy of @p value to @p id */
+    void insert(QStringView value, quint32 id);
+    /** Removes @p value from the dictionary if it maps to @p id */
+    void remove(QStringView value, quint32 id);
+
+private:
+    enum { EmptySlot = -1, RemovedSlot = -2 };
+
+    struct Slot
+    {
+        uint hash;
+        quint32 id;
+        /** EmptySlot, RemovedSlot or 0 if the slot is used */
+        int state;
+        /** The key is the first @p length characters of @p value */
+        int length;
+        QString value;
+    };
+
+    /** @return the slot holding @p value, or -1 */
+    int findSlot(QStringView value, uint hash) const;
+    /** Resize the table to @p size slots, which must be a power of two */
+    void rehash(int size);
+
+    QVector<Slot> m_slots;
+    int m_count;
+    int m_used;
+};
+
+#endif // STRINGDICTIONARY_H
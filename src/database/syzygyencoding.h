@@ -0,0 +1,45 @@
+/****************************************************************************
+*   Syzygy tablebase probing, derived from src/syzygy/tbprobe.cpp of
+*   Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+*   Copyright (C) 2013 Ronald de Man
+*   Copyright (C) 2004-2024 The Stockfish developers (see their AUTHORS)
+*
+*   This file is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version. See COPYING-GPLv3.txt.
+****************************************************************************/
+
+#ifndef SYZYGYENCODING_H
+#define SYZYGYENCODING_H
+
+#include <QtGlobal>
+
+/** @ingroup Feature
+ * Index tables of the position encoding of Syzygy tablebases.
+ *
+ * A position is mapped to its index in a table by combining these
+ * tables, see SyzygyTablebase. They are computed once on first use.
+ */
+struct SyzygyEncoding
+{
+    SyzygyEncoding();
+
+    /** @return the tables, shared by all tablebases */
+    static const SyzygyEncoding& instance();
+
+    /** Squares below the a1-h8 diagonal, numbered 0..27 */
+    int mapB1H1H7[64];
+    /** Squares of the a1-d1-d4 triangle, numbered 0..9 with the diagonal last */
+    int mapA1D1D4[64];
+    /** The 462 positions of two kings, by the code of the first one in mapA1D1D4 */
+    int mapKK[10][64];
+    /** binomial[k][n] is the number of ways to choose k elements from n */
+    quint64 binomial[6][64];
+    /** Squares a2-h7 of the leading pawn, numbered 47..0 from the edges to the center */
+    int mapPawns[64];
+    int leadPawnIdx[6][64];
+    int leadPawnsSize[6][4];
+};
+
+#endif // SYZYGYENCODING_H
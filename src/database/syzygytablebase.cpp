@@ -0,0 +1,1377 @@
+/****************************************************************************
+*   Syzygy tablebase probing, derived from src/syzygy/tbprobe.cpp of
+*   Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+*   Copyright (C) 2013 Ronald de Man
+*   Copyright (C) 2004-2024 The Stockfish developers (see their AUTHORS)
+*
+*   This file is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version. See COPYING-GPLv3.txt.
+****************************************************************************/
+
+#include "board.h"
+#include "qt6compat.h"
+#include "syzygyencoding.h"
+#include "syzygytablebase.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QRegularExpression>
+#include <QThreadStorage>
+#include <QtConcurrent/QtConcurrent>
+#include <QVector>
+#include <QtEndian>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+using namespace chessx;
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+// The file format and the position encoding follow the Syzygy tablebase
+// generator by Ronald de Man. The decoding below is a port of the probing
+// code of Stockfish to the board and file classes of ChessX.
+
+static const int TbPieces = 7;
+
+enum SyzygyWdl { WdlLoss = -2, WdlBlessedLoss = -1, WdlDraw = 0, WdlCursedWin = 1, WdlWin = 2 };
+
+enum SyzygyProbeState { ProbeFail = 0, ProbeOk = 1, ProbeChangeStm = -1, ProbeZeroingBestMove = 2 };
+
+enum SyzygyTableFlag { FlagStm = 1, FlagMapped = 2, FlagWinPlies = 4, FlagLossPlies = 8, FlagWide = 16, FlagSingleValue = 128 };
+
+static const uchar WdlMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+static const uchar DtzMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+
+static inline int fileOf(int s) { return s & 7; }
+static inline int rankOf(int s) { return s >> 3; }
+static inline int offA1H8(int s) { return rankOf(s) - fileOf(s); }
+static inline int flipFile(int s) { return s ^ 7; }
+static inline int flipRank(int s) { return s ^ 56; }
+static inline int signOf(int v) { return (v > 0) - (v < 0); }
+
+static inline int popLsb(quint64& b)
+{
+    int s = qCountTrailingZeroBits(b);
+    b &= b - 1;
+    return s;
+}
+
+SyzygyEncoding::SyzygyEncoding()
+{
+    memset(this, 0, sizeof(SyzygyEncoding));
+
+    // mapB1H1H7 encodes a square below the a1-h8 diagonal to 0..27
+    int code = 0;
+    for (int s = 0; s < 64; ++s)
+    {
+        if (offA1H8(s) < 0)
+        {
+            mapB1H1H7[s] = code++;
+        }
+    }
+
+    // mapA1D1D4 encodes a square in the a1-d1-d4 triangle to 0..9, diagonal squares last
+    QList<int> diagonal;
+    code = 0;
+    for (int s = a1; s <= d4; ++s)
+    {
+        if (offA1H8(s) < 0 && fileOf(s) <= FILE_D)
+        {
+            mapA1D1D4[s] = code++;
+        }
+        else if (!offA1H8(s) && fileOf(s) <= FILE_D)
+        {
+            diagonal.append(s);
+        }
+    }
+    for (int s : qAsConst(diagonal))
+    {
+        mapA1D1D4[s] = code++;
+    }
+
+    // mapKK encodes the 462 legal positions of two kings with the first one in the
+    // a1-d1-d4 triangle. If the first king is on the diagonal, the second one is not above it.
+    QList<QPair<int, int> > bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; ++idx)
+    {
+        for (int s1 = a1; s1 <= d4; ++s1)
+        {
+            if (mapA1D1D4[s1] != idx || (!idx && s1 != b1))
+            {
+                continue;
+            }
+            for (int s2 = 0; s2 < 64; ++s2)
+            {
+                if (qAbs(fileOf(s1) - fileOf(s2)) <= 1 && qAbs(rankOf(s1) - rankOf(s2)) <= 1)
+                {
+                    continue; // Illegal position
+                }
+                else if (!offA1H8(s1) && offA1H8(s2) > 0)
+                {
+                    continue; // First on diagonal, second above
+                }
+                else if (!offA1H8(s1) && !offA1H8(s2))
+                {
+                    bothOnDiagonal.append(qMakePair(idx, s2));
+                }
+                else
+                {
+                    mapKK[idx][s2] = code++;
+                }
+            }
+        }
+    }
+    for (const QPair<int, int>& p : qAsConst(bothOnDiagonal))
+    {
+        mapKK[p.first][p.second] = code++;
+    }
+
+    // binomial[k][n] is the number of ways to choose k elements from a set of n
+    binomial[0][0] = 1;
+    for (int n = 1; n < 64; ++n)
+    {
+        for (int k = 0; k < 6 && k <= n; ++k)
+        {
+            binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0)
+                           + (k < n ? binomial[k][n - 1] : 0);
+        }
+    }
+
+    // mapPawns encodes the squares a2-h7 to 0..47, the number of squares available to the
+    // other pawns when the leading pawn is on that square. The leading pawn is the one
+    // with the highest value: nearest to the edge and, on the same file, on the lowest rank.
+    int availableSquares = 47;
+    for (int leadPawnsCnt = 1; leadPawnsCnt <= 5; ++leadPawnsCnt)
+    {
+        for (int f = FILE_A; f <= FILE_D; ++f)
+        {
+            int idx = 0;
+            for (int r = 1; r <= 6; ++r)
+            {
+                int sq = r * 8 + f;
+                if (leadPawnsCnt == 1)
+                {
+                    mapPawns[sq] = availableSquares--;
+                    mapPawns[flipFile(sq)] = availableSquares--;
+                }
+                leadPawnIdx[leadPawnsCnt][sq] = idx;
+                idx += static_cast<int>(binomial[leadPawnsCnt - 1][mapPawns[sq]]);
+            }
+            leadPawnsSize[leadPawnsCnt][f] = idx;
+        }
+    }
+}
+
+Q_GLOBAL_STATIC(SyzygyEncoding, s_encoding)
+
+const SyzygyEncoding& SyzygyEncoding::instance()
+{
+    return *s_encoding;
+}
+
+/** Decoding data of one compressed table of a file, see setSizes() */
+struct SyzygyPairs
+{
+    quint8 flags;
+    quint64 sizeofBlock;
+    quint64 span;
+    int numBlocks;
+    int maxSymLen;
+    int minSymLen;
+    const uchar* lowestSym;
+    const uchar* btree;
+    const uchar* blockLength;
+    int blockLengthSize;
+    const uchar* sparseIndex;
+    quint64 sparseIndexSize;
+    const uchar* data;
+    QVector<quint64> base64;
+    QVector<quint8> symlen;
+    int pieces[TbPieces];
+    quint64 groupIdx[TbPieces + 1];
+    int groupLen[TbPieces + 1];
+    quint16 mapIdx[4];
+
+    /** @return the value stored at index @p idx */
+    int decompress(quint64 idx) const;
+
+    int lowest(int len) const { return qFromLittleEndian<quint16>(lowestSym + 2 * len); }
+    int left(int sym) const { const uchar* lr = btree + 3 * sym; return ((lr[1] & 0xF) << 8) | lr[0]; }
+    int right(int sym) const { const uchar* lr = btree + 3 * sym; return (lr[2] << 4) | (lr[1] >> 4); }
+    int blockLen(quint32 block) const { return qFromLittleEndian<quint16>(blockLength + 2 * block); }
+};
+
+int SyzygyPairs::decompress(quint64 idx) const
+{
+    if (flags & FlagSingleValue)
+    {
+        return minSymLen;
+    }
+
+    // The sparse index points to the block and offset of every span-th value
+    quint32 k = static_cast<quint32>(idx / span);
+    const uchar* sparse = sparseIndex + 6 * k;
+    quint32 block = qFromLittleEndian<quint32>(sparse);
+    int offset = qFromLittleEndian<quint16>(sparse + 4);
+    offset += static_cast<int>(idx % span) - static_cast<int>(span / 2);
+
+    while (offset < 0)
+    {
+        offset += blockLen(--block) + 1;
+    }
+    while (offset > blockLen(block))
+    {
+        offset -= blockLen(block++) + 1;
+    }
+
+    // Walk the canonical Huffman symbols of the block until the one covering offset
+    const uchar* ptr = data + static_cast<quint64>(block) * sizeofBlock;
+    quint64 buf64 = qFromBigEndian<quint64>(ptr);
+    ptr += 8;
+    int buf64Size = 64;
+    quint16 sym;
+
+    while (true)
+    {
+        int len = 0;
+        while (buf64 < base64.at(len))
+        {
+            ++len;
+        }
+        sym = static_cast<quint16>((buf64 - base64.at(len)) >> (64 - len - minSymLen));
+        sym += static_cast<quint16>(lowest(len));
+        if (offset < symlen.at(sym) + 1)
+        {
+            break;
+        }
+        offset -= symlen.at(sym) + 1;
+        len += minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32)
+        {
+            buf64Size += 32;
+            buf64 |= static_cast<quint64>(qFromBigEndian<quint32>(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    // Expand the symbol of the recursive pairing tree down to the value
+    while (symlen.at(sym))
+    {
+        int l = left(sym);
+        if (offset < symlen.at(l) + 1)
+        {
+            sym = static_cast<quint16>(l);
+        }
+        else
+        {
+            offset -= symlen.at(l) + 1;
+            sym = static_cast<quint16>(right(sym));
+        }
+    }
+    return left(sym);
+}
+
+/** A WDL or DTZ file of a table */
+struct SyzygyFile
+{
+    SyzygyFile() : file(nullptr), map(nullptr), valid(false) {}
+    ~SyzygyFile() { delete file; }
+
+    QString fileName;
+    QFile* file;
+    /** DTZ value maps */
+    const uchar* map;
+    QAtomicInt ready;
+    bool valid;
+    SyzygyPairs items[2][4];
+};
+
+/** A table, like KRvK, with its WDL and DTZ files */
+struct SyzygyTableEntry
+{
+    quint64 key;
+    quint64 key2;
+    int pieceCount;
+    bool hasPawns;
+    bool hasUniquePieces;
+    quint8 pawnCount[2];
+    SyzygyFile wdl;
+    SyzygyFile dtz;
+    QMutex mutex;
+
+    /** @return the decoding data for side @p stm and the file @p f of the leading pawn */
+    SyzygyPairs* pairs(bool isDtz, int stm, int f)
+    {
+        return isDtz ? &dtz.items[0][hasPawns ? f : 0] : &wdl.items[stm % 2][hasPawns ? f : 0];
+    }
+
+    bool setup(bool isDtz, const uchar* data);
+    void setGroups(SyzygyPairs* d, const int order[], int f);
+    const uchar* setSizes(SyzygyPairs* d, const uchar* data);
+    const uchar* setDtzMap(const uchar* data, int maxFile);
+    bool map(bool isDtz);
+};
+
+/** Material key of a side: four bits per colored piece */
+static inline quint64 materialBit(int color, int type)
+{
+    return quint64(1) << (4 * (color * 6 + type - 1));
+}
+
+/** Syzygy piece code of @p p: pawn 1 .. king 6, +8 for black */
+static inline int tbPiece(Piece p)
+{
+    if (!isValidPiece(p))
+    {
+        return 0;
+    }
+    int type = 7 - pieceType(p);
+    return pieceColor(p) == Black ? type + 8 : type;
+}
+
+static quint8 setSymlen(SyzygyPairs* d, int s, QVector<bool>& visited)
+{
+    visited[s] = true;
+    int sr = d->right(s);
+    if (sr == 0xFFF)
+    {
+        return 0;
+    }
+    int sl = d->left(s);
+    if (!visited.at(sl))
+    {
+        d->symlen[sl] = setSymlen(d, sl, visited);
+    }
+    if (!visited.at(sr))
+    {
+        d->symlen[sr] = setSymlen(d, sr, visited);
+    }
+    return d->symlen.at(sl) + d->symlen.at(sr) + 1;
+}
+
+void SyzygyTableEntry::setGroups(SyzygyPairs* d, const int order[], int f)
+{
+    const SyzygyEncoding& enc = *s_encoding;
+    int n = 0;
+    int firstLen = hasPawns ? 0 : hasUniquePieces ? 3 : 2;
+    d->groupLen[n] = 1;
+
+    // Pieces of a group have the same code, the leading group also holds the unique pieces
+    for (int i = 1; i < pieceCount; ++i)
+    {
+        if (--firstLen > 0 || d->pieces[i] == d->pieces[i - 1])
+        {
+            d->groupLen[n]++;
+        }
+        else
+        {
+            d->groupLen[++n] = 1;
+        }
+    }
+    d->groupLen[++n] = 0;
+
+    // The groups are encoded in the order given by the file, leading group at order[0]
+    // and the remaining pawns at order[1]
+    bool pp = hasPawns && pawnCount[1];
+    int next = pp ? 2 : 1;
+    int freeSquares = 64 - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+    quint64 idx = 1;
+
+    for (int k = 0; next < n || k == order[0] || k == order[1]; ++k)
+    {
+        if (k == order[0])
+        {
+            d->groupIdx[0] = idx;
+            idx *= hasPawns ? enc.leadPawnsSize[d->groupLen[0]][f] : hasUniquePieces ? 31332 : 462;
+        }
+        else if (k == order[1])
+        {
+            d->groupIdx[1] = idx;
+            idx *= enc.binomial[d->groupLen[1]][48 - d->groupLen[0]];
+        }
+        else
+        {
+            d->groupIdx[next] = idx;
+            idx *= enc.binomial[d->groupLen[next]][freeSquares];
+            freeSquares -= d->groupLen[next++];
+        }
+    }
+    d->groupIdx[n] = idx;
+}
+
+const uchar* SyzygyTableEntry::setSizes(SyzygyPairs* d, const uchar* data)
+{
+    d->flags = *data++;
+
+    if (d->flags & FlagSingleValue)
+    {
+        d->numBlocks = 0;
+        d->span = 0;
+        d->sparseIndexSize = 0;
+        d->blockLengthSize = 0;
+        d->minSymLen = *data++; // The single value
+        return data;
+    }
+
+    int groups = 0;
+    while (groups < TbPieces && d->groupLen[groups])
+    {
+        ++groups;
+    }
+    quint64 tbSize = d->groupIdx[groups];
+
+    d->sizeofBlock = quint64(1) << *data++;
+    d->span = quint64(1) << *data++;
+    d->sparseIndexSize = (tbSize + d->span - 1) / d->span;
+    int padding = *data++;
+    d->numBlocks = static_cast<int>(qFromLittleEndian<quint32>(data));
+    data += 4;
+    d->blockLengthSize = d->numBlocks + padding;
+    d->maxSymLen = *data++;
+    d->minSymLen = *data++;
+    d->lowestSym = data;
+    d->base64.fill(0, d->maxSymLen - d->minSymLen + 1);
+
+    // Canonical Huffman code: longer symbols have lower values, base64[i] is the
+    // lowest symbol of length i + minSymLen, left aligned in 64 bits
+    for (int i = d->base64.size() - 2; i >= 0; --i)
+    {
+        d->base64[i] = (d->base64.at(i + 1) + d->lowest(i) - d->lowest(i + 1)) / 2;
+    }
+    for (int i = 0; i < d->base64.size(); ++i)
+    {
+        d->base64[i] <<= 64 - i - d->minSymLen;
+    }
+    data += d->base64.size() * 2;
+
+    d->symlen.fill(0, qFromLittleEndian<quint16>(data));
+    data += 2;
+    d->btree = data;
+
+    // Number of values represented by each symbol of the recursive pairing
+    QVector<bool> visited(d->symlen.size());
+    for (int sym = 0; sym < d->symlen.size(); ++sym)
+    {
+        if (!visited.at(sym))
+        {
+            d->symlen[sym] = setSymlen(d, sym, visited);
+        }
+    }
+    return data + d->symlen.size() * 3 + (d->symlen.size() & 1);
+}
+
+const uchar* SyzygyTableEntry::setDtzMap(const uchar* data, int maxFile)
+{
+    dtz.map = data;
+    for (int f = FILE_A; f <= maxFile; ++f)
+    {
+        SyzygyPairs* d = pairs(true, 0, f);
+        if (d->flags & FlagMapped)
+        {
+            if (d->flags & FlagWide)
+            {
+                data += reinterpret_cast<quintptr>(data) & 1; // Word alignment
+                for (int i = 0; i < 4; ++i)
+                {
+                    d->mapIdx[i] = static_cast<quint16>((data - dtz.map) / 2 + 1);
+                    data += 2 * qFromLittleEndian<quint16>(data) + 2;
+                }
+            }
+            else
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    d->mapIdx[i] = static_cast<quint16>(data - dtz.map + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+    }
+    return data + (reinterpret_cast<quintptr>(data) & 1);
+}
+
+bool SyzygyTableEntry::setup(bool isDtz, const uchar* data)
+{
+    enum { Split = 1, HasPawns = 2 };
+
+    if (bool(*data & HasPawns) != hasPawns)
+    {
+        return false;
+    }
+    data++;
+
+    const int sides = !isDtz && (key != key2) ? 2 : 1;
+    const int maxFile = hasPawns ? FILE_D : FILE_A;
+    bool pp = hasPawns && pawnCount[1];
+
+    for (int f = FILE_A; f <= maxFile; ++f)
+    {
+        int order[2][2] = { { *data & 0xF, pp ? *(data + 1) & 0xF : 0xF },
+                            { *data >> 4, pp ? *(data + 1) >> 4 : 0xF } };
+        data += 1 + pp;
+
+        for (int k = 0; k < pieceCount; ++k, ++data)
+        {
+            for (int i = 0; i < sides; ++i)
+            {
+                pairs(isDtz, i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+            }
+        }
+        for (int i = 0; i < sides; ++i)
+        {
+            setGroups(pairs(isDtz, i, f), order[i], f);
+        }
+    }
+    data += reinterpret_cast<quintptr>(data) & 1;
+
+    for (int f = FILE_A; f <= maxFile; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            data = setSizes(pairs(isDtz, i, f), data);
+        }
+    }
+
+    if (isDtz)
+    {
+        data = setDtzMap(data, maxFile);
+    }
+
+    for (int f = FILE_A; f <= maxFile; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            SyzygyPairs* d = pairs(isDtz, i, f);
+            d->sparseIndex = data;
+            data += d->sparseIndexSize * 6;
+        }
+    }
+    for (int f = FILE_A; f <= maxFile; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            SyzygyPairs* d = pairs(isDtz, i, f);
+            d->blockLength = data;
+            data += d->blockLengthSize * 2;
+        }
+    }
+    for (int f = FILE_A; f <= maxFile; ++f)
+    {
+        for (int i = 0; i < sides; ++i)
+        {
+            SyzygyPairs* d = pairs(isDtz, i, f);
+            data = reinterpret_cast<const uchar*>((reinterpret_cast<quintptr>(data) + 0x3F) & ~quintptr(0x3F));
+            d->data = data;
+            data += d->numBlocks * d->sizeofBlock;
+        }
+    }
+    return true;
+}
+
+bool SyzygyTableEntry::map(bool isDtz)
+{
+    SyzygyFile& tf = isDtz ? dtz : wdl;
+    if (tf.ready.loadAcquire())
+    {
+        return tf.valid;
+    }
+
+    QMutexLocker m(&mutex);
+    if (tf.ready.loadAcquire())
+    {
+        return tf.valid;
+    }
+
+    if (!tf.fileName.isEmpty())
+    {
+        tf.file = new QFile(tf.fileName);
+        // Files are a multiple of 64 bytes plus the 16 byte header
+        if (tf.file->open(QIODevice::ReadOnly) && tf.file->size() % 64 == 16)
+        {
+            const uchar* data = tf.file->map(0, tf.file->size());
+            if (data && !memcmp(data, isDtz ? DtzMagic : WdlMagic, 4))
+            {
+                tf.valid = setup(isDtz, data + 4);
+            }
+        }
+        if (!tf.valid)
+        {
+            delete tf.file;
+            tf.file = nullptr;
+        }
+    }
+    tf.ready.storeRelease(1);
+    return tf.valid;
+}
+
+/** The pieces of a position as needed for encoding it */
+struct SyzygyPosition
+{
+    explicit SyzygyPosition(const BoardX& board);
+
+    int pieceOn[64];
+    quint64 occupied;
+    quint64 pawns[2];
+    int stm;
+    int pieceCount;
+    quint64 materialKey;
+};
+
+SyzygyPosition::SyzygyPosition(const BoardX& board)
+{
+    occupied = 0;
+    pawns[0] = pawns[1] = 0;
+    pieceCount = 0;
+    materialKey = 0;
+    stm = board.toMove() == Black ? 1 : 0;
+    for (int s = 0; s < 64; ++s)
+    {
+        int pc = tbPiece(board.pieceAt(Square(s)));
+        pieceOn[s] = pc;
+        if (pc)
+        {
+            occupied |= quint64(1) << s;
+            ++pieceCount;
+            materialKey += materialBit(pc >> 3, pc & 7);
+            if ((pc & 7) == 1)
+            {
+                pawns[pc >> 3] |= quint64(1) << s;
+            }
+        }
+    }
+}
+
+static bool pawnsComp(int i, int j)
+{
+    return s_encoding->mapPawns[i] < s_encoding->mapPawns[j];
+}
+
+/** Legal moves of a position and the positions after them */
+typedef QList<QPair<Move, BoardX> > SyzygyChildren;
+
+static SyzygyChildren legalChildren(const BoardX& board)
+{
+    SyzygyChildren children;
+    Move::List moves = board.generateMoves();
+    Color mover = board.toMove();
+    for (const Move& move : qAsConst(moves))
+    {
+        BoardX child(board);
+        child.doMove(move);
+        if (!child.isAttackedBy(child.toMove(), child.kingSquare(mover)))
+        {
+            children.append(qMakePair(move, child));
+        }
+    }
+    return children;
+}
+
+static inline bool isZeroing(const Move& move)
+{
+    return move.isCapture() || pieceType(move.pieceMoved()) == Pawn;
+}
+
+static int dtzBeforeZeroing(int wdl)
+{
+    return wdl == WdlWin         ?  1   :
+           wdl == WdlCursedWin   ?  101 :
+           wdl == WdlBlessedLoss ? -101 :
+           wdl == WdlLoss        ? -1   : 0;
+}
+
+/** Per-thread cache of probe results */
+struct SyzygyCacheEntry
+{
+    quint64 key;
+    int generation;
+    qint16 dtz;
+    qint8 wdl;
+    quint8 flags;
+};
+
+struct SyzygyProbeCache
+{
+    enum { Size = 1 << 14, HasWdl = 1, HasDtz = 2 };
+    SyzygyProbeCache() : entries(Size) {}
+    QVector<SyzygyCacheEntry> entries;
+};
+
+static QThreadStorage<SyzygyProbeCache*> s_probeCache;
+static QAtomicInt s_generation;
+
+static SyzygyCacheEntry& cacheEntry(quint64 key, int generation)
+{
+    if (!s_probeCache.hasLocalData())
+    {
+        s_probeCache.setLocalData(new SyzygyProbeCache);
+    }
+    SyzygyCacheEntry& entry = s_probeCache.localData()->entries[static_cast<int>(key & (SyzygyProbeCache::Size - 1))];
+    if (entry.key != key || entry.generation != generation)
+    {
+        entry.key = key;
+        entry.generation = generation;
+        entry.flags = 0;
+    }
+    return entry;
+}
+
+/** Probing of a set of tables */
+class SyzygyProber
+{
+public:
+    SyzygyProber(const QHash<quint64, SyzygyTableEntry*>& tables, int generation) :
+        m_tables(tables), m_generation(generation) {}
+
+    int probeWdl(const BoardX& board, SyzygyProbeState& result) const;
+    int probeDtz(const BoardX& board, SyzygyProbeState& result) const;
+
+private:
+    int search(const BoardX& board, SyzygyProbeState& result, bool checkZeroingMoves) const;
+    int probeTable(const SyzygyPosition& pos, bool isDtz, SyzygyProbeState& result, int wdl = WdlDraw) const;
+    int probeTable(SyzygyTableEntry* e, const SyzygyPosition& pos, bool isDtz, SyzygyProbeState& result, int wdl) const;
+
+    const QHash<quint64, SyzygyTableEntry*>& m_tables;
+    int m_generation;
+};
+
+int SyzygyProber::probeTable(const SyzygyPosition& pos, bool isDtz, SyzygyProbeState& result, int wdl) const
+{
+    if (pos.pieceCount == 2) // KvK
+    {
+        return WdlDraw;
+    }
+    SyzygyTableEntry* e = m_tables.value(pos.materialKey);
+    if (!e || !e->map(isDtz))
+    {
+        result = ProbeFail;
+        return 0;
+    }
+    return probeTable(e, pos, isDtz, result, wdl);
+}
+
+int SyzygyProber::probeTable(SyzygyTableEntry* e, const SyzygyPosition& pos, bool isDtz, SyzygyProbeState& result, int wdl) const
+{
+    const SyzygyEncoding& enc = *s_encoding;
+    int squares[TbPieces];
+    int pieces[TbPieces];
+    quint64 idx;
+    int next = 0;
+    int size = 0;
+    int leadPawnsCnt = 0;
+    quint64 b;
+    quint64 leadPawns = 0;
+    int tbFile = FILE_A;
+
+    // Tables are stored with the stronger side as white and symmetric tables only
+    // with white to move, otherwise colors are switched and squares flipped
+    bool symmetricBlackToMove = (e->key == e->key2 && pos.stm);
+    bool blackStronger = (pos.materialKey != e->key);
+    bool flip = symmetricBlackToMove || blackStronger;
+    int flipColor = flip ? 8 : 0;
+    int flipSquares = flip ? 56 : 0;
+    int stm = int(flip) ^ pos.stm;
+
+    // With pawns there are separate tables for the file of the leading pawn
+    if (e->hasPawns)
+    {
+        int pc = e->pairs(isDtz, 0, 0)->pieces[0] ^ flipColor;
+        leadPawns = b = pos.pawns[pc >> 3];
+        do
+        {
+            squares[size++] = popLsb(b) ^ flipSquares;
+        }
+        while (b);
+        leadPawnsCnt = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, pawnsComp));
+        tbFile = qMin(fileOf(squares[0]), FILE_H - fileOf(squares[0]));
+    }
+
+    // DTZ tables only store one side to move
+    if (isDtz)
+    {
+        int flags = e->pairs(true, stm, tbFile)->flags;
+        if ((flags & FlagStm) != stm && !(e->key == e->key2 && !e->hasPawns))
+        {
+            result = ProbeChangeStm;
+            return 0;
+        }
+    }
+
+    b = pos.occupied ^ leadPawns;
+    do
+    {
+        int s = popLsb(b);
+        squares[size] = s ^ flipSquares;
+        pieces[size++] = pos.pieceOn[s] ^ flipColor;
+    }
+    while (b);
+
+    SyzygyPairs* d = e->pairs(isDtz, stm, tbFile);
+
+    // Order the pieces as in the table
+    for (int i = leadPawnsCnt; i < size - 1; ++i)
+    {
+        for (int j = i + 1; j < size; ++j)
+        {
+            if (d->pieces[i] == pieces[j])
+            {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    // The leading piece goes to the a1-d1-d4 triangle
+    if (fileOf(squares[0]) > FILE_D)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            squares[i] = flipFile(squares[i]);
+        }
+    }
+
+    if (e->hasPawns)
+    {
+        idx = enc.leadPawnIdx[leadPawnsCnt][squares[0]];
+        std::stable_sort(squares + 1, squares + leadPawnsCnt, pawnsComp);
+        for (int i = 1; i < leadPawnsCnt; ++i)
+        {
+            idx += enc.binomial[i][enc.mapPawns[squares[i]]];
+        }
+    }
+    else
+    {
+        if (rankOf(squares[0]) > 3)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                squares[i] = flipRank(squares[i]);
+            }
+        }
+
+        // The first piece of the leading group off the a1-h8 diagonal goes below it
+        for (int i = 0; i < d->groupLen[0]; ++i)
+        {
+            if (!offA1H8(squares[i]))
+            {
+                continue;
+            }
+            if (offA1H8(squares[i]) > 0)
+            {
+                for (int j = i; j < size; ++j)
+                {
+                    squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                }
+            }
+            break;
+        }
+
+        if (e->hasUniquePieces)
+        {
+            // Three unique pieces, kings included, are encoded together
+            int adjust1 = (squares[1] > squares[0]);
+            int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+            if (offA1H8(squares[0]))
+            {
+                idx = (enc.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2;
+            }
+            else if (offA1H8(squares[1]))
+            {
+                idx = (6 * 63 + rankOf(squares[0]) * 28 + enc.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2;
+            }
+            else if (offA1H8(squares[2]))
+            {
+                idx = 6 * 63 * 62 + 4 * 28 * 62
+                    + rankOf(squares[0]) * 7 * 28
+                    + (rankOf(squares[1]) - adjust1) * 28
+                    + enc.mapB1H1H7[squares[2]];
+            }
+            else
+            {
+                idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+                    + rankOf(squares[0]) * 7 * 6
+                    + (rankOf(squares[1]) - adjust1) * 6
+                    + (rankOf(squares[2]) - adjust2);
+            }
+        }
+        else
+        {
+            idx = enc.mapKK[enc.mapA1D1D4[squares[0]]][squares[1]];
+        }
+    }
+
+    // Encode the remaining groups, squares taken by earlier groups are skipped
+    idx *= d->groupIdx[0];
+    int* groupSq = squares + d->groupLen[0];
+    bool remainingPawns = e->hasPawns && e->pawnCount[1];
+
+    while (d->groupLen[++next])
+    {
+        std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+        quint64 n = 0;
+        for (int i = 0; i < d->groupLen[next]; ++i)
+        {
+            int adjust = 0;
+            for (int* s = squares; s < groupSq; ++s)
+            {
+                adjust += groupSq[i] > *s;
+            }
+            n += enc.binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+        }
+        remainingPawns = false;
+        idx += n * d->groupIdx[next];
+        groupSq += d->groupLen[next];
+    }
+
+    int value = d->decompress(idx);
+    if (!isDtz)
+    {
+        return value - 2;
+    }
+
+    // DTZ values may be mapped and stored in moves instead of plies
+    static const int WdlMap[] = { 1, 3, 0, 2, 0 };
+    SyzygyPairs* d0 = e->pairs(true, 0, tbFile);
+    if (d0->flags & FlagMapped)
+    {
+        int i = d0->mapIdx[WdlMap[wdl + 2]] + value;
+        value = (d0->flags & FlagWide) ? qFromLittleEndian<quint16>(e->dtz.map + 2 * i) : e->dtz.map[i];
+    }
+    if ((wdl == WdlWin && !(d0->flags & FlagWinPlies))
+            || (wdl == WdlLoss && !(d0->flags & FlagLossPlies))
+            || wdl == WdlCursedWin
+            || wdl == WdlBlessedLoss)
+    {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+int SyzygyProber::search(const BoardX& board, SyzygyProbeState& result, bool checkZeroingMoves) const
+{
+    // Tables don't know about en passant and store "don't care" values where the
+    // best move is a capture, so captures (and pawn moves for DTZ) are searched
+    int value;
+    int bestValue = WdlLoss;
+    SyzygyChildren children = legalChildren(board);
+    int moveCount = 0;
+
+    for (const QPair<Move, BoardX>& child : qAsConst(children))
+    {
+        if (!child.first.isCapture() && (!checkZeroingMoves || pieceType(child.first.pieceMoved()) != Pawn))
+        {
+            continue;
+        }
+        ++moveCount;
+        value = -search(child.second, result, false);
+        if (result == ProbeFail)
+        {
+            return WdlDraw;
+        }
+        if (value > bestValue)
+        {
+            bestValue = value;
+            if (value >= WdlWin)
+            {
+                result = ProbeZeroingBestMove;
+                return value;
+            }
+        }
+    }
+
+    bool noMoreMoves = (moveCount && moveCount == children.count());
+    if (noMoreMoves)
+    {
+        value = bestValue;
+    }
+    else
+    {
+        value = probeTable(SyzygyPosition(board), false, result);
+        if (result == ProbeFail)
+        {
+            return WdlDraw;
+        }
+    }
+
+    if (bestValue >= value)
+    {
+        result = (bestValue > WdlDraw || noMoreMoves) ? ProbeZeroingBestMove : ProbeOk;
+        return bestValue;
+    }
+    result = ProbeOk;
+    return value;
+}
+
+int SyzygyProber::probeWdl(const BoardX& board, SyzygyProbeState& result) const
+{
+    SyzygyCacheEntry& entry = cacheEntry(board.getHashValue(), m_generation);
+    if (entry.flags & SyzygyProbeCache::HasWdl)
+    {
+        result = ProbeOk;
+        return entry.wdl;
+    }
+    result = ProbeOk;
+    int wdl = search(board, result, false);
+    if (result != ProbeFail)
+    {
+        SyzygyCacheEntry& e = cacheEntry(board.getHashValue(), m_generation);
+        e.wdl = static_cast<qint8>(wdl);
+        e.flags |= SyzygyProbeCache::HasWdl;
+    }
+    return wdl;
+}
+
+int SyzygyProber::probeDtz(const BoardX& board, SyzygyProbeState& result) const
+{
+    SyzygyCacheEntry& entry = cacheEntry(board.getHashValue(), m_generation);
+    if (entry.flags & SyzygyProbeCache::HasDtz)
+    {
+        result = ProbeOk;
+        return entry.dtz;
+    }
+
+    result = ProbeOk;
+    int wdl = search(board, result, true);
+    int dtz;
+
+    if (result == ProbeFail || wdl == WdlDraw) // DTZ tables don't store draws
+    {
+        dtz = 0;
+    }
+    else if (result == ProbeZeroingBestMove)
+    {
+        dtz = dtzBeforeZeroing(wdl);
+    }
+    else
+    {
+        dtz = probeTable(SyzygyPosition(board), true, result, wdl);
+        if (result == ProbeFail)
+        {
+            return 0;
+        }
+        if (result != ProbeChangeStm)
+        {
+            dtz = (dtz + 100 * (wdl == WdlBlessedLoss || wdl == WdlCursedWin)) * signOf(wdl);
+        }
+        else
+        {
+            // The table stores the other side to move: take the best reply
+            int minDtz = 0xFFFF;
+            SyzygyChildren children = legalChildren(board);
+            for (const QPair<Move, BoardX>& child : qAsConst(children))
+            {
+                bool zeroing = isZeroing(child.first);
+                dtz = zeroing ? -dtzBeforeZeroing(search(child.second, result, false))
+                              : -probeDtz(child.second, result);
+                if (result == ProbeFail)
+                {
+                    return 0;
+                }
+                if (dtz == 1 && child.second.isCheckmate())
+                {
+                    minDtz = 1;
+                }
+                if (!zeroing)
+                {
+                    dtz += signOf(dtz);
+                }
+                if (dtz < minDtz && signOf(dtz) == signOf(wdl))
+                {
+                    minDtz = dtz;
+                }
+            }
+            dtz = minDtz == 0xFFFF ? -1 : minDtz;
+            result = ProbeOk;
+        }
+    }
+
+    if (result == ProbeFail)
+    {
+        return 0;
+    }
+    SyzygyCacheEntry& e = cacheEntry(board.getHashValue(), m_generation);
+    e.dtz = static_cast<qint16>(dtz);
+    e.flags |= SyzygyProbeCache::HasDtz;
+    return dtz;
+}
+
+// ---------------------------------------------------------
+
+SyzygyTablebase::SyzygyTablebase() :
+    m_maxPieces(0),
+    m_generation(0)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+SyzygyTablebase::~SyzygyTablebase()
+{
+    m_request.fetchAndAddRelaxed(1);
+    m_pool.waitForDone();
+    qDeleteAll(m_entries);
+}
+
+void SyzygyTablebase::setPath(const QString& path)
+{
+    m_request.fetchAndAddRelaxed(1);
+    m_pool.waitForDone();
+
+    m_tables.clear();
+    qDeleteAll(m_entries);
+    m_entries.clear();
+    m_maxPieces = 0;
+    m_fen.clear();
+    m_generation = s_generation.fetchAndAddRelaxed(1) + 1;
+
+    static const QString PieceChars("KQRBNP");
+    QRegularExpression tableName("^K[QRBNP]*vK[QRBNP]*$");
+    QHash<QString, SyzygyTableEntry*> entries;
+
+    const QStringList dirs = path.split(QDir::listSeparator(), SkipEmptyParts);
+    for (const QString& dir : dirs)
+    {
+        const QFileInfoList files = QDir(dir).entryInfoList(QStringList() << "*.rtbw" << "*.rtbz", QDir::Files);
+        for (const QFileInfo& fi : files)
+        {
+            QString name = fi.completeBaseName();
+            if (!tableName.match(name).hasMatch() || name.length() - 1 > TbPieces)
+            {
+                continue;
+            }
+            SyzygyTableEntry* e = entries.value(name);
+            if (!e)
+            {
+                e = new SyzygyTableEntry;
+                QString white = name.section('v', 0, 0);
+                QString black = name.section('v', 1, 1);
+                int counts[2][7];
+                memset(counts, 0, sizeof(counts));
+                e->key = e->key2 = 0;
+                for (int c = 0; c < 2; ++c)
+                {
+                    const QString& side = c ? black : white;
+                    for (QChar ch : side)
+                    {
+                        int type = 6 - PieceChars.indexOf(ch); // King 6 .. Pawn 1
+                        ++counts[c][type];
+                        e->key += materialBit(c, type);
+                        e->key2 += materialBit(1 - c, type);
+                    }
+                }
+                e->pieceCount = white.length() + black.length();
+                e->hasPawns = counts[0][1] || counts[1][1];
+                e->hasUniquePieces = false;
+                for (int c = 0; c < 2; ++c)
+                {
+                    for (int type = 1; type < 6; ++type)
+                    {
+                        if (counts[c][type] == 1)
+                        {
+                            e->hasUniquePieces = true;
+                        }
+                    }
+                }
+                // The leading color is the one with less pawns, but with pawns
+                bool c = !counts[1][1] || (counts[0][1] && counts[1][1] >= counts[0][1]);
+                e->pawnCount[0] = static_cast<quint8>(counts[c ? 0 : 1][1]);
+                e->pawnCount[1] = static_cast<quint8>(counts[c ? 1 : 0][1]);
+                entries.insert(name, e);
+                m_entries.append(e);
+                m_tables.insert(e->key, e);
+                m_tables.insert(e->key2, e);
+            }
+            SyzygyFile& tf = fi.suffix() == "rtbw" ? e->wdl : e->dtz;
+            if (tf.fileName.isEmpty())
+            {
+                tf.fileName = fi.absoluteFilePath();
+            }
+            if (!e->wdl.fileName.isEmpty())
+            {
+                m_maxPieces = qMax(m_maxPieces, e->pieceCount);
+            }
+        }
+    }
+}
+
+bool SyzygyTablebase::covers(const BoardX& board) const
+{
+    if (board.castlingRights() != NoRights)
+    {
+        return false;
+    }
+    SyzygyPosition pos(board);
+    if (pos.pieceCount > m_maxPieces)
+    {
+        return false;
+    }
+    SyzygyTableEntry* e = m_tables.value(pos.materialKey);
+    return e && !e->wdl.fileName.isEmpty();
+}
+
+bool SyzygyTablebase::probeWdl(const BoardX& board, int& wdl) const
+{
+    if (!covers(board))
+    {
+        return false;
+    }
+    SyzygyProbeState result;
+    wdl = SyzygyProber(m_tables, m_generation).probeWdl(board, result);
+    return result != ProbeFail;
+}
+
+bool SyzygyTablebase::probeDtz(const BoardX& board, int& dtz) const
+{
+    if (!covers(board))
+    {
+        return false;
+    }
+    SyzygyProbeState result;
+    dtz = SyzygyProber(m_tables, m_generation).probeDtz(board, result);
+    return result != ProbeFail;
+}
+
+bool SyzygyTablebase::probe(const BoardX& board, QList<Move>& bestMoves, int& score) const
+{
+    bestMoves.clear();
+    score = 0;
+    if (!covers(board))
+    {
+        return false;
+    }
+
+    SyzygyProber prober(m_tables, m_generation);
+    SyzygyProbeState result = ProbeOk;
+    SyzygyChildren children = legalChildren(board);
+    if (children.isEmpty())
+    {
+        return false;
+    }
+
+    // Rank the moves by their DTZ counted from the root: quick wins first,
+    // then cursed wins, draws, blessed losses and slow losses
+    QList<int> dtzs;
+    bool haveDtz = true;
+    for (const QPair<Move, BoardX>& child : qAsConst(children))
+    {
+        int dtz;
+        if (isZeroing(child.first))
+        {
+            dtz = dtzBeforeZeroing(-prober.probeWdl(child.second, result));
+        }
+        else
+        {
+            dtz = -prober.probeDtz(child.second, result);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+        }
+        if (result == ProbeFail)
+        {
+            haveDtz = false;
+            break;
+        }
+        if (dtz == 2 && child.second.isCheckmate())
+        {
+            dtz = 1;
+        }
+        dtzs.append(dtz);
+    }
+
+    if (!haveDtz)
+    {
+        // Without DTZ tables report the result, and the moves keeping the draw
+        int wdl = prober.probeWdl(board, result);
+        if (result == ProbeFail)
+        {
+            return false;
+        }
+        if (wdl == WdlDraw)
+        {
+            for (const QPair<Move, BoardX>& child : qAsConst(children))
+            {
+                if (prober.probeWdl(child.second, result) == WdlDraw && result != ProbeFail)
+                {
+                    bestMoves.append(child.first);
+                }
+            }
+        }
+        score = signOf(wdl);
+        return true;
+    }
+
+    int bestRank = INT_MIN;
+    for (int i = 0; i < dtzs.count(); ++i)
+    {
+        int dtz = dtzs.at(i);
+        int rank = dtz > 0 ? 1000 - dtz : dtz < 0 ? -1000 - dtz : 0;
+        if (rank > bestRank)
+        {
+            bestRank = rank;
+            bestMoves.clear();
+            score = dtz;
+        }
+        if (rank == bestRank)
+        {
+            bestMoves.append(children.at(i).first);
+        }
+    }
+    return true;
+}
+
+void SyzygyTablebase::getBestMove(QString fen)
+{
+    if (m_fen == fen)
+    {
+        return;
+    }
+    m_fen = fen;
+
+    int request = m_request.fetchAndAddRelaxed(1) + 1;
+#if QT_VERSION < 0x060000
+    QFuture<void> future = QtConcurrent::run(&m_pool, this, &SyzygyTablebase::lookup, fen, request);
+#else
+    QFuture<void> future = QtConcurrent::run(&m_pool, &SyzygyTablebase::lookup, this, fen, request);
+#endif
+    Q_UNUSED(future); // Results are emitted by lookup()
+}
+
+void SyzygyTablebase::lookup(QString fen, int request)
+{
+    if (m_request.loadAcquire() != request)
+    {
+        return;
+    }
+    BoardX board;
+    if (!board.fromFen(fen))
+    {
+        return;
+    }
+    QList<Move> bestMoves;
+    int score;
+    if (probe(board, bestMoves, score) && m_request.loadAcquire() == request &&
+            s_allowEngineOutput && (bestMoves.count() || score))
+    {
+        emit bestMove(bestMoves, score);
+    }
+}
+
+void SyzygyTablebase::abortLookup()
+{
+    m_request.fetchAndAddRelaxed(1);
+    m_fen.clear();
+}
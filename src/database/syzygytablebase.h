@@ -0,0 +1,85 @@
+/****************************************************************************
+*   Syzygy tablebase probing, derived from src/syzygy/tbprobe.cpp of
+*   Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+*   Copyright (C) 2013 Ronald de Man
+*   Copyright (C) 2004-2024 The Stockfish developers (see their AUTHORS)
+*
+*   This file is free software: you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation, either version 3 of the License, or
+*   (at your option) any later version. See COPYING-GPLv3.txt.
+****************************************************************************/
+
+#ifndef SYZYGYTABLEBASE_H
+#define SYZYGYTABLEBASE_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QThreadPool>
+
+#include "tablebase.h"
+
+class BoardX;
+struct SyzygyTableEntry;
+
+/** @ingroup Feature
+ * Implement Tablebase access to local Syzygy WDL/DTZ files of up to 7 pieces.
+ *
+ * The files found in the configured directories are memory mapped on first
+ * use and probed directly, results of DTZ and WDL lookups are kept in a small
+ * per-thread cache. Probing is thread-safe, so besides the asynchronous
+ * getBestMove() slot, probe() may be called from worker threads.
+ *
+ * getBestMove() probes on a worker thread and emits bestMove() from there,
+ * so that mapping and decoding the files does not block the GUI.
+ */
+class SyzygyTablebase : public Tablebase
+{
+    Q_OBJECT
+public:
+    SyzygyTablebase();
+    ~SyzygyTablebase();
+
+    /** Use the tables found in @p path, a list of directories separated by QDir::listSeparator().
+        Waits for a running lookup, but must not be called while other threads are probing. */
+    void setPath(const QString& path);
+    /** @return the largest number of pieces of the available tables, 0 if there are none */
+    int maxPieces() const { return m_maxPieces; }
+    /** @return true if a WDL table for the material of @p board is available */
+    bool covers(const BoardX& board) const;
+
+    /** Probe @p board. On success @p bestMoves holds the moves with the best DTZ and @p score
+        the DTZ in plies from the side to move's view, as emitted by bestMove().
+        Without DTZ tables @p bestMoves is only filled for drawn positions and @p score is +-1. */
+    bool probe(const BoardX& board, QList<Move>& bestMoves, int& score) const;
+    /** Probe win/draw/loss of @p board from the side to move's view:
+        2 win, 1 cursed win, 0 draw, -1 blessed loss, -2 loss */
+    bool probeWdl(const BoardX& board, int& wdl) const;
+    /** Probe the distance to zeroing of @p board in plies, positive if the side to move wins */
+    bool probeDtz(const BoardX& board, int& dtz) const;
+
+signals:
+    void bestMove(QList<Move> bestMoves, int score);
+public slots:
+    void getBestMove(QString fen);
+    void abortLookup();
+
+private:
+    /** Probe @p fen and emit the result, unless request @p request was superseded */
+    void lookup(QString fen, int request);
+
+    /** Map of material keys to tables, each entry is stored for both colors */
+    QHash<quint64, SyzygyTableEntry*> m_tables;
+    QList<SyzygyTableEntry*> m_entries;
+    int m_maxPieces;
+    int m_generation;
+    QString m_fen;
+    /** Number of the latest lookup, earlier ones are dropped */
+    QAtomicInt m_request;
+    /** Runs the lookups one after the other */
+    QThreadPool m_pool;
+};
+
+#endif // SYZYGYTABLEBASE_H
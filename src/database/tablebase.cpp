@@ -78,7 +78,7 @@ void OnlineTablebase::sendIt()
         return;
     }
 
-    if (AppSettings->getValue("/General/tablebaseSource").toInt() || ((white + black) > 6) || black > 4 || white > 4)
+    if (AppSettings->snapshot().tablebaseSource || ((white + black) > 6) || black > 4 || white > 4)
     {
         QString requested = QString("/standard?fen=%1").arg(m_fen);
         url = requested;
@@ -0,0 +1,280 @@
+#include "tagvaluelistmodel.h"
+#include "index.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+/** Number of rows handed out to a view at once */
+const int FetchSize = 1000;
+
+TagValueListModel::TagValueListModel(QObject* parent) :
+    QAbstractListModel(parent),
+    m_revision(0),
+    m_displayFunc(nullptr),
+    m_begin(0),
+    m_end(0),
+    m_useMatches(false),
+    m_fetched(0)
+{
+}
+
+void TagValueListModel::setIndex(const IndexX* index, const QStringList& tagNames)
+{
+    beginResetModel();
+    m_index = index;
+    m_tagNames = tagNames;
+    loadValues();
+    applyFilter(QString());
+    m_fetched = std::min(FetchSize, count());
+    endResetModel();
+}
+
+void TagValueListModel::setDisplayFunc(DisplayFunc func)
+{
+    beginResetModel();
+    m_displayFunc = func;
+    // The matches depend on the displayed text
+    m_useMatches = false;
+    applyFilter(m_filter);
+    m_fetched = std::min(FetchSize, count());
+    endResetModel();
+}
+
+void TagValueListModel::setFilter(const QString& text)
+{
+    beginResetModel();
+    if (isOutdated())
+    {
+        loadValues();
+    }
+    applyFilter(text);
+    m_fetched = std::min(FetchSize, count());
+    endResetModel();
+}
+
+void TagValueListModel::update()
+{
+    if (!isOutdated())
+    {
+        return;
+    }
+    beginResetModel();
+    loadValues();
+    applyFilter(m_filter);
+    m_fetched = std::min(FetchSize, count());
+    endResetModel();
+}
+
+bool TagValueListModel::isOutdated() const
+{
+    return m_index && m_index->revision() != m_revision;
+}
+
+void TagValueListModel::loadValues()
+{
+    m_values.clear();
+    m_revision = 0;
+    if (m_index)
+    {
+        m_revision = m_index->revision();
+        m_values = m_index->sortedTagValues(m_tagNames);
+    }
+    // Positions of earlier matches are meaningless now
+    m_matches.clear();
+    m_useMatches = false;
+}
+
+void TagValueListModel::applyFilter(const QString& text)
+{
+    // Values containing a longer text are among those containing the shorter one
+    bool narrow = m_useMatches && !m_filter.isEmpty() && text.contains(m_filter, Qt::CaseInsensitive);
+    QVector<int> previous;
+    previous.swap(m_matches);
+    m_useMatches = false;
+    m_filter = text;
+
+    if (text.isEmpty())
+    {
+        m_begin = 0;
+        m_end = m_values.count();
+        return;
+    }
+    m_begin = lowerBound(text, true);
+    m_end = upperBound(text);
+    if (m_begin < m_end || !m_index)
+    {
+        return;
+    }
+
+    // Nothing starts with the text, fall back to searching it anywhere in the values
+    m_useMatches = true;
+    QVector<ValueIndex> candidates;
+    if (narrow)
+    {
+        candidates.reserve(previous.count());
+        for (int i : qAsConst(previous))
+        {
+            candidates.append(m_values[i]);
+        }
+    }
+    else
+    {
+        candidates = m_values;
+    }
+    QStringList names = m_index->valueNames(candidates);
+    for (int i = 0; i < names.count(); ++i)
+    {
+        QString s = m_displayFunc ? m_displayFunc(names[i]) : names[i];
+        if (s.contains(text, Qt::CaseInsensitive))
+        {
+            m_matches.append(narrow ? previous[i] : i);
+        }
+    }
+}
+
+int TagValueListModel::count() const
+{
+    return m_useMatches ? m_matches.count() : m_end - m_begin;
+}
+
+QString TagValueListModel::value(int row) const
+{
+    if (row < 0 || row >= count())
+    {
+        return QString();
+    }
+    return name(position(row));
+}
+
+QModelIndex TagValueListModel::indexOf(const QString& value)
+{
+    update();
+    int pos = lowerBound(value, false);
+    while (pos < m_values.count() && name(pos) != value)
+    {
+        if (name(pos).compare(value, Qt::CaseInsensitive) != 0)
+        {
+            return QModelIndex();
+        }
+        ++pos;
+    }
+    if (pos >= m_values.count())
+    {
+        return QModelIndex();
+    }
+
+    int row;
+    if (m_useMatches)
+    {
+        QVector<int>::const_iterator it = std::lower_bound(m_matches.constBegin(), m_matches.constEnd(), pos);
+        if (it == m_matches.constEnd() || *it != pos)
+        {
+            return QModelIndex();
+        }
+        row = int(it - m_matches.constBegin());
+    }
+    else
+    {
+        if (pos < m_begin || pos >= m_end)
+        {
+            return QModelIndex();
+        }
+        row = pos - m_begin;
+    }
+
+    if (row >= m_fetched)
+    {
+        beginInsertRows(QModelIndex(), m_fetched, row);
+        m_fetched = row + 1;
+        endInsertRows();
+    }
+    return index(row, 0);
+}
+
+int TagValueListModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_fetched;
+}
+
+QVariant TagValueListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_fetched || role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+    QString s = value(index.row());
+    return m_displayFunc ? m_displayFunc(s) : s;
+}
+
+bool TagValueListModel::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && m_fetched < count();
+}
+
+void TagValueListModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid())
+    {
+        return;
+    }
+    int n = std::min(FetchSize, count() - m_fetched);
+    if (n > 0)
+    {
+        beginInsertRows(QModelIndex(), m_fetched, m_fetched + n - 1);
+        m_fetched += n;
+        endInsertRows();
+    }
+}
+
+QString TagValueListModel::name(int position) const
+{
+    return m_index ? m_index->valueName(m_values[position]) : QString();
+}
+
+int TagValueListModel::lowerBound(const QString& text, bool prefix) const
+{
+    int low = 0;
+    int high = m_values.count();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        QString s = prefix ? name(mid).left(text.length()) : name(mid);
+        if (s.compare(text, Qt::CaseInsensitive) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int TagValueListModel::upperBound(const QString& text) const
+{
+    int low = 0;
+    int high = m_values.count();
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (name(mid).left(text.length()).compare(text, Qt::CaseInsensitive) <= 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int TagValueListModel::position(int row) const
+{
+    return m_useMatches ? m_matches[row] : m_begin + row;
+}
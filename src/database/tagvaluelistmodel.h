@@ -0,0 +1,90 @@
+#ifndef TAGVALUELISTMODEL_H
+#define TAGVALUELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+
+#include "indexitem.h"
+
+class IndexX;
+
+/** @ingroup Database
+ * A list model of the distinct values of some tags of an index, e.g. of all
+ * players, sorted case insensitively.
+ *
+ * The model only keeps the sorted value indexes, the names stay in the index.
+ * A filter text selects the values starting with it by binary search, only if
+ * no value starts with the text, the values containing it are searched for.
+ * When the text is extended, as while typing, that search only looks at the
+ * values found for the previous text. The values are sorted again when the
+ * revision of the index changed. Rows are handed out to views in chunks as
+ * they are scrolled into view.
+ */
+class TagValueListModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    /** Function to compute the displayed text of a value */
+    typedef QString (*DisplayFunc)(const QString& value);
+
+    explicit TagValueListModel(QObject* parent = nullptr);
+
+    /** Show the values of @p tagNames in @p index, which may be null */
+    void setIndex(const IndexX* index, const QStringList& tagNames);
+    /** Show the text returned by @p func instead of the plain values */
+    void setDisplayFunc(DisplayFunc func);
+    /** Show only the values matching @p text, all values if it is empty */
+    void setFilter(const QString& text);
+    /** Sort the values again if the index changed since they were sorted */
+    void update();
+
+    /** @return the number of values matching the filter, fetched or not */
+    int count() const;
+    /** @return the value shown in @p row */
+    QString value(int row) const;
+    /** @return the index of @p value, fetching rows up to it, invalid if it does not match the filter */
+    QModelIndex indexOf(const QString& value);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+private:
+    /** @return true if the values were sorted for an older revision of the index */
+    bool isOutdated() const;
+    /** Fetch and sort the values of the index */
+    void loadValues();
+    /** Select the values matching @p text */
+    void applyFilter(const QString& text);
+    /** @return the name of the value at @p position of m_values */
+    QString name(int position) const;
+    /** @return the first position of m_values whose name is not less than @p text, compared on its length only if @p prefix */
+    int lowerBound(const QString& text, bool prefix) const;
+    /** @return the first position of m_values whose first letters compare greater than @p text */
+    int upperBound(const QString& text) const;
+    /** @return the position in m_values of the value shown in @p row */
+    int position(int row) const;
+
+private:
+    QPointer<const IndexX> m_index;
+    QStringList m_tagNames;
+    /** Revision of the index the values were sorted for */
+    quint32 m_revision;
+    /** The values, sorted by name */
+    QVector<ValueIndex> m_values;
+    DisplayFunc m_displayFunc;
+    QString m_filter;
+    /** Values starting with the filter text are the range [m_begin, m_end) of m_values */
+    int m_begin;
+    int m_end;
+    /** Positions of the values containing the filter text, if none start with it */
+    QVector<int> m_matches;
+    bool m_useMatches;
+    /** Number of rows made known to views */
+    int m_fetched;
+};
+
+#endif // TAGVALUELISTMODEL_H
@@ -86,12 +86,12 @@ void DlgSaveBook::slotSelectTargetPath()
 {
     QString file = QFileDialog::getSaveFileName(this, tr("New book"),
                    AppSettings->value("/General/DefaultDataPath").toString(),
-                   tr("Polyglot Book (*.bin)"));
+                   tr("Polyglot Book (*.bin);;ChessBase Book (*.ctg)"));
     if(file.isEmpty())
     {
         return;
     }
-    if(!file.endsWith(".bin", Qt::CaseInsensitive))
+    if(!file.endsWith(".bin", Qt::CaseInsensitive) && !file.endsWith(".ctg", Qt::CaseInsensitive))
     {
         file += ".bin";
     }
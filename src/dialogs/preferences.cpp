@@ -73,6 +73,13 @@ PreferencesDialog::PreferencesDialog(QWidget* parent, Qt::WindowFlags f) : QDial
     connect(ui.directoryButton, SIGNAL(clicked(bool)), SLOT(slotSelectEngineDirectory()));
     connect(ui.commandButton, SIGNAL(clicked(bool)), SLOT(slotSelectEngineCommand()));
     connect(ui.browsePathButton, SIGNAL(clicked(bool)), SLOT(slotSelectDataBasePath()));
+    connect(ui.browseSyzygyButton, SIGNAL(clicked(bool)), SLOT(slotSelectSyzygyPath()));
+#ifndef USE_SYZYGY
+    // Built without the local prober
+    ui.lbSyzygyPath->hide();
+    ui.syzygyPath->hide();
+    ui.browseSyzygyButton->hide();
+#endif
     connect(ui.engineOptionMore, SIGNAL(clicked(bool)), SLOT(slotShowOptionDialog()));
 
     connect(ui.tbUK, SIGNAL(clicked()), SLOT(slotChangePieceString()));
@@ -197,6 +204,17 @@ void PreferencesDialog::slotSelectDataBasePath()
     }
 }
 
+void PreferencesDialog::slotSelectSyzygyPath()
+{
+    QString dir = QFileDialog::getExistingDirectory(this,
+                  tr("Select Syzygy tablebase folder"), ui.syzygyPath->text().section(QDir::listSeparator(), 0, 0),
+                  QFileDialog::ShowDirsOnly);
+    if(!dir.isEmpty() && QDir(dir).exists())
+    {
+        ui.syzygyPath->setText(dir);
+    }
+}
+
 void PreferencesDialog::slotAddEngine()
 {
     QString command = selectEngineFile();
@@ -463,6 +481,7 @@ void PreferencesDialog::restoreSettings()
     AppSettings->beginGroup("/General/");
     ui.tablebaseCheck->setChecked(AppSettings->getValue("onlineTablebases").toBool());
     ui.tablebaseSelect->setCurrentIndex(AppSettings->getValue("tablebaseSource").toInt());
+    ui.syzygyPath->setText(AppSettings->getValue("syzygyPath").toString());
     ui.versionCheck->setChecked(AppSettings->getValue("onlineVersionCheck").toBool());
     ui.automaticECO->setChecked(AppSettings->getValue("automaticECO").toBool());
     ui.preserveECO->setChecked(AppSettings->getValue("preserveECO").toBool());
@@ -685,6 +704,7 @@ void PreferencesDialog::saveSettings()
     AppSettings->beginGroup("/General/");
     AppSettings->setValue("onlineTablebases", QVariant(ui.tablebaseCheck->isChecked()));
     AppSettings->setValue("tablebaseSource", QVariant(ui.tablebaseSelect->currentIndex()));
+    AppSettings->setValue("syzygyPath", ui.syzygyPath->text());
     AppSettings->setValue("onlineVersionCheck", QVariant(ui.versionCheck->isChecked()));
     AppSettings->setValue("automaticECO", QVariant(ui.automaticECO->isChecked()));
     AppSettings->setValue("preserveECO", QVariant(ui.preserveECO->isChecked()));
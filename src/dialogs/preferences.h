@@ -64,6 +64,8 @@ public slots:
     void slotSelectToolPath();
     /** user wants file dialog to select directory in which DataBases will be stored */
     void slotSelectDataBasePath();
+    /** user wants file dialog to select directory with local Syzygy tablebases */
+    void slotSelectSyzygyPath();
     /** user wants option dialog to select parameters which will be sent at startup of engine */
     void slotShowOptionDialog();
     /** User pressed a flag to change the piece string */
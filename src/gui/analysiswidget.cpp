@@ -18,6 +18,9 @@
 #include "messagedialog.h"
 #include "move.h"
 #include "movedata.h"
+#ifdef USE_SYZYGY
+#include "syzygytablebase.h"
+#endif
 #include "tablebase.h"
 
 #include <QMutexLocker>
@@ -51,6 +54,11 @@ AnalysisWidget::AnalysisWidget(QWidget *parent)
 
     m_tablebase = new OnlineTablebase;
     connect(m_tablebase, SIGNAL(bestMove(QList<Move>,int)), this, SLOT(showTablebaseMove(QList<Move>,int)), Qt::QueuedConnection);
+#ifdef USE_SYZYGY
+    m_localTablebase = new SyzygyTablebase;
+    m_localTablebase->setPath(AppSettings->getValue("/General/syzygyPath").toString());
+    connect(m_localTablebase, SIGNAL(bestMove(QList<Move>,int)), this, SLOT(showTablebaseMove(QList<Move>,int)), Qt::QueuedConnection);
+#endif
 
     ui.variationText->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui.variationText,SIGNAL(customContextMenuRequested(const QPoint&)),this,SLOT(showContextMenu(const QPoint&)));
@@ -60,6 +68,9 @@ AnalysisWidget::~AnalysisWidget()
 {
     stopEngine();
     delete m_tablebase;
+#ifdef USE_SYZYGY
+    delete m_localTablebase;
+#endif
 }
 
 
@@ -251,6 +262,10 @@ void AnalysisWidget::slotReconfigure()
     f.setPointSize(fontSize);
     setFont(f);
     ui.variationText->setFont(f);
+
+#ifdef USE_SYZYGY
+    m_localTablebase->setPath(AppSettings->getValue("/General/syzygyPath").toString());
+#endif
 }
 
 void AnalysisWidget::saveConfig()
@@ -389,6 +404,9 @@ void AnalysisWidget::setPosition(const BoardX& board, QString line)
         m_line = line;
         m_analyses.clear();
         m_tablebase->abortLookup();
+#ifdef USE_SYZYGY
+        m_localTablebase->abortLookup();
+#endif
         m_tablebaseEvaluation.clear();
         m_tablebaseMove.clear();
         m_tb.setNullMove();
@@ -396,15 +414,21 @@ void AnalysisWidget::setPosition(const BoardX& board, QString line)
 
         updateBookMoves();
 
-        if(AppSettings->getValue("/General/onlineTablebases").toBool())
+        if (!(m_board.isStalemate() || m_board.isCheckmate() || m_board.chess960()) && objectName() == "Analysis")
         {
-            if (!(m_board.isStalemate() || m_board.isCheckmate() || m_board.chess960()))
+#ifdef USE_SYZYGY
+            // Local tables answer without network access, the online service covers the rest
+            if (m_localTablebase->covers(m_board))
             {
-                if(objectName() == "Analysis")
-                {
-                    m_tbBoard = m_board;
-                    m_tablebase->getBestMove(m_board.toFen());
-                }
+                m_tbBoard = m_board;
+                m_localTablebase->getBestMove(m_board.toFen());
+            }
+            else
+#endif
+            if(AppSettings->getValue("/General/onlineTablebases").toBool())
+            {
+                m_tbBoard = m_board;
+                m_tablebase->getBestMove(m_board.toFen());
             }
         }
 
@@ -21,6 +21,7 @@
 	The Analysis widget which shows engine output
 */
 
+class SyzygyTablebase;
 class Tablebase;
 class Database;
 
@@ -138,6 +139,9 @@ private:
     Move m_tb;
     int m_score_tb;
     Tablebase* m_tablebase;
+#ifdef USE_SYZYGY
+    SyzygyTablebase* m_localTablebase;
+#endif
     BoardX m_tbBoard;
     EngineParameter m_moveTime;
     bool m_bUciNewGame;
@@ -15,6 +15,7 @@
  ***************************************************************************/
 
 #include "boardview.h"
+#include "diagramrenderer.h"
 #include "GameMimeData.h"
 #include "settings.h"
 #include "guess.h"
@@ -50,6 +51,9 @@ BoardView::BoardView(QWidget* parent, int flags) : QWidget(parent),
     m_DbIndex(nullptr),
     m_showAttacks(NoColor),
     m_showUnderProtection(NoColor),
+    m_pieceLayerSkip(InvalidSquare),
+    m_attackedSquares(0),
+    m_underProtectedSquares(0),
     lastMoveEvent(nullptr)
 {
     QSizePolicy policy = sizePolicy();
@@ -115,6 +119,8 @@ void BoardView::setBoard(const BoardX& value, Square from, Square to, bool atLin
     m_alertSquare = value.kingInCheck();
     m_targets.clear();
     m_bestGuess.setNullMove();
+    m_pieceLayer = QPixmap();
+    updateOverlays();
     if(underMouse())
     {
         updateGuess(m_hoverSquare);
@@ -167,6 +173,7 @@ bool BoardView::showMoveIndicator() const
 void BoardView::showCoordinates(bool visible)
 {
     m_coordinates = visible;
+    invalidateLayers();
 }
 
 bool BoardView::showCoordinates() const
@@ -174,16 +181,10 @@ bool BoardView::showCoordinates() const
     return m_coordinates;
 }
 
-void BoardView::drawSquares(QPaintEvent* event)
+void BoardView::drawSquares(QPainter& p)
 {
-    QPainter p(this);
     for (Square square=a1; square<NumSquares; ++square)
     {
-        QRect rect = squareRect(square);
-        if(!event->region().intersects(rect))
-        {
-            continue;
-        }
         int coord =  m_coordinates ? CoordinateSize : 0;
         int x = isFlipped() ? 7 - square % 8 : square % 8;
         int y = isFlipped() ? square / 8 : 7 - square / 8;
@@ -208,29 +209,20 @@ QRect BoardView::totalRect() const
     return totalRect;
 }
 
-void BoardView::drawCoordinates(QPaintEvent* event)
+void BoardView::drawCoordinates(QPainter& p)
 {
     if(m_coordinates)
     {
-        QPainter p(this);
         p.save();
         p.setPen(m_theme.color(BoardTheme::Coord));
         for(int i = 0; i<8; ++i)
         {
             QRect rect = coordinateRectVertical(i);
-            if(!event->region().intersects(rect))
-            {
-                continue;
-            }
             p.drawText(rect, Qt::AlignCenter, QString("%1").arg(i + 1));
         }
         for(int i = 0; i<8; ++i)
         {
             QRect rect = coordinateRectHorizontal(i);
-            if(!event->region().intersects(rect))
-            {
-                continue;
-            }
             p.drawText(rect, Qt::AlignCenter, QString("%1").arg(QChar('a' + i)));
         }
         p.restore();
@@ -406,10 +398,9 @@ void BoardView::drawAttacks(QPaintEvent* event)
     {
         if (m_showAttacks != NoColor)
         {
-            QPainter p(this);
             for (Square square=a1; square<NumSquares; ++square)
             {
-                if (m_board.isAttackedBy(m_showAttacks, square))
+                if (m_attackedSquares & (Q_UINT64_C(1) << square))
                 {
                     drawColorRect(event, square, m_theme.color(BoardTheme::Wall), true);
                 }
@@ -424,42 +415,58 @@ void BoardView::drawUnderProtection(QPaintEvent* event)
     {
         if (m_showUnderProtection != NoColor)
         {
-            QPainter p(this);
             for (Square square=a1; square<NumSquares; ++square)
             {
-                if (m_board.colorAt(square) == m_showUnderProtection)
+                if (m_underProtectedSquares & (Q_UINT64_C(1) << square))
                 {
-                    if (pieceType(m_board.pieceAt(square)) != King)
-                    {
-                        QString fen = m_board.toFen();
-                        int numDefenders = Guess::attackersOnSquare(fen.toLatin1(), square);
-
-                        if ((m_showUnderProtection == White && numDefenders < 0) ||
-                            (m_showUnderProtection == Black && numDefenders > 0))
-                        {
-                            drawColorRect(event, square, m_theme.color(BoardTheme::UnderProtected), true);
-                        }
-                    }
+                    drawColorRect(event, square, m_theme.color(BoardTheme::UnderProtected), true);
                 }
             }
         }
     }
 }
 
+void BoardView::updateOverlays()
+{
+    m_attackedSquares = 0;
+    m_underProtectedSquares = 0;
+    if (m_showAttacks != NoColor)
+    {
+        for (Square square=a1; square<NumSquares; ++square)
+        {
+            if (m_board.isAttackedBy(m_showAttacks, square))
+            {
+                m_attackedSquares |= Q_UINT64_C(1) << square;
+            }
+        }
+    }
+    if (m_showUnderProtection != NoColor)
+    {
+        QByteArray fen = m_board.toFen().toLatin1();
+        for (Square square=a1; square<NumSquares; ++square)
+        {
+            if (m_board.colorAt(square) == m_showUnderProtection)
+            {
+                if (pieceType(m_board.pieceAt(square)) != King)
+                {
+                    int numDefenders = Guess::attackersOnSquare(fen, square);
 
+                    if ((m_showUnderProtection == White && numDefenders < 0) ||
+                        (m_showUnderProtection == Black && numDefenders > 0))
+                    {
+                        m_underProtectedSquares |= Q_UINT64_C(1) << square;
+                    }
+                }
+            }
+        }
+    }
+}
 
-void BoardView::drawPieces(QPaintEvent* event)
+void BoardView::drawPieces(QPainter& p)
 {
-    QPainter p(this);
     p.setRenderHint(QPainter::SmoothPixmapTransform);
     for (Square square=a1; square<NumSquares; ++square)
     {
-        QRect rect = squareRect(square);
-        if(!event->region().intersects(rect))
-        {
-            continue;
-        }
-
         QPoint pos = posFromSquare(square);
 
         if(m_showFrame)
@@ -468,13 +475,10 @@ void BoardView::drawPieces(QPaintEvent* event)
             p.drawRect(QRect(pos, m_theme.size()));
         }
 
-        if(m_dragged != Empty)
+        // Do not paint piece that is dragged
+        if (m_pieceLayerSkip == square)
         {
-            // Do not paint piece that is dragged
-            if (m_dragStartSquare == square)
-            {
-                continue;
-            }
+            continue;
         }
 
         p.drawPixmap(pos, m_theme.piece(m_board.pieceAt(square)));
@@ -488,18 +492,61 @@ void BoardView::drawPieces(QPaintEvent* event)
                               QRect(rect2.topLeft(),rect1.bottomRight()));
 }
 
+void BoardView::invalidateLayers()
+{
+    m_boardLayer = QPixmap();
+    m_pieceLayer = QPixmap();
+}
+
+void BoardView::updateLayers()
+{
+    qreal ratio = devicePixelRatioF();
+    QSize layerSize = size() * ratio;
+    if (m_boardLayer.size() != layerSize || m_boardLayer.devicePixelRatio() != ratio)
+    {
+        m_boardLayer = QPixmap(layerSize);
+        m_boardLayer.setDevicePixelRatio(ratio);
+        m_boardLayer.fill(Qt::transparent);
+        QPainter p(&m_boardLayer);
+        drawSquares(p);
+        drawCoordinates(p);
+        m_pieceLayer = QPixmap();
+    }
+
+    Square skip = (m_dragged != Empty) ? m_dragStartSquare : InvalidSquare;
+    if (m_pieceLayer.isNull() || m_pieceLayerSkip != skip)
+    {
+        m_pieceLayerSkip = skip;
+        m_pieceLayer = QPixmap(layerSize);
+        m_pieceLayer.setDevicePixelRatio(ratio);
+        m_pieceLayer.fill(Qt::transparent);
+        QPainter p(&m_pieceLayer);
+        drawPieces(p);
+    }
+}
+
 void BoardView::paintEvent(QPaintEvent* event)
 {    
     QWidget::paintEvent(event);
 
-    drawSquares(event);
-    drawCoordinates(event);
+    // Squares and pieces come from cached layers, only the overlays in
+    // between and the highlights on top are drawn for each update
+    updateLayers();
+    {
+        QPainter p(this);
+        p.setClipRegion(event->region());
+        p.drawPixmap(0, 0, m_boardLayer);
+    }
     drawAttacks(event);
     drawSquareAnnotations(event);
     drawTargets(event);
     drawCheck(event);
     drawUnderProtection(event);
-    drawPieces(event);
+    {
+        QPainter p(this);
+        p.setClipRegion(event->region());
+        p.drawPixmap(0, 0, m_pieceLayer);
+    }
     drawHiliting(event);
     drawMoveIndicator(event);
     drawArrowAnnotations(event);
@@ -521,6 +568,7 @@ void BoardView::resizeBoard(QSize sz)
 
     QSize widgetSize(size * 8 + 1 + coord + square, size * 8 + 1 + coord);
     QPoint widgetCenter(widgetSize.width() / 2, widgetSize.height() / 2);
+    invalidateLayers();
 }
 
 void BoardView::resizeEvent(QResizeEvent* e)
@@ -951,12 +999,14 @@ void BoardView::setVariations(const QList<Move> &variations)
 void BoardView::setShowUnderProtection(const Color &showUnderProtection)
 {
     m_showUnderProtection = showUnderProtection;
+    updateOverlays();
     update();
 }
 
 void BoardView::setShowAttacks(const Color &showAttacks)
 {
     m_showAttacks = showAttacks;
+    updateOverlays();
     update();
 }
 
@@ -1129,6 +1179,7 @@ void BoardView::setFlipped(bool flipped)
 {
     bool wasFlipped = m_flipped;
     m_flipped = flipped;
+    invalidateLayers();
     repaint(); // Workaround Bug in Qt at least up to version 5.12
     emit signalFlipped(wasFlipped, m_flipped);
 }
@@ -1162,6 +1213,7 @@ void BoardView::configure(bool allowErrorMessage)
     AppSettings->endGroup();
     m_theme.configure(allowErrorMessage);
     m_theme.setEnabled(isEnabled());
+    invalidateLayers();
     removeGuess();
     unselectSquare();
     if(size().height() >= minimumSize().height())
@@ -1627,16 +1679,5 @@ void BoardView::renderImage(QImage &image, double scaling) const
 
 QString BoardView::renderImageForBoard(const BoardX &b, QSize size)
 {
-    QImage image;
-    BoardView boardView(nullptr, BoardView::IgnoreSideToMove | BoardView::SuppressGuessMove);
-    boardView.setBoard(b);
-    boardView.setMinimumSize(size);
-    boardView.resize(size);
-    boardView.setEnabled(false);
-    boardView.renderImage(image, 1.0);
-
-    QByteArray byteArray;
-    QBuffer buffer(&byteArray);
-    image.save(&buffer, "PNG"); // writes the image in PNG format inside the buffer
-    return QString::fromLatin1(byteArray.toBase64().data());
+    return DiagramRenderer::renderImageForBoard(b, size);
 }
@@ -22,6 +22,7 @@
 #include "guess.h"
 #include "threadedguess.h"
 
+#include <QPixmap>
 #include <QWidget>
 #include <QPointer>
 
@@ -212,16 +213,22 @@ private:
     void drawColorRect(QPaintEvent* event, Square square, QColor color, bool plain = false);
 
     void drawHiliting(QPaintEvent* event);
-    void drawSquares(QPaintEvent* event);
+    void drawSquares(QPainter& p);
     void drawTargets(QPaintEvent* event);
-    void drawPieces(QPaintEvent* event);
+    void drawPieces(QPainter& p);
     void drawCheck(QPaintEvent* event);
     void drawAttacks(QPaintEvent *event);
     void drawUnderProtection(QPaintEvent *event);
     void drawMoveIndicator(QPaintEvent* event);
     void drawDraggedPieces(QPaintEvent* event);
-    void drawCoordinates(QPaintEvent* event);
-
+    void drawCoordinates(QPainter& p);
+
+    /** Discard the cached board and piece layers, e.g. when the size or theme changed */
+    void invalidateLayers();
+    /** Render the board and piece layers again if they are outdated */
+    void updateLayers();
+    /** Determine the squares of the attack and under protection overlays for the current position */
+    void updateOverlays();
     void drawSquareAnnotations(QPaintEvent* event);
     void drawSquareAnnotation(QPaintEvent* event, QString annotation);
     void drawArrowAnnotations(QPaintEvent* event);
@@ -268,6 +275,15 @@ private:
     QList<Move> m_variations;
     Color m_showAttacks;
     Color m_showUnderProtection;
+    /** Squares and coordinates, depending on size and theme only */
+    QPixmap m_boardLayer;
+    /** Pieces and frame of the current position */
+    QPixmap m_pieceLayer;
+    /** Square left out of m_pieceLayer because its piece is being dragged */
+    Square m_pieceLayerSkip;
+    /** Bit masks of the squares to be colored by the overlays */
+    quint64 m_attackedSquares;
+    quint64 m_underProtectedSquares;
     QMouseEvent* lastMoveEvent;
 };
 
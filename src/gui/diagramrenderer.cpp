@@ -0,0 +1,168 @@
+#include "diagramrenderer.h"
+#include "board.h"
+#include "boardtheme.h"
+#include "settings.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QMutexLocker>
+#include <QPainter>
+
+#include <algorithm>
+
+using namespace chessx;
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
+#define new DEBUG_NEW
+#endif // _MSC_VER
+
+/** Width of the coordinates, as in BoardView */
+const int CoordinateSize = 16;
+/** Number of base64 characters of encoded diagrams kept in the cache */
+const int CacheSize = 16 * 1024 * 1024;
+
+DiagramRenderer::DiagramRenderer() :
+    m_themeGeneration(0),
+    m_showFrame(false),
+    m_coordinates(false),
+    m_cache(CacheSize)
+{
+}
+
+DiagramRenderer& DiagramRenderer::instance()
+{
+    static DiagramRenderer renderer;
+    return renderer;
+}
+
+void DiagramRenderer::configure()
+{
+    BoardTheme theme;
+    theme.configure();
+
+    QVector<QImage> pieces(ConstPieceTypes);
+    for (Piece p = WhiteKing; p < ConstPieceTypes; ++p)
+    {
+        pieces[p] = theme.originalPiece(p).toImage();
+        pieces[p].setDevicePixelRatio(1.0);
+    }
+
+    AppSettings->beginGroup("/Board/");
+    bool showFrame = AppSettings->getValue("showFrame").toBool();
+    bool coordinates = AppSettings->getValue("showCoordinates").toBool();
+    AppSettings->endGroup();
+
+    QMutexLocker lock(&m_mutex);
+    ++m_themeGeneration;
+    m_originalPieces = pieces;
+    m_scaledPieces.clear();
+    m_frameColor = theme.color(BoardTheme::Frame);
+    m_coordColor = theme.color(BoardTheme::Coord);
+    m_showFrame = showFrame;
+    m_coordinates = coordinates;
+    m_cache.clear();
+}
+
+const QVector<QImage>& DiagramRenderer::scaledPieces(int squareSize)
+{
+    QHash<int, QVector<QImage> >::const_iterator it = m_scaledPieces.constFind(squareSize);
+    if (it != m_scaledPieces.constEnd())
+    {
+        return *it;
+    }
+    QVector<QImage> pieces(ConstPieceTypes);
+    for (int p = 0; p < m_originalPieces.count(); ++p)
+    {
+        if (!m_originalPieces[p].isNull())
+        {
+            pieces[p] = m_originalPieces[p].scaled(squareSize, squareSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    return *m_scaledPieces.insert(squareSize, pieces);
+}
+
+QImage DiagramRenderer::image(const BoardX& board, QSize size)
+{
+    QMutexLocker lock(&m_mutex);
+    // Copies are cheap, the images are implicitly shared
+    QVector<QImage> pieces;
+    int coord = m_coordinates ? CoordinateSize : 0;
+    int square = std::min(size.width() - 1 - coord, size.height() - 1 - coord) / 8;
+    if (square > 0)
+    {
+        pieces = scaledPieces(square);
+    }
+    QColor frameColor = m_frameColor;
+    QColor coordColor = m_coordColor;
+    bool showFrame = m_showFrame;
+    lock.unlock();
+
+    if (square <= 0)
+    {
+        return QImage();
+    }
+
+    QImage image(coord + 8 * square + 1, 8 * square + 1 + coord, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    p.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (Square s = a1; s < NumSquares; ++s)
+    {
+        int x = s % 8;
+        int y = 7 - s / 8;
+        QRect rect(coord + x * square, y * square, square, square);
+        // Diagrams use the colors of a disabled board, which print well
+        p.fillRect(rect, (x + y) % 2 ? Qt::darkGray : Qt::lightGray);
+        if (showFrame)
+        {
+            p.setPen(frameColor);
+            p.drawRect(rect);
+        }
+        Piece piece = board.pieceAt(s);
+        if (piece != Empty && piece < ConstPieceTypes && !pieces[piece].isNull())
+        {
+            p.drawImage(rect.topLeft(), pieces[piece]);
+        }
+    }
+    p.setPen(frameColor);
+    p.drawRect(QRect(coord, 0, 8 * square, 8 * square));
+
+    if (coord)
+    {
+        p.setPen(coordColor);
+        for (int i = 0; i < 8; ++i)
+        {
+            p.drawText(QRect(0, (7 - i) * square + (square - CoordinateSize) / 2, CoordinateSize, CoordinateSize),
+                       Qt::AlignCenter, QString::number(i + 1));
+            p.drawText(QRect(CoordinateSize + i * square + (square - CoordinateSize) / 2, 8 * square, CoordinateSize, CoordinateSize),
+                       Qt::AlignCenter, QString(QChar('a' + i)));
+        }
+    }
+    return image;
+}
+
+QString DiagramRenderer::encodedImage(const BoardX& board, QSize size)
+{
+    QMutexLocker lock(&m_mutex);
+    QString key = QString("%1:%2x%3:%4").arg(board.getHashValue()).arg(size.width()).arg(size.height()).arg(m_themeGeneration);
+    if (QString* cached = m_cache.object(key))
+    {
+        return *cached;
+    }
+    lock.unlock();
+
+    QByteArray byteArray;
+    QBuffer buffer(&byteArray);
+    image(board, size).save(&buffer, "PNG");
+    QString encoded = QString::fromLatin1(byteArray.toBase64().data());
+
+    lock.relock();
+    m_cache.insert(key, new QString(encoded), encoded.size());
+    return encoded;
+}
+
+QString DiagramRenderer::renderImageForBoard(const BoardX& board, QSize size)
+{
+    return instance().encodedImage(board, size);
+}
@@ -0,0 +1,62 @@
+#ifndef DIAGRAMRENDERER_H
+#define DIAGRAMRENDERER_H
+
+#include <QCache>
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include "piece.h"
+
+class BoardX;
+
+/** @ingroup GUI
+ * Renders diagrams for the notation and for exported games without a widget.
+ *
+ * configure() copies the pieces of the current board theme in the GUI thread.
+ * Afterwards diagrams are painted into a QImage from pieces prescaled once per
+ * square size, which is possible in any thread. Encoded diagrams are kept in
+ * a cache keyed by position, size and theme, so that a diagram appearing
+ * again, e.g. after the notation is reloaded, is not drawn twice.
+ */
+class DiagramRenderer
+{
+public:
+    static DiagramRenderer& instance();
+
+    /** Take over the current board theme and settings, must be called in the GUI thread */
+    void configure();
+
+    /** @return a diagram of @p board fitting into @p size */
+    QImage image(const BoardX& board, QSize size);
+    /** @return a diagram of @p board fitting into @p size, encoded as base64 PNG */
+    QString encodedImage(const BoardX& board, QSize size);
+
+    /** Suits Output as BoardRenderingFunc */
+    static QString renderImageForBoard(const BoardX& board, QSize size);
+
+private:
+    DiagramRenderer();
+    Q_DISABLE_COPY(DiagramRenderer)
+
+    /** @return the pieces scaled to @p squareSize, the caller holds m_mutex */
+    const QVector<QImage>& scaledPieces(int squareSize);
+
+private:
+    QMutex m_mutex;
+    /** Incremented by configure(), part of the cache key */
+    int m_themeGeneration;
+    QVector<QImage> m_originalPieces;
+    QHash<int, QVector<QImage> > m_scaledPieces;
+    QColor m_frameColor;
+    QColor m_coordColor;
+    bool m_showFrame;
+    bool m_coordinates;
+    QCache<QString, QString> m_cache;
+};
+
+#endif // DIAGRAMRENDERER_H
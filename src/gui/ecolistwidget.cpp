@@ -8,20 +8,27 @@
 #include "database.h"
 #include "databaseinfo.h"
 #include "tags.h"
-#include <QRegularExpression>
+#include "tagvaluelistmodel.h"
 
 #if defined(_MSC_VER) && defined(_DEBUG)
 #define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
 #define new DEBUG_NEW
 #endif // _MSC_VER
 
+/** @return @p eco followed by the name of the opening, as shown in the list */
+static QString ecoWithName(const QString& eco)
+{
+    return eco + " " + EcoPositions::findEcoNameDetailed(eco);
+}
+
 ECOListWidget::ECOListWidget(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::TagDetailWidget)
 {
     setObjectName("ECOListWidget");
     ui->setupUi(this);
-    m_filterModel = new QStringListModel(ui->tagList);
+    m_filterModel = new TagValueListModel(ui->tagList);
+    m_filterModel->setDisplayFunc(&ecoWithName);
     ui->tagList->setModel(m_filterModel);
     ui->renameItem->setVisible(false);
 
@@ -70,26 +77,16 @@ void ECOListWidget::selectionChangedSlot()
 
 void ECOListWidget::findECO(const QString& s)
 {
-    if(s.isEmpty())
+    m_filterModel->setFilter(s);
+    if(!s.isEmpty() && m_filterModel->count()==1)
     {
-        m_filterModel->setStringList(m_list);
-    }
-    else
-    {
-        QRegularExpression rx(s);
-        rx.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
-        QStringList newList = m_list.filter(rx);
-        m_filterModel->setStringList(newList);
-        if (newList.count()==1)
-        {
-            selectECO(newList.at(0));
-        }
+        selectECO(m_filterModel->value(0));
     }
 }
 
 void ECOListWidget::slotSelectECO(const QString& eco)
 {
-    m_filterModel->setStringList(m_list);
+    m_filterModel->setFilter(QString());
     ui->filterEdit->clear();
     selectECO(eco);
 }
@@ -131,16 +128,11 @@ void ECOListWidget::selectECO(const QString& eco)
     ecoSelected(eco);
     if(!eco.isEmpty())
     {
-        const QStringList& list = m_filterModel->stringList();
-        int row = list.indexOf(eco);
-        if(row >= 0)
+        QModelIndex index = m_filterModel->indexOf(eco);
+        if(index.isValid())
         {
-            QModelIndex index = m_filterModel->index(row, 0);
-            if(index.isValid())
-            {
-                ui->tagList->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
-                ui->tagList->scrollTo(index);
-            }
+            ui->tagList->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
+            ui->tagList->scrollTo(index);
         }
     }
 }
@@ -171,22 +163,8 @@ void ECOListWidget::setDatabase(DatabaseInfo* dbInfo)
     Database* db = dbInfo->database();
     ui->detailText->setText(tr("<html><i>No ECO code chosen.</i></html>"));
     m_eco.setDatabase(db);
-    m_list.clear();
-    if(db && db->index())
-    {
-        m_list = db->index()->tagValues(TagNameECO);
-    }
-    m_list.sort();
-    QStringList::Iterator iter = m_list.begin();
-    while (iter != m_list.end())
-    {
-        QString eco = *iter;
-        *iter = eco + " " + EcoPositions::findEcoNameDetailed(eco);
-        ++iter;
-    }
-
+    m_filterModel->setIndex(db ? db->index() : nullptr, QStringList() << TagNameECO);
     findECO(ui->filterEdit->text());
-    m_filterModel->sort(0);
 }
 
 void ECOListWidget::slotLinkClicked(const QUrl& url)
@@ -6,7 +6,6 @@
 #define ECOLISTWIDGET_H
 
 #include <QWidget>
-#include <QStringListModel>
 #include "ecoinfo.h"
 
 namespace Ui
@@ -15,6 +14,7 @@ class TagDetailWidget;
 }
 
 class DatabaseInfo;
+class TagValueListModel;
 
 class ECOListWidget : public QWidget
 {
@@ -45,9 +45,8 @@ protected slots:
 
 private:
     EcoInfo m_eco;
-    QStringList m_list;
     Ui::TagDetailWidget *ui;
-    QStringListModel* m_filterModel;
+    TagValueListModel* m_filterModel;
 };
 
 #endif // ECOLISTWIDGET_H
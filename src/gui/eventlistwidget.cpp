@@ -7,6 +7,7 @@
 #include "database.h"
 #include "databaseinfo.h"
 #include "tags.h"
+#include "tagvaluelistmodel.h"
 
 #if defined(_MSC_VER) && defined(_DEBUG)
 #define DEBUG_NEW new( _NORMAL_BLOCK, __FILE__, __LINE__ )
@@ -19,7 +20,7 @@ EventListWidget::EventListWidget(QWidget *parent) :
 {
     setObjectName("EventListWidget");
     ui->setupUi(this);
-    m_filterModel = new QStringListModel(ui->tagList);
+    m_filterModel = new TagValueListModel(ui->tagList);
     ui->tagList->setModel(m_filterModel);
 
     setObjectName("EventListWidget");
@@ -66,18 +67,10 @@ void EventListWidget::selectionChangedSlot()
 
 void EventListWidget::findEvent(const QString& s)
 {
-    if(s.isEmpty())
+    m_filterModel->setFilter(s);
+    if(!s.isEmpty() && m_filterModel->count()==1)
     {
-        m_filterModel->setStringList(m_list);
-    }
-    else
-    {
-        QStringList newList = m_list.filter(s, Qt::CaseInsensitive);
-        m_filterModel->setStringList(newList);
-        if (newList.count()==1)
-        {
-            selectEvent(newList.at(0));
-        }
+        selectEvent(m_filterModel->value(0));
     }
 }
 
@@ -112,7 +105,7 @@ void EventListWidget::eventSelected(const QString& event)
 
 void EventListWidget::slotSelectEvent(const QString& event)
 {
-    m_filterModel->setStringList(m_list);
+    m_filterModel->setFilter(QString());
     ui->filterEdit->clear();
     selectEvent(event);
 }
@@ -122,16 +115,11 @@ void EventListWidget::selectEvent(const QString& event)
     eventSelected(event);
     if(!event.isEmpty())
     {
-        const QStringList& list = m_filterModel->stringList();
-        int row = list.indexOf(event);
-        if(row >= 0)
+        QModelIndex index = m_filterModel->indexOf(event);
+        if(index.isValid())
         {
-            QModelIndex index = m_filterModel->index(row, 0);
-            if(index.isValid())
-            {
-                ui->tagList->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
-                ui->tagList->scrollTo(index);
-            }
+            ui->tagList->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
+            ui->tagList->scrollTo(index);
         }
     }
 }
@@ -172,14 +160,8 @@ void EventListWidget::setDatabase(DatabaseInfo* dbInfo)
     Database* db = dbInfo->database();
     ui->detailText->setText(tr("<html><i>No event chosen.</i></html>"));
     m_event.setDatabase(db);
-    m_list.clear();
-    if(db && db->index())
-    {
-        m_list = db->index()->tagValues(TagNameEvent);
-    }
-    m_list.sort();
+    m_filterModel->setIndex(db ? db->index() : nullptr, QStringList() << TagNameEvent);
     findEvent(ui->filterEdit->text().simplified());
-    m_filterModel->sort(0);
 }
 
 void EventListWidget::slotLinkClicked(const QUrl& url)
@@ -6,11 +6,11 @@
 #define EVENTLISTWIDGET_H
 
 #include <QWidget>
-#include <QStringListModel>
 
 #include "eventinfo.h"
 
 class DatabaseInfo;
+class TagValueListModel;
 
 namespace Ui
 {
@@ -47,9 +47,8 @@ protected slots:
 
 private:
     EventInfo m_event;
-    QStringList m_list;
     Ui::TagDetailWidget *ui;
-    QStringListModel* m_filterModel;
+    TagValueListModel* m_filterModel;
 };
 
 
@@ -597,6 +597,14 @@ void GameList::updateFilter(GameId index, int value)
     }
 }
 
+void GameList::updateFilter(const QList<int>& games, const QList<int>& values)
+{
+    if (m_model->filter()->database()) // ?
+    {
+        m_model->set(games, values);
+    }
+}
+
 QList<GameId> GameList::selectedGames(bool skipDeletedGames)
 {
     QList<GameId> gameIndexList;
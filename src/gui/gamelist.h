@@ -68,6 +68,8 @@ public slots:
     void setFilter(FilterX* filter);
     /** Update filter (called after changing filter outside) */
     void updateFilter(GameId index, int value);
+    /** Update filter for many games at once (called after changing filter outside) */
+    void updateFilter(const QList<int>& games, const QList<int>& values);
     /** Perform simple search */
     void simpleSearch(int tag);
     void executeSearch(Search* search, FilterOperator searchOperator=FilterOperator::NullOperator);
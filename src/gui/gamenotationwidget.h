@@ -47,7 +47,10 @@ private:
     void configureFont();
 
     ChessBrowser *m_browser;
+    /** Output for the notation, reusing the text of unchanged variations */
     Output* m_output;
+    /** Text of the displayed game */
+    QString m_text;
 };
 
 #endif
@@ -15,6 +15,7 @@
 #include "chessxsettings.h"
 #include "clipboarddatabase.h"
 #include "commentdialog.h"
+#include "compressedfile.h"
 #include "databaseinfo.h"
 #include "databaselist.h"
 #include "databaselistmodel.h"
@@ -364,7 +365,7 @@ MainWindow::MainWindow() : QMainWindow(),
     connect(openingDock, SIGNAL(visibilityChanged(bool)), m_openingTreeWidget, SLOT(cancel()));
     connect(m_openingTreeWidget, SIGNAL(signalTreeUpdated(bool)), this, SLOT(slotTreeUpdate(bool)));
     connect(m_openingTreeWidget, SIGNAL(signalSourceChanged()), this, SLOT(slotSearchTree()));
-    connect(m_openingTreeWidget, SIGNAL(requestGameFilterUpdate(int,int)), this, SLOT(slotGameFilterUpdate(int,int)));
+    connect(m_openingTreeWidget, SIGNAL(requestGameFilterUpdate(QList<int>,QList<int>)), this, SLOT(slotGameFilterUpdate(QList<int>,QList<int>)));
 
     connect(this, SIGNAL(reconfigure()), m_openingTreeWidget, SLOT(slotReconfigure()));
     openingDock->toggleViewAction()->setShortcut(Qt::CTRL | Qt::Key_T);
@@ -1021,6 +1022,11 @@ void MainWindow::openDatabaseUrl(QString fname, bool utf8)
             connect(downloadManager, SIGNAL(onDownloadFinished(QUrl,QString)), this, SLOT(loadReady(QUrl,QString)), static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::UniqueConnection));
             downloadManager->doDownload(url);
         }
+        else if (CompressedFile::isArchiveMember(fname))
+        {
+            // The member name would be taken for a fragment of the url
+            openDatabaseArchive(fname, utf8);
+        }
         else
         {
             openDatabaseArchive(url.toLocalFile(), utf8);
@@ -1230,6 +1236,13 @@ void MainWindow::openDatabaseArchive(QString fname, bool utf8)
                 QuaZipFile file(&zip);
                 for(bool more = zip.goToFirstFile(); more; more = zip.goToNextFile())
                 {
+                    QString member = zip.getCurrentFileName();
+                    if (member.endsWith(".pgn", Qt::CaseInsensitive))
+                    {
+                        // PGN is parsed straight out of the archive
+                        openDatabaseFile(CompressedFile::memberName(fname, member), utf8);
+                        continue;
+                    }
                     file.open(QIODevice::ReadOnly);
                     QString outName = dir + QDir::separator() + file.getActualFileName();
                     QDir pathOut;
@@ -1312,7 +1325,10 @@ void MainWindow::openDatabaseFile(QString fname, bool utf8)
         f.close();
     }
 
-    fname = fi.canonicalFilePath();
+    if (!CompressedFile::isArchiveMember(fname))
+    {
+        fname = fi.canonicalFilePath();
+    }
     if (fname.isEmpty())
     {
         slotStatusMessage("File not found.");
@@ -2010,6 +2026,7 @@ void MainWindow::setupActions()
     refactorMenu2->addAction(createAction(refactorMenu2, tr("Remove Time"), SLOT(slotDatabaseRemoveTime())));
     refactorMenu2->addAction(createAction(refactorMenu2, tr("Remove Variations"), SLOT(slotDatabaseRemoveVariations())));
     refactorMenu2->addAction(createAction(refactorMenu2, tr("Prune null moves"), SLOT(slotDatabaseRemoveNullLines())));
+    refactorMenu2->addAction(createAction(refactorMenu2, tr("Classify ECO"), SLOT(slotDatabaseClassifyEco())));
     refactorMenu2->addAction(createAction(refactorMenu2, tr("Edit tag"), SLOT(slotDatabaseEditTag())));
     menuDatabase->addSeparator();
     menuDatabase->addAction(createAction(tr("Clear clipboard"), SLOT(slotDatabaseClearClipboard())));
@@ -2124,6 +2141,7 @@ bool MainWindow::confirmQuit()
 
     SwitchToClipboard();
     cancelPolyglotWriters();
+    cancelEcoClassifiers();
     m_openingTreeWidget->cancel(); // Make sure we are not grabbing into something that is closed now
 
     for (int i = dbs.size() - 1; i; --i)
@@ -66,6 +66,8 @@ class SaveDialog;
 class ToolMainWindow;
 class TranslatingSlider;
 class PolyglotWriter;
+class CtgBookWriter;
+class EcoClassifier;
 
 /**
 @defgroup GUI GUI - User interface components
@@ -274,6 +276,12 @@ protected:
     void slotGameRemoveVariations();
     /** Remove all variations from all games. */
     void slotDatabaseRemoveVariations();
+    /** Recompute the ECO tags of all games in the filter */
+    void slotDatabaseClassifyEco();
+    /** ECO classification of a database was finished */
+    void slotEcoClassificationDone(Database* db, EcoClassifier* classifier);
+    /** ECO classification of a database was canceled */
+    void slotEcoClassificationCanceled(Database* db, EcoClassifier* classifier);
     /** Remove all lines consisting only of a null move */
     void slotGameRemoveNullLines();
     /** Set a annotation into the current game (w/o Undo) */
@@ -341,7 +349,7 @@ protected:
     /** Make an Update of the game list after the opening tree was updated */
     void slotTreeUpdate(bool dbIsFilterSource);
     /** Update the game list upon request from Opening Tree */
-    void slotGameFilterUpdate(int index, int value);
+    void slotGameFilterUpdate(QList<int> games, QList<int> values);
     /** Show opening tree */
     void slotSearchTree();
     /** Move @p index was selected in Opening Tree. */
@@ -414,6 +422,10 @@ protected:
     void slotBookDone(QString path, PolyglotWriter* writer);
     /** Show a path in finder */
     void slotBookBuildError(QString path, PolyglotWriter *writer);
+    /** A ctg book was finished with success */
+    void slotCtgBookDone(QString path, CtgBookWriter* writer);
+    /** A ctg book could not be built */
+    void slotCtgBookBuildError(QString path, CtgBookWriter* writer);
     /** Merge the clipboard into the current game */
     void slotEditMergePGN();
     /** Create a QImage from the current Board position */
@@ -511,6 +523,7 @@ protected slots:
     void slotShowUnderprotectedWhite();
     void slotShowUnderprotectedBlack();
     void cancelPolyglotWriters();
+    void cancelEcoClassifiers();
     void slotReadAhead();
 #ifdef USE_SPEECH
     void speechStateChanged(QTextToSpeech::State state);
@@ -769,6 +782,8 @@ private:
     EngineParameter m_matchParameter;
     bool m_bEvalRequested;
     QList<PolyglotWriter*> m_polyglotWriters;
+    QList<CtgBookWriter*> m_ctgWriters;
+    QList<EcoClassifier*> m_ecoClassifiers;
     QMap<QUrl, QString> m_mapDatabaseToDroppedUrl;
     bool m_lastMessageWasHint;
 #ifdef USE_SPEECH
@@ -23,9 +23,11 @@
 #include "databaselist.h"
 #include "databaselistmodel.h"
 #include "databasetagdialog.h"
+#include "diagramrenderer.h"
 #include "dlgsavebook.h"
 #include "downloadmanager.h"
 #include "duplicatesearch.h"
+#include "ecoclassifier.h"
 #include "ecolistwidget.h"
 #include "editaction.h"
 #include "eventlistwidget.h"
@@ -50,6 +52,7 @@
 #include "pgndatabase.h"
 #include "playerlistwidget.h"
 #include "polyglotwriter.h"
+#include "ctgbookwriter.h"
 #include "positionsearch.h"
 #include "preferences.h"
 #include "promotiondialog.h"
@@ -119,6 +122,7 @@ void MainWindow::slotFileOpen()
 {
     QStringList filters;
     filters << tr("PGN databases (*.pgn)")
+           << tr("Compressed PGN databases (*.zip *.pgn.gz)")
 #ifdef USE_SCID
            << tr("Scid databases (*.si4)")
 #endif
@@ -344,6 +348,8 @@ void MainWindow::slotConfigure(QString anchor)
 
 void MainWindow::slotReconfigure()
 {
+    AppSettings->updateSnapshot();
+    DiagramRenderer::instance().configure();
     PreferencesDialog::setupIconInMenus(this);
 
     if(AppSettings->getValue("/MainWindow/VerticalTabs").toBool())
@@ -1423,9 +1429,9 @@ void MainWindow::displayVariations()
     m_boardView->setVariations(arrowMoves);
 }
 
-void MainWindow::slotGameFilterUpdate(int index, int value)
+void MainWindow::slotGameFilterUpdate(QList<int> games, QList<int> values)
 {
-    m_gameList->updateFilter(index,value);
+    m_gameList->updateFilter(games, values);
 }
 
 void MainWindow::slotSearchTree()
@@ -2174,6 +2180,57 @@ void MainWindow::slotDatabaseRemoveVariations()
     }
 }
 
+void MainWindow::slotDatabaseClassifyEco()
+{
+    if (m_ecoClassifiers.count())
+    {
+        return;
+    }
+    if (MessageDialog::yesNo(tr("Recompute the ECO code of all games in the filter?"), databaseInfo()->database()->name()))
+    {
+        SimpleSaveGame();
+        EcoClassifier* classifier = new EcoClassifier(this);
+        connect(classifier, SIGNAL(classificationFinished(Database*,EcoClassifier*)), SLOT(slotEcoClassificationDone(Database*,EcoClassifier*)), Qt::QueuedConnection);
+        connect(classifier, SIGNAL(classificationCanceled(Database*,EcoClassifier*)), SLOT(slotEcoClassificationCanceled(Database*,EcoClassifier*)), Qt::QueuedConnection);
+        connect(classifier, SIGNAL(progress(int)), SLOT(slotOperationProgress(int)), Qt::QueuedConnection);
+        startOperation(tr("Classifying ECO codes..."));
+        m_ecoClassifiers.append(classifier);
+        classifier->classifyDatabase(database(), databaseInfo()->filter());
+    }
+}
+
+void MainWindow::cancelEcoClassifiers()
+{
+    foreach (EcoClassifier* classifier, m_ecoClassifiers)
+    {
+        classifier->cancel();
+        classifier->wait();
+    }
+}
+
+void MainWindow::slotEcoClassificationDone(Database* db, EcoClassifier* classifier)
+{
+    int changed = classifier->changedCount();
+    m_ecoClassifiers.removeOne(classifier);
+    finishOperation(tr("%n ECO code(s) changed", "", changed));
+    if (changed && db && db == database())
+    {
+        if (databaseInfo()->currentIndex() < database()->count())
+        {
+            database()->loadGameHeader(databaseInfo()->currentIndex(), game(), TagNameECO);
+        }
+        m_ecoList->setDatabase(databaseInfo());
+        emit signalGameModified(false);
+        UpdateBoardInformation();
+    }
+}
+
+void MainWindow::slotEcoClassificationCanceled(Database* /*db*/, EcoClassifier* classifier)
+{
+    m_ecoClassifiers.removeOne(classifier);
+    finishOperation(tr("ECO classification canceled"));
+}
+
 void MainWindow::slotDatabaseEditTag()
 {
     QStringList list = database()->index()->tagNames();
@@ -4194,6 +4251,17 @@ void MainWindow::slotMakeBook(QString pathIn)
                 int maxPly, minGame, result, filterResult;
                 bool uniform;
                 dlg.getBookParameters(out, maxPly, minGame, uniform, result, filterResult);
+                if (out.endsWith(".ctg", Qt::CaseInsensitive))
+                {
+                    CtgBookWriter* ctgWriter = new CtgBookWriter(this);
+                    connect(ctgWriter, SIGNAL(bookBuildError(QString,CtgBookWriter*)), SLOT(slotCtgBookBuildError(QString,CtgBookWriter*)), Qt::QueuedConnection);
+                    connect(ctgWriter, SIGNAL(bookBuildFinished(QString,CtgBookWriter*)), SLOT(slotCtgBookDone(QString,CtgBookWriter*)), Qt::QueuedConnection);
+                    connect(ctgWriter, SIGNAL(progress(int)), SLOT(slotOperationProgress(int)), Qt::QueuedConnection);
+                    startOperation(tr("Build book"));
+                    m_ctgWriters.append(ctgWriter);
+                    ctgWriter->writeBookForDatabase(dbi->database(), out, maxPly, minGame, uniform);
+                    return;
+                }
                 PolyglotWriter* polyglotWriter = new PolyglotWriter(this);
                 connect(polyglotWriter, SIGNAL(bookBuildError(QString,PolyglotWriter*)), SLOT(slotBookBuildError(QString,PolyglotWriter*)));
                 connect(polyglotWriter, SIGNAL(bookBuildFinished(QString,PolyglotWriter*)), SLOT(slotBookDone(QString,PolyglotWriter*)), Qt::QueuedConnection);
@@ -4213,6 +4281,10 @@ void MainWindow::cancelPolyglotWriters()
     {
         writer->cancel();
     }
+    foreach (CtgBookWriter* writer, m_ctgWriters)
+    {
+        writer->cancel();
+    }
 }
 
 void MainWindow::slotBookDone(QString path, PolyglotWriter* writer)
@@ -4240,6 +4312,26 @@ void MainWindow::slotBookBuildError(QString /*path*/, PolyglotWriter* writer)
     }
 }
 
+void MainWindow::slotCtgBookDone(QString path, CtgBookWriter* writer)
+{
+    finishOperation(tr("Book built"));
+    slotShowInFinder(path);
+    if (!m_ctgWriters.removeOne(writer))
+    {
+        qDebug() << "Missing writer";
+    }
+}
+
+void MainWindow::slotCtgBookBuildError(QString /*path*/, CtgBookWriter* writer)
+{
+    MessageDialog::warning(tr("Could not build book"), tr("CTG Error"));
+    finishOperation(tr("Book build finished with Error"));
+    if (!m_ctgWriters.removeOne(writer))
+    {
+        qDebug() << "Missing writer";
+    }
+}
+
 void MainWindow::slotToggleGameMode()
 {
     if (m_match->isChecked() != gameMode())
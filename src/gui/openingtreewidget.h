@@ -62,7 +62,7 @@ protected slots:
 signals:
     void signalTreeUpdated(bool);
     void signalSourceChanged();
-    void requestGameFilterUpdate(int,int);
+    void requestGameFilterUpdate(QList<int>,QList<int>);
 
 protected:
     bool filterGames() const;
@@ -8,6 +8,7 @@
 #include "databaseinfo.h"
 #include "settings.h"
 #include "tags.h"
+#include "tagvaluelistmodel.h"
 
 #include <QCompleter>
 #include <QStringListModel>
@@ -23,7 +24,7 @@ PlayerListWidget::PlayerListWidget(QWidget *parent) :
 {
     setObjectName("PlayerListWidget");
     ui->setupUi(this);
-    m_filterModel = new QStringListModel(ui->tagList);
+    m_filterModel = new TagValueListModel(ui->tagList);
     ui->tagList->setModel(m_filterModel);
 
     setObjectName("PlayerListWidget");
@@ -77,12 +78,10 @@ void PlayerListWidget::selectionChangedSlot()
 
 void PlayerListWidget::findPlayers(const QString& s)
 {
-    QStringList newList = s.isEmpty() ? m_list : m_list.filter(s, Qt::CaseInsensitive);
-
-    m_filterModel->setStringList(newList);
-    if (newList.count()==1)
+    m_filterModel->setFilter(s);
+    if (m_filterModel->count()==1)
     {
-        selectPlayer(newList.at(0));
+        selectPlayer(m_filterModel->value(0));
     }
     else
     {
@@ -92,7 +91,7 @@ void PlayerListWidget::findPlayers(const QString& s)
 
 void PlayerListWidget::slotSelectPlayer(const QString& player)
 {
-    m_filterModel->setStringList(m_list);
+    m_filterModel->setFilter(QString());
     ui->filterEdit->clear();
     selectPlayer(player);
 }
@@ -131,16 +130,11 @@ void PlayerListWidget::selectPlayer(const QString& player)
     playerSelected(player);
     if(!player.isEmpty())
     {
-        const QStringList& list = m_filterModel->stringList();
-        int row = list.indexOf(player);
-        if(row >= 0)
+        QModelIndex index = m_filterModel->indexOf(player);
+        if(index.isValid())
         {
-            QModelIndex index = m_filterModel->index(row, 0);
-            if(index.isValid())
-            {
-                ui->tagList->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
-                ui->tagList->scrollTo(index);
-            }
+            ui->tagList->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
+            ui->tagList->scrollTo(index);
         }
     }
 }
@@ -218,14 +212,8 @@ void PlayerListWidget::setDatabase(DatabaseInfo* dbInfo)
     Database* db = dbInfo->database();
     ui->detailText->setText(tr("<html><i>No player chosen.</i></html>"));
     m_player.setDatabase(db);
-    m_list.clear();
-    if(db && db->index())
-    {
-        m_list = db->index()->playerNames();
-    }
-    m_list.sort();
+    m_filterModel->setIndex(db ? db->index() : nullptr, QStringList() << TagNameWhite << TagNameBlack);
     findPlayers(ui->filterEdit->text().simplified());
-    m_filterModel->sort(0);
 }
 
 void PlayerListWidget::slotLinkClicked(const QUrl& url)
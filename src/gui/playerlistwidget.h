@@ -6,7 +6,6 @@
 #define PLAYERLISTWIDGET_H
 
 #include <QWidget>
-#include <QStringListModel>
 #include "playerinfo.h"
 
 namespace Ui
@@ -15,6 +14,7 @@ class TagDetailWidget;
 }
 
 class DatabaseInfo;
+class TagValueListModel;
 
 class PlayerListWidget : public QWidget
 {
@@ -46,9 +46,8 @@ protected slots:
 
 private:
     PlayerInfo m_player;
-    QStringList m_list;
     Ui::TagDetailWidget *ui;
-    QStringListModel* m_filterModel;
+    TagValueListModel* m_filterModel;
 };
 
 #endif // PLAYERLISTWIDGET_H
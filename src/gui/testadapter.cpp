@@ -80,6 +80,7 @@ bool TestAdapter::dispatchTests()
         AppSettings->setValue("/General/automaticECO", true);
         AppSettings->setValue("/General/preserveECO", ek);
     }
+    AppSettings->updateSnapshot();
 
     if (!inputFile.isEmpty())
     {
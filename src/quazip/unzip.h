@@ -321,6 +321,13 @@ extern z_off_t ZEXPORT unztell OF((unzFile file));
   Give the current position in uncompressed data
 */
 
+extern uLong ZEXPORT unzGetCurrentFileZStreamPos OF((unzFile file));
+/*
+  Give the position in the zipfile of the compressed data not yet read of the
+  current file (opened by unzOpenCurrentFile), or 0 if no file is opened.
+  Right after opening this is the start of the compressed data.
+*/
+
 extern int ZEXPORT unzeof OF((unzFile file));
 /*
   return 1 if the end of file was reached, 0 elsewhere
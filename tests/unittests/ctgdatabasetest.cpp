@@ -0,0 +1,81 @@
+/**
+Unit tests for the CtgDatabase opening book.
+*/
+
+#include "ctgdatabasetest.h"
+
+#include <QTemporaryDir>
+
+#include "board.h"
+#include "ctgdatabase.h"
+#include "movedata.h"
+#include "pgndatabase.h"
+#include "settings.h"
+
+void CtgDatabaseTest::initTestCase()
+{
+    // required by PgnDatabase::open() to check if indexing is enabled
+    AppSettings = new Settings;
+}
+
+void CtgDatabaseTest::cleanupTestCase()
+{
+    delete AppSettings;
+    AppSettings = nullptr;
+}
+
+void CtgDatabaseTest::testCompileBook()
+{
+    QTemporaryDir tmpDir;
+    const QString pgn = tmpDir.path() + "/book.pgn";
+    QFile file(pgn);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("[White \"A\"]\n[Black \"B\"]\n[Result \"1-0\"]\n\n1. e4 e5 2. Nf3 1-0\n\n"
+               "[White \"C\"]\n[Black \"D\"]\n[Result \"0-1\"]\n\n1. e4 c5 0-1\n\n"
+               "[White \"E\"]\n[Black \"F\"]\n[Result \"1/2-1/2\"]\n\n1. d4 d5 1/2-1/2\n");
+    file.close();
+
+    PgnDatabase games(false);
+    QVERIFY(games.open(pgn, false));
+    QVERIFY(games.parseFile());
+
+    const QString name = tmpDir.path() + "/book.ctg";
+    {
+        CtgDatabase book;
+        QVERIFY(book.openForWriting(name, 20, 0, false));
+        volatile bool breakFlag = false;
+        book.book_make(games, breakFlag);
+    }
+    QVERIFY(QFile::exists(tmpDir.path() + "/book.cto"));
+    QVERIFY(QFile::exists(tmpDir.path() + "/book.ctb"));
+
+    CtgDatabase book;
+    QVERIFY(book.open(name, false));
+
+    // All moves of a position are read back, not only the first half of them
+    QMap<Move, MoveData> moves;
+    QCOMPARE(book.getMoveMapForBoard(BoardX::standardStartBoard, moves), 3u);
+    QMap<QString, MoveData> bySan;
+    for (const MoveData& md : moves)
+    {
+        bySan.insert(md.san, md);
+    }
+    QCOMPARE(bySan.keys(), QStringList() << "d4" << "e4");
+    QCOMPARE(int(bySan["e4"].results.count()), 2);
+    QCOMPARE(int(bySan["e4"].results.count(WhiteWin)), 1);
+    QCOMPARE(int(bySan["e4"].results.count(BlackWin)), 1);
+    QCOMPARE(int(bySan["d4"].results.count(Draw)), 1);
+
+    BoardX board(BoardX::standardStartBoard);
+    board.doMove(board.parseMove("e4"));
+    moves.clear();
+    bySan.clear();
+    QCOMPARE(book.getMoveMapForBoard(board, moves), 2u);
+    for (const MoveData& md : moves)
+    {
+        bySan.insert(md.san, md);
+    }
+    QCOMPARE(bySan.keys(), QStringList() << "c5" << "e5");
+    QCOMPARE(int(bySan["e5"].results.count(WhiteWin)), 1);
+    QCOMPARE(int(bySan["c5"].results.count(BlackWin)), 1);
+}
@@ -0,0 +1,20 @@
+/**
+Unit tests for the CtgDatabase opening book.
+*/
+
+#ifndef CTGDATABASETEST_H
+#define CTGDATABASETEST_H
+
+#include <QtTest>
+
+class CtgDatabaseTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void testCompileBook();
+};
+
+#endif
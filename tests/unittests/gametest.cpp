@@ -20,15 +20,25 @@ Unit tests for the Game class.
 
 #include <QtDebug>
 #include "gametest.h"
+#include "output.h"
+#include "settings.h"
 
 void GameTest::initTestCase()
 {
+    // required by Output for its options and templates
+    AppSettings = new Settings;
     m_game = new GameX;
     m_game->clear();
 }
 void GameTest::init() {}
 void GameTest::cleanup() {}
-void GameTest::cleanupTestCase() {}
+void GameTest::cleanupTestCase()
+{
+    delete m_game;
+    m_game = nullptr;
+    delete AppSettings;
+    AppSettings = nullptr;
+}
 
 void GameTest::testEmptyGame()
 {
@@ -389,3 +399,81 @@ void GameTest::testVariationManipulation()
     m_game->truncateVariation();
     m_game->moveToId(44);
 }
+
+void GameTest::testOutputFragmentCache()
+{
+    GameX game;
+    MoveId e4 = game.addMove("e4");
+    MoveId e5 = game.addMove("e5");
+    game.addMove("Nf3");
+    game.moveToId(e4);
+    MoveId c5 = game.addVariation("c5");
+    game.moveToId(c5);
+    game.addMove("Nf3");
+    game.moveToId(e5);
+    game.addVariation("Nc3");
+
+    Output cached(Output::NotationWidget);
+    cached.setFragmentCache(true);
+    Output plain(Output::NotationWidget);
+    QCOMPARE(cached.output(&game), plain.output(&game));
+    QCOMPARE(cached.fragmentHits(), 0);
+    QCOMPARE(cached.output(&game), plain.output(&game));
+    QCOMPARE(cached.fragmentHits(), 2);
+
+    // Only the changed variation is written again
+    QVERIFY(game.setAnnotation("Sicilian", c5, GameX::AfterMove));
+    QString text = cached.output(&game);
+    QCOMPARE(cached.fragmentHits(), 1);
+    QCOMPARE(text, plain.output(&game));
+    QVERIFY(text.contains("Sicilian"));
+}
+
+static void compareMaterial(GameX& game, const QList<double>& scores)
+{
+    game.moveToStart();
+    int ply = 0;
+    do
+    {
+        QVERIFY(ply < scores.count());
+        QCOMPARE(scores[ply], double(game.board().score()));
+        ++ply;
+    } while(game.forward());
+    QCOMPARE(ply, scores.count());
+}
+
+void GameTest::testScoreMaterialIncremental()
+{
+    GameX game;
+    // White promotes with capture, the en passant capture follows
+    game.dbSetStartingBoard("1r2k3/P7/8/8/5p2/8/4P3/4K3 w - - 0 1");
+    game.addMove("e4");
+    game.addMove("fxe3");
+    MoveId promotion = game.addMove("axb8=Q+");
+    game.addMove("Ke7");
+
+    QList<double> scores;
+    QVector<Move> line;
+    game.scoreMaterial(scores, line);
+    compareMaterial(game, scores);
+
+    QList<double> evaluations;
+    QStringList annotations;
+    game.scoreEvaluations(evaluations, annotations);
+    QCOMPARE(evaluations.count(), scores.count());
+
+    // Replace the end of the mainline
+    game.moveToId(promotion);
+    game.truncateVariation();
+    game.addMove("Kd7");
+    game.addMove("Qb5+");
+    game.scoreMaterial(scores, line);
+    compareMaterial(game, scores);
+
+    QVERIFY(game.setAnnotation("[%eval 1.5]", promotion, GameX::AfterMove));
+    game.scoreEvaluations(evaluations, annotations);
+    QList<double> expected;
+    game.scoreEvaluations(expected);
+    QCOMPARE(evaluations, expected);
+    QCOMPARE(evaluations.last(), 1.5);
+}
@@ -50,6 +50,8 @@ private slots:
     void testTags();
     void testCounters();
     void testVariationManipulation();
+    void testOutputFragmentCache();
+    void testScoreMaterialIncremental();
 
     void testTags_data();
     //void testName();
@@ -0,0 +1,147 @@
+/**
+Unit tests for the LichessOpening explorer client.
+*/
+
+#include "lichessopeningtest.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+
+#include "board.h"
+#include "lichessopening.h"
+
+static const QString StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+/** @return the FEN after @p move from the start position, as the client computes it when prefetching */
+static QString fenAfter(const char* move)
+{
+    BoardX board;
+    board.fromFen(StartFen);
+    board.doMove(board.parseMove(move));
+    return board.toFen();
+}
+
+void LichessOpeningTest::init()
+{
+    // Answer every request with a single move, as the explorer does
+    m_requests.clear();
+    m_server = new QTcpServer;
+    QVERIFY(m_server->listen(QHostAddress::LocalHost));
+    connect(m_server, &QTcpServer::newConnection, [this]()
+    {
+        while (QTcpSocket* socket = m_server->nextPendingConnection())
+        {
+            connect(socket, &QTcpSocket::readyRead, [this, socket]()
+            {
+                QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+                socket->setProperty("request", request);
+                if (!request.contains("\r\n\r\n"))
+                {
+                    return;
+                }
+                m_requests.append(QString::fromLatin1(request.split(' ').value(1)));
+                QByteArray body = "{\"white\":18,\"draw\":5,\"black\":3,\"moves\":[{\"uci\":\"e2e4\",\"white\":10,\"draw\":3,\"black\":2,\"averageRating\":2400},"
+                                  "{\"uci\":\"d2d4\",\"white\":8,\"draw\":2,\"black\":1,\"averageRating\":2410}]}";
+                socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nConnection: close\r\nContent-Length: "
+                              + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+                socket->disconnectFromHost();
+            });
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    });
+}
+
+void LichessOpeningTest::cleanup()
+{
+    delete m_server;
+    m_server = nullptr;
+}
+
+void LichessOpeningTest::testCache()
+{
+    QTemporaryDir dir;
+    QString url = QString("http://127.0.0.1:%1").arg(m_server->serverPort());
+    {
+        LichessOpening client;
+        client.setDb("masters");
+        client.setServer(QUrl(url));
+        client.setCacheDirectory(dir.path());
+        client.setPrefetchCount(0);
+
+        QVERIFY(client.cachedPosition(StartFen).isEmpty());
+        QSignalSpy spy(&client, SIGNAL(positionAvailable(QString)));
+        client.requestPosition(StartFen);
+        QVERIFY(spy.wait(5000));
+        QCOMPARE(spy.at(0).at(0).toString(), StartFen);
+        QCOMPARE(m_requests.count(), 1);
+        QVERIFY(m_requests.at(0).startsWith("/masters?fen="));
+        QVERIFY(client.cachedPosition(StartFen).contains("e2e4"));
+
+        // Cached positions are answered at once
+        client.requestPosition(StartFen);
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(m_requests.count(), 1);
+    }
+
+    // The disk cache survives the client
+    LichessOpening client;
+    client.setDb("masters");
+    client.setServer(QUrl(url));
+    client.setCacheDirectory(dir.path());
+    QVERIFY(client.cachedPosition(StartFen).contains("e2e4"));
+
+    // Other parameters are a different query
+    client.setDb("lichess");
+    QVERIFY(client.cachedPosition(StartFen).isEmpty());
+    QCOMPARE(m_requests.count(), 1);
+}
+
+void LichessOpeningTest::testCoalescing()
+{
+    QTemporaryDir dir;
+    LichessOpening client;
+    client.setDb("masters");
+    client.setServer(QUrl(QString("http://127.0.0.1:%1").arg(m_server->serverPort())));
+    client.setCacheDirectory(dir.path());
+    client.setPrefetchCount(0);
+
+    // Stepping quickly through positions only sends the last one
+    const QString e4Fen = fenAfter("e2e4");
+    const QString d4Fen = fenAfter("d2d4");
+    const QString c4Fen = fenAfter("c2c4");
+    QSignalSpy spy(&client, SIGNAL(positionAvailable(QString)));
+    client.requestPosition(e4Fen);
+    client.requestPosition(d4Fen);
+    client.requestPosition(c4Fen);
+    QVERIFY(spy.wait(5000));
+    QTest::qWait(300);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toString(), c4Fen);
+    QCOMPARE(m_requests.count(), 1);
+    QVERIFY(client.cachedPosition(e4Fen).isEmpty());
+}
+
+void LichessOpeningTest::testPrefetch()
+{
+    QTemporaryDir dir;
+    LichessOpening client;
+    client.setDb("masters");
+    client.setServer(QUrl(QString("http://127.0.0.1:%1").arg(m_server->serverPort())));
+    client.setCacheDirectory(dir.path());
+    client.setPrefetchCount(1);
+
+    // The position after the most played move is fetched in advance, but not further
+    const QString e4Fen = fenAfter("e2e4");
+    const QString d4Fen = fenAfter("d2d4");
+    QSignalSpy spy(&client, SIGNAL(positionAvailable(QString)));
+    client.requestPosition(StartFen);
+    QVERIFY(spy.wait(5000));
+    QVERIFY(spy.count() == 2 || spy.wait(5000));
+    QTest::qWait(300);
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).toString(), e4Fen);
+    QCOMPARE(m_requests.count(), 2);
+    QVERIFY(!client.cachedPosition(e4Fen).isEmpty());
+    QVERIFY(client.cachedPosition(d4Fen).isEmpty());
+}
@@ -0,0 +1,28 @@
+/**
+Unit tests for the LichessOpening explorer client, run against a local stand-in server.
+*/
+
+#ifndef LICHESSOPENINGTEST_H
+#define LICHESSOPENINGTEST_H
+
+#include <QtTest>
+
+class QTcpServer;
+
+class LichessOpeningTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void testCache();
+    void testCoalescing();
+    void testPrefetch();
+
+private:
+    QTcpServer* m_server = nullptr;
+    QStringList m_requests;
+};
+
+#endif
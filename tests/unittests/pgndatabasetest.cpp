@@ -19,17 +19,74 @@ Unit tests for the PgnDatabase class.
 */
 
 #include "pgndatabasetest.h"
+#include <QFileInfo>
 #include <QTemporaryDir>
 
 #include "resourcepath.h"
 
+#include "compressedfile.h"
+#include "JlCompress.h"
 #include "pgndatabase.h"
+#include "quagzipfile.h"
 #include "memorydatabase.h"
 #include "gamex.h"
 #include "filter.h"
+#include "output.h"
 #include "search.h"
 #include "settings.h"
 
+/** @return generated game number @p i, with a comment of @p commentLength random letters */
+static QString generatedGame(int i, int commentLength = 0)
+{
+    static const char* const moves[] = { "1. e4 e5 2. Nf3 Nc6", "1. d4 d5 2. c4", "1. c4 e5", "1. Nf3 d5 2. g3 Nf6 3. Bg2" };
+    QString comment;
+    if (commentLength)
+    {
+        // Random text, so that the data does not compress too well
+        quint32 seed = quint32(i) * 2654435761u + 1;
+        comment.reserve(commentLength + 3);
+        comment += " {";
+        for (int c = 0; c < commentLength; ++c)
+        {
+            seed = seed * 1103515245u + 12345u;
+            comment += QChar('a' + (seed >> 16) % 26);
+        }
+        comment += '}';
+    }
+    return QString("[Event \"Generated\"]\n[Round \"%1\"]\n[White \"White %1\"]\n[Black \"Black\"]\n[Result \"*\"]\n\n%2%3 *\n\n")
+           .arg(i).arg(moves[i % 4]).arg(comment);
+}
+
+/** @return the number of plies of generatedGame() @p i */
+static int generatedPlyCount(int i)
+{
+    static const int plies[] = { 4, 3, 2, 5 };
+    return plies[i % 4];
+}
+
+/** Write @p count generated games to @p device */
+static bool writeGeneratedGames(QIODevice& device, int count, int commentLength = 0)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        QByteArray game = generatedGame(i, commentLength).toLatin1();
+        if (device.write(game) != game.size())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Check that game @p i of @p db is generatedGame() @p expected */
+static bool isGeneratedGame(PgnDatabase& db, GameId i, int expected)
+{
+    GameX game;
+    return db.loadGame(i, game)
+           && game.tag(TagNameWhite) == QString("White %1").arg(expected)
+           && game.plyCount() == generatedPlyCount(expected);
+}
+
 void PgnDatabaseTest::initTestCase()
 {
     AppSettings = new Settings;
@@ -99,6 +156,312 @@ void PgnDatabaseTest::testCopyGameIntoNewDB()
     delete src;
 }
 
+void PgnDatabaseTest::testLoadMainline()
+{
+    PgnDatabase db(false);
+    QVERIFY(db.open(RESOURCE_PATH "game1.pgn", false));
+    QVERIFY(db.parseFile());
+
+    for (GameId i = 0; i < db.count(); ++i)
+    {
+        GameX full, mainline;
+        db.loadGameMoves(i, full);
+        QVERIFY(db.loadGameMainline(i, mainline));
+
+        QCOMPARE(mainline.plyCount(), full.plyCount());
+        QCOMPARE(mainline.variationCount(), 0);
+        full.moveToStart();
+        mainline.moveToStart();
+        while (full.forward())
+        {
+            QVERIFY(mainline.forward());
+            QCOMPARE(mainline.move(), full.move());
+        }
+        QVERIFY(mainline.atGameEnd());
+    }
+}
+
+void PgnDatabaseTest::testLoadMainlineSuffixes()
+{
+    QTemporaryDir tmpDir;
+    const QString name = tmpDir.path() + "/castling.pgn";
+    QFile file(name);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("[White \"A\"]\n[Black \"B\"]\n[Result \"*\"]\n\n"
+               "1. d4 d5 2. Nc3 Nf6 3. Bf4 e6 4. Qd2 Be7 5. O-O-O!? O-O+ 6 e3 c5 *\n\n"
+               "[White \"C\"]\n[Black \"D\"]\n[Result \"*\"]\n\n"
+               "1. e4 e5 2. Ke3 Nc6 *\n");
+    file.close();
+
+    PgnDatabase db(false);
+    QVERIFY(db.open(name, false));
+    QVERIFY(db.parseFile());
+
+    BoardX board(BoardX::standardStartBoard);
+    for (const char* san : { "d4", "d5", "Nc3", "Nf6", "Bf4", "e6", "Qd2", "Be7", "O-O-O", "O-O", "e3", "c5" })
+    {
+        Move move = board.parseMove(san);
+        QVERIFY(move.isLegal());
+        board.doMove(move);
+    }
+
+    // Suffixes and a move number without a dot do not cut the game short
+    GameX game;
+    QVERIFY(db.loadGameMainline(0, game));
+    QCOMPARE(game.plyCount(), 12);
+    game.moveToEnd();
+    QCOMPARE(game.toFen(), board.toFen());
+
+    // An illegal move is reported, the moves before it are kept
+    QVERIFY(!db.loadGameMainline(1, game));
+    QCOMPARE(game.plyCount(), 2);
+}
+
+void PgnDatabaseTest::testLoadCompressed()
+{
+    QTemporaryDir tmpDir;
+    const QString archive = tmpDir.path() + "/games.zip";
+    QVERIFY(JlCompress::compressFile(archive, RESOURCE_PATH "game10.pgn"));
+
+    QFile source(RESOURCE_PATH "game10.pgn");
+    QVERIFY(source.open(QIODevice::ReadOnly));
+    QuaGzipFile gzip(tmpDir.path() + "/games.pgn.gz");
+    QVERIFY(gzip.open(QIODevice::WriteOnly));
+    gzip.write(source.readAll());
+    gzip.close();
+
+    PgnDatabase plain(false);
+    QVERIFY(plain.open(RESOURCE_PATH "game10.pgn", false));
+    QVERIFY(plain.parseFile());
+
+    const QStringList names = { CompressedFile::memberName(archive, "game10.pgn"),
+                                tmpDir.path() + "/games.pgn.gz" };
+    for (const QString& name : names)
+    {
+        QVERIFY(CompressedFile::isCompressed(name));
+        PgnDatabase db(false);
+        QVERIFY(db.open(name, false));
+        QVERIFY(db.parseFile());
+        QCOMPARE(db.count(), plain.count());
+
+        // Backwards, so that each game seeks back into the compressed data
+        for (int i = int(db.count()) - 1; i >= 0; --i)
+        {
+            GameX expected, game;
+            QVERIFY(plain.loadGame(i, expected));
+            QVERIFY(db.loadGame(i, game));
+            QCOMPARE(game.plyCount(), expected.plyCount());
+            game.moveToEnd();
+            expected.moveToEnd();
+            QCOMPARE(game.toFen(), expected.toFen());
+        }
+    }
+}
+
+void PgnDatabaseTest::testLoadCompressedLarge()
+{
+    // Over 3 MB, so that the decoder remembers several access points
+    QTemporaryDir tmpDir;
+    const QString plainName = tmpDir.path() + "/large.pgn";
+    const int count = 3000;
+    QFile plainFile(plainName);
+    QVERIFY(plainFile.open(QIODevice::WriteOnly));
+    QVERIFY(writeGeneratedGames(plainFile, count, 1000));
+    plainFile.close();
+    QVERIFY(QFileInfo(plainName).size() > 3 * 1024 * 1024);
+
+    const QString archive = tmpDir.path() + "/large.zip";
+    QVERIFY(JlCompress::compressFile(archive, plainName));
+    QVERIFY(plainFile.open(QIODevice::ReadOnly));
+    QuaGzipFile gzip(tmpDir.path() + "/large.pgn.gz");
+    QVERIFY(gzip.open(QIODevice::WriteOnly));
+    gzip.write(plainFile.readAll());
+    gzip.close();
+
+    const QStringList names = { CompressedFile::memberName(archive, "large.pgn"),
+                                tmpDir.path() + "/large.pgn.gz" };
+    for (const QString& name : names)
+    {
+        {
+            PgnDatabase db(false);
+            QVERIFY(db.open(name, false));
+            QVERIFY(db.parseFile());
+            QCOMPARE(int(db.count()), count);
+
+            // Back from the end, each game is restored from the access point before it
+            for (int i = count - 1; i >= 0; i -= 250)
+            {
+                QVERIFY(isGeneratedGame(db, i, i));
+            }
+            QVERIFY(isGeneratedGame(db, 2999, 2999));
+            QVERIFY(isGeneratedGame(db, 1000, 1000));
+            QVERIFY(isGeneratedGame(db, 2500, 2500));
+        }
+
+        // Reopened with the index file, the first far seek builds the access points on the way
+        PgnDatabase db(false);
+        QVERIFY(db.open(name, false));
+        QVERIFY(db.parseFile());
+        QVERIFY(isGeneratedGame(db, 2800, 2800));
+        QVERIFY(isGeneratedGame(db, 1900, 1900));
+        QVERIFY(isGeneratedGame(db, 2799, 2799));
+        QVERIFY(isGeneratedGame(db, 5, 5));
+    }
+}
+
+void PgnDatabaseTest::testLoadCompressedBlocks()
+{
+    QTemporaryDir tmpDir;
+    const QString plainName = tmpDir.path() + "/blocks.pgn";
+    const QString name = tmpDir.path() + "/blocks.pgn.gz";
+    const int count = 250;
+
+    QFile plainFile(plainName);
+    QVERIFY(plainFile.open(QIODevice::WriteOnly));
+    QVERIFY(writeGeneratedGames(plainFile, count));
+    plainFile.close();
+
+    PgnDatabase plain(false);
+    QVERIFY(plain.open(plainName, false));
+    QVERIFY(plain.parseFile());
+    QCOMPARE(int(plain.count()), count);
+
+    // Output ends a gzip member after every 100 games
+    FilterX filter(&plain);
+    Output output(Output::Pgn);
+    output.output(name, filter);
+
+    // The trailer only tells the size of the last member
+    CompressedFile file(name);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    qint64 estimate = file.size();
+    QByteArray all = file.readAll();
+    QVERIFY(estimate <= all.size());
+    QCOMPARE(file.size(), qint64(all.size()));
+    QCOMPARE(file.blocks().count(), 3);
+    QCOMPARE(file.compressedPos(), file.compressedSize());
+    file.close();
+
+    // Once the blocks are known, the size is exact without decoding
+    CompressedFile reopened(name);
+    QVERIFY(reopened.open(QIODevice::ReadOnly));
+    reopened.setBlocks(file.blocks());
+    QCOMPARE(reopened.size(), qint64(all.size()));
+    reopened.close();
+
+    PgnDatabase db(false);
+    int maxProgress = 0;
+    connect(&db, &Database::progress, this, [&maxProgress](int percent)
+    {
+        maxProgress = qMax(maxProgress, percent);
+    });
+    QVERIFY(db.open(name, false));
+    QVERIFY(db.parseFile());
+    QCOMPARE(int(db.count()), count);
+    QCOMPARE(maxProgress, 100);
+
+    // Backwards, across the blocks, then a jump ahead into the last block
+    for (int i = count - 1; i >= 0; i -= 7)
+    {
+        QVERIFY(isGeneratedGame(db, i, i));
+    }
+    QVERIFY(isGeneratedGame(db, 0, 0));
+    QVERIFY(isGeneratedGame(db, 230, 230));
+    QVERIFY(isGeneratedGame(db, 99, 99));
+    QVERIFY(isGeneratedGame(db, 100, 100));
+}
+
+void PgnDatabaseTest::testFilterBitmap()
+{
+    PgnDatabase db(false);
+    QVERIFY(db.open(RESOURCE_PATH "game10.pgn", false));
+    QVERIFY(db.parseFile());
+
+    FilterX filter(&db);
+    QCOMPARE(filter.count(), static_cast<int>(db.count()));
+    filter.resize(130, true);
+    QCOMPARE(filter.count(), 130);
+    filter.set(3, 0);
+    filter.set(70, 25);
+    QVERIFY(!filter.contains(3));
+    QCOMPARE(filter.gamePosition(70), FilterX::value_type(25));
+    QCOMPARE(filter.gamePosition(71), FilterX::value_type(1));
+    QCOMPARE(filter.count(), 129);
+
+    FilterX other(filter);
+    other.invert();
+    QCOMPARE(other.count(), 1);
+    QVERIFY(other.contains(3));
+    QVERIFY(!other.contains(130));
+
+    other.unite(filter);
+    QCOMPARE(other.count(), 130);
+    QCOMPARE(other.gamePosition(70), FilterX::value_type(25));
+
+    other.set(100, 0);
+    filter.intersect(other);
+    QCOMPARE(filter.count(), 128);
+    QCOMPARE(filter.gamePosition(70), FilterX::value_type(25));
+
+    filter.subtract(other);
+    QCOMPARE(filter.count(), 0);
+    QCOMPARE(filter.gamePosition(70), FilterX::value_type(0));
+
+    other.resize(65);
+    QCOMPARE(other.count(), 65);
+    other.resize(200, false);
+    QCOMPARE(other.count(), 65);
+    QVERIFY(!other.contains(150));
+}
+
+void PgnDatabaseTest::testExportFilter()
+{
+    // More games than two export batches of 512, the last one partly filled
+    QTemporaryDir tmpDir;
+    const QString sourceName = tmpDir.path() + "/source.pgn";
+    const int count = 1300;
+    QFile source(sourceName);
+    QVERIFY(source.open(QIODevice::WriteOnly));
+    QVERIFY(writeGeneratedGames(source, count));
+    source.close();
+
+    PgnDatabase db(false);
+    QVERIFY(db.open(sourceName, false));
+    QVERIFY(db.parseFile());
+    QCOMPARE(int(db.count()), count);
+
+    FilterX filter(&db);
+    QVector<GameId> games;
+    for (GameId i = 0; i < db.count(); ++i)
+    {
+        if (i % 7 == 3)
+        {
+            filter.set(i, 0);
+        }
+        else
+        {
+            games.append(i);
+        }
+    }
+
+    // The compressed file is written in blocks
+    const QStringList names = { tmpDir.path() + "/export.pgn", tmpDir.path() + "/export.pgn.gz" };
+    for (const QString& name : names)
+    {
+        Output output(Output::Pgn);
+        output.output(name, filter);
+
+        PgnDatabase exported(false);
+        QVERIFY(exported.open(name, false));
+        QVERIFY(exported.parseFile());
+        QCOMPARE(int(exported.count()), games.count());
+        for (int i = 0; i < games.count(); ++i)
+        {
+            QVERIFY(isGeneratedGame(exported, i, int(games[i])));
+        }
+    }
+}
+
 // void PgnDatabaseTest::testExecuteSearch() {
 //     PgnDatabase* db = new PgnDatabase();
 //     db->open( QString( "./data/game1.pgn" ));
@@ -132,5 +495,3 @@ void PgnDatabaseTest::testCopyGameIntoNewDB()
 //     delete dbNew;
 //     delete db;
 // }
-
-
@@ -36,6 +36,13 @@ private slots:
     void testCreateDatabase();
     void testLoad();
     void testCopyGameIntoNewDB();
+    void testLoadMainline();
+    void testLoadMainlineSuffixes();
+    void testLoadCompressed();
+    void testLoadCompressedLarge();
+    void testLoadCompressedBlocks();
+    void testFilterBitmap();
+    void testExportFilter();
     //  void testExecuteSearch();
     //  void testSave();
 };
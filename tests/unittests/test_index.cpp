@@ -4,10 +4,15 @@
 
 #include "tags.h"
 #include "index.h"
+#include "crosstable.h"
+#include "gamestatistics.h"
 #include "pgndatabase.h"
+#include "tagvaluelistmodel.h"
 
 #include "settings.h"
 
+#include <QDataStream>
+
 TEST_CASE("testing Index class")
 {
     IndexX index;
@@ -62,6 +67,10 @@ TEST_CASE("testing Index class")
     CHECK_EQ(index.tagValue(TagNamePlyCount, 1) , QString("86"));
     CHECK_EQ(index.tagValue(TagNameSource, 1) , QString("Chessbase"));
 
+    // Deleting a game changes what views of the index show
+    quint32 revision = index.revision();
+    index.setDeleted(1, true);
+    CHECK_NE(index.revision(), revision);
 }
 
 TEST_CASE("testing Index read from PGN database")
@@ -97,3 +106,268 @@ TEST_CASE("testing Index read from PGN database")
 
     AppSettings = nullptr;
 }
+
+TEST_CASE("testing StringDictionary class")
+{
+    StringDictionary dictionary;
+    quint32 id = 0;
+    CHECK_FALSE(dictionary.find(u"Capablanca", id));
+
+    for (quint32 i = 0; i < 1000; ++i)
+    {
+        dictionary.insert(QString("Player %1").arg(i), i * 7);
+    }
+    CHECK_EQ(dictionary.count(), 1000);
+
+    QString line("[White \"Player 42\"]");
+    CHECK(dictionary.find(QStringView(line).mid(8, 9), id));
+    CHECK_EQ(id, 42u * 7);
+
+    dictionary.insert(u"Player 42", 1);
+    CHECK_EQ(dictionary.count(), 1000);
+    CHECK(dictionary.find(u"Player 42", id));
+    CHECK_EQ(id, 1u);
+
+    // Only the entry of the given id is removed
+    dictionary.remove(u"Player 42", 42u * 7);
+    CHECK(dictionary.find(u"Player 42", id));
+    dictionary.remove(u"Player 42", 1);
+    CHECK_FALSE(dictionary.find(u"Player 42", id));
+
+    // A prefix of a shared string is the key
+    QString colliding = QString("Player 42") + QChar(0) + "0";
+    dictionary.insert(colliding, 5000, 9);
+    CHECK(dictionary.find(u"Player 42", id));
+    CHECK_EQ(id, 5000u);
+    CHECK_FALSE(dictionary.find(colliding, id));
+    CHECK(dictionary.find(u"Player 43", id));
+    CHECK_EQ(id, 43u * 7);
+}
+
+TEST_CASE("testing TagValueListModel class")
+{
+    IndexX index;
+    const char* players[][2] = {
+        { "Carlsen", "Nakamura" },
+        { "anand", "Caruana" },
+        { "Nakamura", "Aronian" },
+    };
+    for (GameId i = 0; i < 3; ++i)
+    {
+        index.setTag(TagNameWhite, players[i][0], i);
+        index.setTag(TagNameBlack, players[i][1], i);
+    }
+
+    TagValueListModel model;
+    model.setIndex(&index, QStringList() << TagNameWhite << TagNameBlack);
+    REQUIRE_EQ(model.count(), 5);
+    CHECK_EQ(model.value(0), QString("anand"));
+    CHECK_EQ(model.value(1), QString("Aronian"));
+    CHECK_EQ(model.value(4), QString("Nakamura"));
+
+    // Values starting with the text are found by binary search
+    model.setFilter("ca");
+    REQUIRE_EQ(model.count(), 2);
+    CHECK_EQ(model.value(0), QString("Carlsen"));
+    CHECK_EQ(model.value(1), QString("Caruana"));
+    CHECK_FALSE(model.indexOf("anand").isValid());
+    CHECK_EQ(model.indexOf("Caruana").row(), 1);
+
+    model.setFilter("Nakamura");
+    REQUIRE_EQ(model.count(), 1);
+    CHECK_EQ(model.value(0), QString("Nakamura"));
+
+    // Only if no value starts with the text, values containing it match
+    model.setFilter("ru");
+    REQUIRE_EQ(model.count(), 1);
+    CHECK_EQ(model.value(0), QString("Caruana"));
+
+    model.setFilter("r");
+    REQUIRE_EQ(model.count(), 4);
+    CHECK_EQ(model.value(0), QString("Aronian"));
+    CHECK_EQ(model.value(3), QString("Nakamura"));
+    CHECK_EQ(model.indexOf("Nakamura").row(), 3);
+
+    model.setFilter("ura");
+    REQUIRE_EQ(model.count(), 1);
+    CHECK_EQ(model.value(0), QString("Nakamura"));
+
+    model.setFilter("xyz");
+    CHECK_EQ(model.count(), 0);
+
+    model.setFilter(QString());
+    CHECK_EQ(model.count(), 5);
+    CHECK_EQ(model.indexOf("Aronian").row(), 1);
+
+    // Changes of the index are picked up
+    index.setTag(TagNameWhite, "Giri", 0);
+    model.update();
+    REQUIRE_EQ(model.count(), 5);
+    CHECK_EQ(model.value(2), QString("Caruana"));
+    CHECK_EQ(model.value(3), QString("Giri"));
+    CHECK_EQ(model.indexOf("Giri").row(), 3);
+}
+
+TEST_CASE("testing GameStatistics class")
+{
+    IndexX index;
+    const char* games[][6] = {
+        // White, Black, Result, WhiteElo, Date, ECO
+        { "Alekhine", "Capablanca", "1-0", "2700", "1927.09.16", "D64" },
+        { "Capablanca", "Alekhine", "1/2-1/2", "2725", "1927.10.01", "D63" },
+        { "Alekhine", "Capablanca", "*", "", "????.??.??", "D64" },
+    };
+    for (GameId i = 0; i < 3; ++i)
+    {
+        index.setTag(TagNameWhite, games[i][0], i);
+        index.setTag(TagNameBlack, games[i][1], i);
+        index.setTag(TagNameResult, games[i][2], i);
+        index.setTag(TagNameWhiteElo, games[i][3], i);
+        index.setTag(TagNameDate, games[i][4], i);
+        index.setTag(TagNameECO, games[i][5], i);
+    }
+
+    GameStatistics statistics;
+    statistics.update(&index);
+
+    const QVector<GameId>& white = statistics.games(GameStatistics::WhitePlayer, index.getValueIndex("Alekhine"));
+    CHECK_EQ(white, QVector<GameId>() << 0 << 2);
+    CHECK(statistics.games(GameStatistics::WhitePlayer, index.getValueIndex("Euwe")).isEmpty());
+
+    int result[4] = { 0, 0, 0, 0 };
+    statistics.countResults(white, result);
+    CHECK_EQ(result[WhiteWin], 1);
+    CHECK_EQ(result[ResultUnknown], 1);
+    CHECK_EQ(statistics.whiteHalfPoints(1), 1);
+    CHECK_EQ(statistics.whiteHalfPoints(2), -1);
+
+    int rating[2] = { 99999, 0 };
+    statistics.ratingRange(QVector<GameId>() << 0 << 1 << 2, White, rating[0], rating[1]);
+    CHECK_EQ(rating[0], 2700);
+    CHECK_EQ(rating[1], 2725);
+
+    PartialDate date[2] = { PDMaxDate, PDMinDate };
+    statistics.dateRange(QVector<GameId>() << 0 << 1 << 2, date[0], date[1]);
+    CHECK(date[0] == PartialDate(1927, 9, 16));
+    CHECK(date[1] == PartialDate(1927, 10, 1));
+
+    // A modified index is read again
+    index.setTag(TagNameResult, "0-1", 2);
+    statistics.update(&index);
+    CHECK_EQ(statistics.result(2), BlackWin);
+    CHECK_EQ(statistics.games(GameStatistics::Opening, index.getValueIndex("D64")).count(), 2);
+}
+
+TEST_CASE("testing Index numeric columns")
+{
+    IndexX index;
+    const char* games[][4] = {
+        // WhiteElo, Date, Result, PlyCount
+        { "2700", "1927.09.16", "1-0", "81" },
+        { "2725", "1927.10.01", "1/2-1/2", "40" },
+        { "", "1927.??.??", "*", "" },
+    };
+    for (GameId i = 0; i < 3; ++i)
+    {
+        index.setTag(TagNameWhiteElo, games[i][0], i);
+        index.setTag(TagNameDate, games[i][1], i);
+        index.setTag(TagNameResult, games[i][2], i);
+        index.setTag(TagNamePlyCount, games[i][3], i);
+    }
+
+    CHECK_EQ(index.elo(1, White), 2725);
+    CHECK_EQ(index.elo(1, Black), 0);
+    CHECK(index.date(0) == PartialDate(1927, 9, 16));
+    CHECK_EQ(index.result(1), Draw);
+    CHECK_EQ(index.result(2), ResultUnknown);
+    CHECK_EQ(index.plyCount(0), 81);
+
+    QBitArray elo = index.listInRange(TagNameWhiteElo, 2710, 2800);
+    CHECK(!elo.at(0));
+    CHECK(elo.at(1));
+    CHECK(!elo.at(2));
+
+    QBitArray dates = index.listInDateRange(PartialDate(1927), PartialDate(1927, 9, 30));
+    CHECK(dates.at(0));
+    CHECK(!dates.at(1));
+    CHECK(dates.at(2));
+
+    // Modified and removed tags update the columns
+    index.setTag(TagNameResult, "0-1", 2);
+    CHECK_EQ(index.result(2), BlackWin);
+    index.removeTag(TagNamePlyCount, 0);
+    CHECK_EQ(index.plyCount(0), 0);
+
+    // The columns are written with the index
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        index.write(out);
+    }
+    IndexX copy;
+    QDataStream in(data);
+    volatile bool breakFlag = false;
+    CHECK(copy.read(in, &breakFlag, VERSION_INDEX_CURRENT));
+    CHECK_EQ(copy.eloColumn(White), index.eloColumn(White));
+    CHECK_EQ(copy.dateColumn(), index.dateColumn());
+    CHECK_EQ(copy.resultColumn(), index.resultColumn());
+    CHECK_EQ(copy.plyCount(1), 40);
+}
+
+TEST_CASE("testing Crosstables class")
+{
+    IndexX index;
+    const char* games[][5] = {
+        // Event, White, Black, Result, WhiteElo
+        { "Match", "Alekhine", "Capablanca", "1-0", "2700" },
+        { "Match", "Capablanca", "Alekhine", "1/2-1/2", "2725" },
+        { "Open", "Euwe", "Alekhine", "0-1", "2650" },
+        { "Open", "Alekhine", "Bogoljubov", "1-0", "2700" },
+        { "Open", "Bogoljubov", "Euwe", "1/2-1/2", "2600" },
+    };
+    for (GameId i = 0; i < 5; ++i)
+    {
+        index.setTag(TagNameEvent, games[i][0], i);
+        index.setTag(TagNameWhite, games[i][1], i);
+        index.setTag(TagNameBlack, games[i][2], i);
+        index.setTag(TagNameResult, games[i][3], i);
+        index.setTag(TagNameWhiteElo, games[i][4], i);
+    }
+
+    GameStatistics statistics;
+    statistics.update(&index);
+    Crosstables crosstables;
+    crosstables.update(&index, statistics);
+    CHECK_EQ(crosstables.built(), 2);
+
+    const Crosstable& open = crosstables.crosstable(index.getValueIndex("Open"));
+    REQUIRE_EQ(open.count(), 3);
+    CHECK_EQ(open.player(0).value, index.getValueIndex("Alekhine"));
+    CHECK_EQ(open.player(0).halfPoints, 4);
+    CHECK_EQ(open.player(0).buchholz, 2);
+    CHECK_EQ(open.player(0).sonnebornBerger, 4);
+    // Only the game against Euwe is rated
+    CHECK_EQ(open.player(0).performance, 2650 + 800);
+    // Bogoljubov and Euwe tie on points and tie-breaks and are ranked by name
+    CHECK_EQ(open.player(1).value, index.getValueIndex("Bogoljubov"));
+    CHECK_EQ(open.player(1).halfPoints, 1);
+    CHECK_EQ(open.player(1).buchholz, 5);
+    CHECK_EQ(open.player(1).rating, 2600);
+    CHECK_EQ(open.results(0, 1), QString("1"));
+    CHECK(open.results(1, 2) == QString(QChar(0x00BD)));
+    CHECK(open.results(1, 1).isEmpty());
+
+    const Crosstable& match = crosstables.crosstable(index.getValueIndex("Match"));
+    REQUIRE_EQ(match.count(), 2);
+    CHECK_EQ(match.player(0).value, index.getValueIndex("Alekhine"));
+    CHECK(match.results(0, 1) == QString("1") + QChar(0x00BD));
+    CHECK_EQ(Crosstable::formatPoints(3), QString("1") + QChar(0x00BD));
+
+    // Only the event of a replaced game is built again
+    index.setTag(TagNameResult, "0-1", 1);
+    statistics.update(&index);
+    crosstables.update(&index, statistics);
+    CHECK_EQ(crosstables.built(), 1);
+    CHECK_EQ(crosstables.crosstable(index.getValueIndex("Match")).player(0).halfPoints, 4);
+    CHECK(crosstables.crosstable(index.getValueIndex("Nowhere")).count() == 0);
+}
@@ -0,0 +1,107 @@
+#include "doctest.h"
+
+#include "board.h"
+#include "syzygyencoding.h"
+#include "syzygytablebase.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
+using namespace chessx;
+
+/** Write a KQvK WDL table storing the single value @p whiteToMove resp. @p blackToMove for all positions */
+static void writeSingleValueTable(const QString& fileName, int whiteToMove, int blackToMove)
+{
+    QByteArray data;
+    data.append("\xD7\x66\x0C\xA5", 4); // WDL magic
+    data.append(char(0));               // No pawns
+    data.append(char(0));               // The leading group is encoded first, for both sides
+    data.append("\x66\x55\xEE", 3);     // White king, white queen and black king, for both sides
+    data.append(char(0));               // Word alignment
+    data.append(char(0x80));            // Single value
+    data.append(char(whiteToMove + 2));
+    data.append(char(0x80));
+    data.append(char(blackToMove + 2));
+    data.append(QByteArray(16 - data.size(), 0)); // Files are 16 bytes plus a multiple of 64
+
+    QFile file(fileName);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    file.write(data);
+}
+
+static bool probeWdl(const SyzygyTablebase& tablebase, const char* fen, int& wdl)
+{
+    BoardX board;
+    REQUIRE(board.fromFen(fen));
+    return tablebase.probeWdl(board, wdl);
+}
+
+TEST_CASE("testing Syzygy encoding tables")
+{
+    const SyzygyEncoding& enc = SyzygyEncoding::instance();
+
+    CHECK_EQ(enc.binomial[0][0], 1u);
+    CHECK_EQ(enc.binomial[0][40], 1u);
+    CHECK_EQ(enc.binomial[2][5], 10u);
+    CHECK_EQ(enc.binomial[3][2], 0u);
+    CHECK_EQ(enc.binomial[5][63], 7028847u);
+
+    CHECK_EQ(enc.mapB1H1H7[b1], 0);
+    CHECK_EQ(enc.mapB1H1H7[h7], 27);
+
+    // Squares below the diagonal first, then the diagonal
+    CHECK_EQ(enc.mapA1D1D4[b1], 0);
+    CHECK_EQ(enc.mapA1D1D4[d3], 5);
+    CHECK_EQ(enc.mapA1D1D4[a1], 6);
+    CHECK_EQ(enc.mapA1D1D4[d4], 9);
+
+    int maxKK = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        maxKK = std::max(maxKK, *std::max_element(enc.mapKK[i], enc.mapKK[i] + 64));
+    }
+    CHECK_EQ(maxKK, 461);
+
+    CHECK_EQ(enc.mapPawns[a2], 47);
+    CHECK_EQ(enc.mapPawns[h2], 46);
+    CHECK_EQ(enc.mapPawns[d7], 1);
+    CHECK_EQ(enc.mapPawns[e7], 0);
+    CHECK_EQ(enc.leadPawnIdx[1][a3], 1);
+    CHECK_EQ(enc.leadPawnsSize[1][FILE_A], 6);
+}
+
+TEST_CASE("testing SyzygyTablebase probing")
+{
+    QTemporaryDir dir;
+    SyzygyTablebase tablebase;
+    tablebase.setPath(dir.path());
+    CHECK_EQ(tablebase.maxPieces(), 0);
+
+    // The side with the queen wins, the table does not know about the queen being taken
+    writeSingleValueTable(dir.path() + "/KQvK.rtbw", 2, -2);
+    // A file with a wrong magic
+    QFile broken(dir.path() + "/KRvK.rtbw");
+    REQUIRE(broken.open(QIODevice::WriteOnly));
+    broken.write(QByteArray(16, 0));
+    broken.close();
+
+    tablebase.setPath(dir.path());
+    CHECK_EQ(tablebase.maxPieces(), 3);
+
+    int wdl = 99;
+    CHECK(probeWdl(tablebase, "8/8/8/8/8/2k5/8/K6Q w - - 0 1", wdl));
+    CHECK_EQ(wdl, 2);
+    CHECK(probeWdl(tablebase, "8/8/8/8/8/2k5/8/K6Q b - - 0 1", wdl));
+    CHECK_EQ(wdl, -2);
+    // Capturing the queen leads to KvK
+    CHECK(probeWdl(tablebase, "8/8/8/8/8/8/1kQ5/7K b - - 0 1", wdl));
+    CHECK_EQ(wdl, 0);
+    // Colors are switched when Black has the queen
+    CHECK(probeWdl(tablebase, "k6q/8/2K5/8/8/8/8/8 w - - 0 1", wdl));
+    CHECK_EQ(wdl, -2);
+
+    CHECK(!probeWdl(tablebase, "8/8/8/8/8/2k5/8/K6R w - - 0 1", wdl));
+    CHECK(!probeWdl(tablebase, "8/8/8/8/8/2k5/8/K5RR w - - 0 1", wdl));
+}